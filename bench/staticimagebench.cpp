@@ -0,0 +1,635 @@
+/*
+ * Static Image Source - micro-benchmarks for decode, scale, convert and create
+ *
+ * Every case runs on a synthetic image at each size of the matrix, once to
+ * warm up and then until --min-time has elapsed, and is reported as ns per
+ * output pixel and frames per second. --output=csv or json prints one record
+ * per case so runs can be diffed when a kernel changes.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimageconvert.h"
+#include "gststaticimagedecode.h"
+#include "gststaticimagescale.h"
+#include "gststaticimagesrc.h"
+
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <jpeglib.h>
+#include <png.h>
+
+#define DEFAULT_SIZES "640x480,1280x720,1920x1080,3840x2160"
+#define DEFAULT_SCALE_FROM "1920x1080"
+
+typedef enum
+{
+    OUTPUT_TEXT,
+    OUTPUT_CSV,
+    OUTPUT_JSON
+} OutputMode;
+
+typedef struct
+{
+    gint width;
+    gint height;
+} BenchSize;
+
+typedef struct
+{
+    const gchar* bench;
+    gchar* variant;
+    gint width;
+    gint height;
+    guint64 iterations;
+    gdouble ns_per_frame;
+} BenchResult;
+
+typedef void (*BenchFunc)(gpointer user_data);
+
+static gchar* opt_sizes = NULL;
+static gchar* opt_scale_from = NULL;
+static gchar* opt_only = NULL;
+static gchar* opt_output = NULL;
+static gdouble opt_min_time = 0.5;
+static gint opt_threads = 0;
+static gint opt_create_frames = 500;
+
+static GOptionEntry option_entries[] = {
+    {"sizes", 's', 0, G_OPTION_ARG_STRING, &opt_sizes, "Comma-separated WxH list (default " DEFAULT_SIZES ")",
+     "SIZES"},
+    {"scale-from", 0, 0, G_OPTION_ARG_STRING, &opt_scale_from,
+     "Source size scaled to each of --sizes (default " DEFAULT_SCALE_FROM ")", "WxH"},
+    {"only", 0, 0, G_OPTION_ARG_STRING, &opt_only, "Comma-separated subset of decode,scale,swizzle,convert,create",
+     "BENCHES"},
+    {"output", 'o', 0, G_OPTION_ARG_STRING, &opt_output, "text (default), csv or json", "MODE"},
+    {"min-time", 't', 0, G_OPTION_ARG_DOUBLE, &opt_min_time, "Seconds each case is repeated for (default 0.5)",
+     "SECONDS"},
+    {"threads", 'j', 0, G_OPTION_ARG_INT, &opt_threads, "n-threads for the kernels, 0 = one per CPU (default 0)",
+     "N"},
+    {"create-frames", 0, 0, G_OPTION_ARG_INT, &opt_create_frames,
+     "Buffers pushed per create case (default 500)", "N"},
+    {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}};
+
+static gint64 now_ns(void)
+{
+    return (gint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static gboolean parse_size(const gchar* text, BenchSize* size)
+{
+    return sscanf(text, "%dx%d", &size->width, &size->height) == 2 && size->width > 0 && size->height > 0 &&
+           size->width <= 16384 && size->height <= 16384;
+}
+
+static GArray* parse_sizes(const gchar* text)
+{
+    GArray* sizes = g_array_new(FALSE, FALSE, sizeof(BenchSize));
+    gchar** items = g_strsplit(text, ",", -1);
+    for (gchar** item = items; *item != NULL; ++item)
+    {
+        BenchSize size;
+        if (!parse_size(g_strstrip(*item), &size))
+        {
+            g_printerr("Invalid size '%s'\n", *item);
+            g_array_unref(sizes);
+            g_strfreev(items);
+            return NULL;
+        }
+        g_array_append_val(sizes, size);
+    }
+    g_strfreev(items);
+    return sizes;
+}
+
+static gboolean bench_enabled(const gchar* bench)
+{
+    if (opt_only == NULL)
+    {
+        return TRUE;
+    }
+
+    gchar** names = g_strsplit(opt_only, ",", -1);
+    gboolean enabled = FALSE;
+    for (gchar** name = names; *name != NULL && !enabled; ++name)
+    {
+        enabled = g_strcmp0(g_strstrip(*name), bench) == 0;
+    }
+    g_strfreev(names);
+    return enabled;
+}
+
+/* One untimed warm-up run, then repeats until min-time has passed (and at least three runs) */
+static void run_case(GArray* results, const gchar* bench, const gchar* variant, gint width, gint height,
+                     BenchFunc func, gpointer user_data)
+{
+    func(user_data);
+
+    const gint64 budget = (gint64)(opt_min_time * 1e9);
+    guint64 iterations = 0;
+    const gint64 start = now_ns();
+    gint64 elapsed = 0;
+    do
+    {
+        func(user_data);
+        ++iterations;
+        elapsed = now_ns() - start;
+    } while (elapsed < budget || iterations < 3);
+
+    BenchResult result = {bench, g_strdup(variant), width, height, iterations, (gdouble)elapsed / iterations};
+    g_array_append_val(results, result);
+}
+
+/* Smooth gradients plus low-amplitude noise, so the encoders neither give up nor compress to nothing */
+static guint8* make_test_image(gint width, gint height)
+{
+    guint8* pixels = (guint8*)g_malloc((gsize)width * (gsize)height * 4);
+    guint32 seed = 0x9e3779b9u;
+    for (gint y = 0; y < height; ++y)
+    {
+        guint8* row = pixels + (gsize)y * (gsize)width * 4;
+        for (gint x = 0; x < width; ++x)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const guint noise = (seed >> 24) & 0x0f;
+            row[x * 4 + 0] = (guint8)(x * 255 / width);
+            row[x * 4 + 1] = (guint8)(y * 255 / height);
+            row[x * 4 + 2] = (guint8)(((x + y) & 0xff) ^ noise);
+            row[x * 4 + 3] = 255;
+        }
+    }
+    return pixels;
+}
+
+static gboolean write_png(const gchar* path, const guint8* pixels, gint width, gint height)
+{
+    FILE* fp = fopen(path, "wb");
+    if (!fp)
+    {
+        return FALSE;
+    }
+
+    png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop info_ptr = png_ptr != NULL ? png_create_info_struct(png_ptr) : NULL;
+    if (!info_ptr)
+    {
+        png_destroy_write_struct(&png_ptr, NULL);
+        fclose(fp);
+        return FALSE;
+    }
+
+    if (setjmp(png_jmpbuf(png_ptr)))
+    {
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        fclose(fp);
+        return FALSE;
+    }
+
+    png_init_io(png_ptr, fp);
+    png_set_IHDR(png_ptr, info_ptr, (png_uint_32)width, (png_uint_32)height, 8, PNG_COLOR_TYPE_RGBA,
+                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png_ptr, info_ptr);
+    for (gint y = 0; y < height; ++y)
+    {
+        png_write_row(png_ptr, (png_bytep)(pixels + (gsize)y * (gsize)width * 4));
+    }
+    png_write_end(png_ptr, NULL);
+
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+    return fclose(fp) == 0;
+}
+
+static gboolean write_jpeg(const gchar* path, const guint8* pixels, gint width, gint height)
+{
+    FILE* fp = fopen(path, "wb");
+    if (!fp)
+    {
+        return FALSE;
+    }
+
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    jpeg_stdio_dest(&cinfo, fp);
+
+    cinfo.image_width = (JDIMENSION)width;
+    cinfo.image_height = (JDIMENSION)height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 90, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+
+    guint8* rgb = (guint8*)g_malloc((gsize)width * 3);
+    while (cinfo.next_scanline < cinfo.image_height)
+    {
+        const guint8* src = pixels + (gsize)cinfo.next_scanline * (gsize)width * 4;
+        for (gint x = 0; x < width; ++x)
+        {
+            rgb[x * 3 + 0] = src[x * 4 + 0];
+            rgb[x * 3 + 1] = src[x * 4 + 1];
+            rgb[x * 3 + 2] = src[x * 4 + 2];
+        }
+        JSAMPROW row = rgb;
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    g_free(rgb);
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    return fclose(fp) == 0;
+}
+
+/* decode */
+
+typedef struct
+{
+    const gchar* path;
+    const gchar* jpeg_format; /* NULL for PNG */
+    gint min_width;           /* JPEG DCT scaling target, 0 for full size */
+    gint min_height;
+} DecodeCase;
+
+static void decode_once(gpointer user_data)
+{
+    DecodeCase* c = (DecodeCase*)user_data;
+    guint8* pixels = NULL;
+    gsize size = 0;
+    gint w = 0;
+    gint h = 0;
+
+    /* Mapped per iteration, like the element does */
+    GBytes* data = static_image_decode_map_file(c->path);
+    if (data == NULL)
+    {
+        return;
+    }
+    if (c->jpeg_format != NULL)
+    {
+        static_image_decode_jpeg_to_format(data, c->jpeg_format, FALSE, NULL, c->min_width, c->min_height, &pixels,
+                                           &size, &w, &h);
+    }
+    else
+    {
+        static_image_decode_png(data, &pixels, &w, &h);
+    }
+    g_bytes_unref(data);
+    g_free(pixels);
+}
+
+/* scale */
+
+typedef struct
+{
+    const guint8* src;
+    BenchSize src_size;
+    guint8* dst;
+    BenchSize dst_size;
+    StaticImageScaleMethod method;
+} ScaleCase;
+
+static void scale_once(gpointer user_data)
+{
+    ScaleCase* c = (ScaleCase*)user_data;
+    static_image_scale_rgba(c->src, c->src_size.width * 4, c->src_size.width, c->src_size.height, c->dst,
+                            c->dst_size.width * 4, c->dst_size.width, c->dst_size.height, c->method,
+                            (guint)opt_threads);
+}
+
+/* swizzle and convert */
+
+typedef struct
+{
+    const guint8* src;
+    guint8* dst;
+    gint width;
+    gint height;
+    const guint8* order; /* swizzle */
+    const gchar* format; /* convert */
+} ConvertCase;
+
+static void swizzle_once(gpointer user_data)
+{
+    ConvertCase* c = (ConvertCase*)user_data;
+    static_image_convert_swizzle(c->dst, c->width * 4, c->width, c->height, c->order, (guint)opt_threads);
+}
+
+static void convert_once(gpointer user_data)
+{
+    ConvertCase* c = (ConvertCase*)user_data;
+    StaticImageFrameLayout layout;
+    static_image_frame_layout_init(&layout, c->format, c->width, c->height);
+    static_image_convert_rgba_to_yuv(c->src, c->width * 4, c->format, &layout, c->dst, STATIC_IMAGE_MATRIX_BT601,
+                                     FALSE, (guint)opt_threads);
+}
+
+/* create: time between consecutive buffers reaching fakesink, i.e. the steady-state per-frame path */
+
+typedef struct
+{
+    gint64 first_ns;
+    gint64 last_ns;
+    guint64 count;
+} HandoffStats;
+
+static void on_handoff(GstElement* sink, GstBuffer* buffer, GstPad* pad, gpointer user_data)
+{
+    (void)sink;
+    (void)buffer;
+    (void)pad;
+    HandoffStats* stats = (HandoffStats*)user_data;
+    const gint64 now = now_ns();
+    if (stats->count == 0)
+    {
+        stats->first_ns = now;
+    }
+    stats->last_ns = now;
+    stats->count++;
+}
+
+static void run_create_case(GArray* results, const gchar* path, const gchar* format, gint width, gint height)
+{
+    gchar* description = g_strdup_printf("staticimagesrc location=\"%s\" num-buffers=%d n-threads=%d ! "
+                                         "video/x-raw,format=%s,width=%d,height=%d ! "
+                                         "fakesink name=sink sync=false signal-handoffs=true",
+                                         path, opt_create_frames, opt_threads, format, width, height);
+    GError* error = NULL;
+    GstElement* pipeline = gst_parse_launch(description, &error);
+    g_free(description);
+    if (pipeline == NULL)
+    {
+        g_printerr("create %s: %s\n", format, error != NULL ? error->message : "failed to build pipeline");
+        g_clear_error(&error);
+        return;
+    }
+    g_clear_error(&error);
+
+    HandoffStats stats = {0, 0, 0};
+    GstElement* sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    g_signal_connect(sink, "handoff", G_CALLBACK(on_handoff), &stats);
+    gst_object_unref(sink);
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    GstBus* bus = gst_element_get_bus(pipeline);
+    GstMessage* msg = gst_bus_timed_pop_filtered(bus, GST_CLOCK_TIME_NONE,
+                                                 (GstMessageType)(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+    if (msg != NULL && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR)
+    {
+        gst_message_parse_error(msg, &error, NULL);
+        g_printerr("create %s: %s\n", format, error->message);
+        g_clear_error(&error);
+        stats.count = 0;
+    }
+    if (msg != NULL)
+    {
+        gst_message_unref(msg);
+    }
+    gst_object_unref(bus);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+
+    /* The first buffer carries the one-time decode and conversion; only the gaps after it count */
+    if (stats.count > 1)
+    {
+        const guint64 iterations = stats.count - 1;
+        BenchResult result = {"create", g_strdup(format), width, height, iterations,
+                              (gdouble)(stats.last_ns - stats.first_ns) / iterations};
+        g_array_append_val(results, result);
+    }
+}
+
+/* output */
+
+static void print_results(GArray* results, OutputMode mode)
+{
+    const gchar* impl = static_image_convert_get_impl_name();
+
+    if (mode == OUTPUT_CSV)
+    {
+        g_print("bench,variant,width,height,iterations,ns_per_pixel,frames_per_sec,impl,threads\n");
+    }
+    else if (mode == OUTPUT_JSON)
+    {
+        g_print("{\n  \"impl\": \"%s\",\n  \"threads\": %d,\n  \"results\": [", impl, opt_threads);
+    }
+    else
+    {
+        g_print("# convert kernel: %s, n-threads: %d\n", impl, opt_threads);
+        g_print("%-8s %-9s %11s %10s %12s %12s\n", "bench", "variant", "size", "iters", "ns/pixel", "frames/s");
+    }
+
+    for (guint i = 0; i < results->len; ++i)
+    {
+        const BenchResult* r = &g_array_index(results, BenchResult, i);
+        const gdouble ns_per_pixel = r->ns_per_frame / ((gdouble)r->width * (gdouble)r->height);
+        const gdouble fps = r->ns_per_frame > 0 ? 1e9 / r->ns_per_frame : 0;
+
+        /* %g is locale-dependent; CSV and JSON need a '.' decimal point */
+        gchar npp[G_ASCII_DTOSTR_BUF_SIZE];
+        gchar rate[G_ASCII_DTOSTR_BUF_SIZE];
+        g_ascii_formatd(npp, sizeof(npp), "%.4f", ns_per_pixel);
+        g_ascii_formatd(rate, sizeof(rate), "%.2f", fps);
+
+        if (mode == OUTPUT_CSV)
+        {
+            g_print("%s,%s,%d,%d,%" G_GUINT64_FORMAT ",%s,%s,%s,%d\n", r->bench, r->variant, r->width, r->height,
+                    r->iterations, npp, rate, impl, opt_threads);
+        }
+        else if (mode == OUTPUT_JSON)
+        {
+            g_print("%s\n    {\"bench\": \"%s\", \"variant\": \"%s\", \"width\": %d, \"height\": %d, "
+                    "\"iterations\": %" G_GUINT64_FORMAT ", \"ns_per_pixel\": %s, \"frames_per_sec\": %s}",
+                    i > 0 ? "," : "", r->bench, r->variant, r->width, r->height, r->iterations, npp, rate);
+        }
+        else
+        {
+            gchar* size = g_strdup_printf("%dx%d", r->width, r->height);
+            g_print("%-8s %-9s %11s %10" G_GUINT64_FORMAT " %12.4f %12.2f\n", r->bench, r->variant, size,
+                    r->iterations, ns_per_pixel, fps);
+            g_free(size);
+        }
+    }
+
+    if (mode == OUTPUT_JSON)
+    {
+        g_print("\n  ]\n}\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    GOptionContext* context = g_option_context_new("- staticimagesrc micro-benchmarks");
+    g_option_context_add_main_entries(context, option_entries, NULL);
+    g_option_context_add_group(context, gst_init_get_option_group());
+    GError* error = NULL;
+    if (!g_option_context_parse(context, &argc, &argv, &error))
+    {
+        g_printerr("%s\n", error->message);
+        g_clear_error(&error);
+        g_option_context_free(context);
+        return 1;
+    }
+    g_option_context_free(context);
+
+    OutputMode mode = OUTPUT_TEXT;
+    if (g_strcmp0(opt_output, "csv") == 0)
+    {
+        mode = OUTPUT_CSV;
+    }
+    else if (g_strcmp0(opt_output, "json") == 0)
+    {
+        mode = OUTPUT_JSON;
+    }
+    else if (opt_output != NULL && g_strcmp0(opt_output, "text") != 0)
+    {
+        g_printerr("Unknown output mode '%s' (text, csv or json)\n", opt_output);
+        return 1;
+    }
+    if (opt_threads < 0 || opt_create_frames < 2 || opt_min_time < 0)
+    {
+        g_printerr("--threads must be >= 0, --create-frames >= 2 and --min-time >= 0\n");
+        return 1;
+    }
+
+    GArray* sizes = parse_sizes(opt_sizes != NULL ? opt_sizes : DEFAULT_SIZES);
+    BenchSize scale_from;
+    if (sizes == NULL || !parse_size(opt_scale_from != NULL ? opt_scale_from : DEFAULT_SCALE_FROM, &scale_from))
+    {
+        g_printerr("Sizes must look like 1920x1080\n");
+        return 1;
+    }
+
+    gst_element_register(NULL, "staticimagesrc", GST_RANK_NONE, GST_TYPE_STATICPNG_SRC);
+
+    gchar* tmp_dir = g_dir_make_tmp("staticimagebench-XXXXXX", &error);
+    if (tmp_dir == NULL)
+    {
+        g_printerr("%s\n", error->message);
+        g_clear_error(&error);
+        return 1;
+    }
+
+    GArray* results = g_array_new(FALSE, FALSE, sizeof(BenchResult));
+    static const gchar* const scale_methods[] = {"nearest", "bilinear", "bicubic", "lanczos"};
+    static const guint8 bgra_order[4] = {2, 1, 0, 3};
+    static const guint8 argb_order[4] = {3, 0, 1, 2};
+    static const guint8 abgr_order[4] = {3, 2, 1, 0};
+    static const gchar* const create_formats[] = {"RGBA", "BGRA", "ARGB", "ABGR", "NV12", "I420"};
+
+    guint8* scale_src = NULL;
+    if (bench_enabled("scale"))
+    {
+        scale_src = make_test_image(scale_from.width, scale_from.height);
+    }
+
+    for (guint i = 0; i < sizes->len; ++i)
+    {
+        const BenchSize size = g_array_index(sizes, BenchSize, i);
+        const gsize frame_size = (gsize)size.width * (gsize)size.height * 4;
+        guint8* image = make_test_image(size.width, size.height);
+        guint8* work = (guint8*)g_malloc(frame_size);
+
+        gchar* name = g_strdup_printf("%dx%d.png", size.width, size.height);
+        gchar* png_path = g_build_filename(tmp_dir, name, NULL);
+        g_free(name);
+        name = g_strdup_printf("%dx%d.jpg", size.width, size.height);
+        gchar* jpeg_path = g_build_filename(tmp_dir, name, NULL);
+        g_free(name);
+
+        const gboolean need_png = bench_enabled("decode") || bench_enabled("create");
+        if (need_png && !write_png(png_path, image, size.width, size.height))
+        {
+            g_printerr("Failed to write %s\n", png_path);
+        }
+
+        if (bench_enabled("decode"))
+        {
+            DecodeCase png_case = {png_path, NULL, 0, 0};
+            run_case(results, "decode", "png", size.width, size.height, decode_once, &png_case);
+
+            /* RGBA is the general path; I420 comes straight from the raw planes; 1/4 is DCT-domain scaling */
+            if (write_jpeg(jpeg_path, image, size.width, size.height))
+            {
+                DecodeCase jpeg_case = {jpeg_path, "RGBA", 0, 0};
+                run_case(results, "decode", "jpeg", size.width, size.height, decode_once, &jpeg_case);
+                DecodeCase jpeg_yuv_case = {jpeg_path, "I420", 0, 0};
+                run_case(results, "decode", "jpeg-I420", size.width, size.height, decode_once, &jpeg_yuv_case);
+                DecodeCase jpeg_quarter_case = {jpeg_path, "RGBA", size.width / 4, size.height / 4};
+                run_case(results, "decode", "jpeg-1/4", size.width, size.height, decode_once, &jpeg_quarter_case);
+            }
+            else
+            {
+                g_printerr("Failed to write %s\n", jpeg_path);
+            }
+        }
+
+        if (scale_src != NULL)
+        {
+            for (guint m = 0; m < G_N_ELEMENTS(scale_methods); ++m)
+            {
+                ScaleCase scale_case = {scale_src, scale_from, work, size, (StaticImageScaleMethod)m};
+                run_case(results, "scale", scale_methods[m], size.width, size.height, scale_once, &scale_case);
+            }
+        }
+
+        if (bench_enabled("swizzle"))
+        {
+            const guint8* orders[] = {bgra_order, argb_order, abgr_order};
+            const gchar* names[] = {"BGRA", "ARGB", "ABGR"};
+            memcpy(work, image, frame_size);
+            for (guint f = 0; f < G_N_ELEMENTS(orders); ++f)
+            {
+                ConvertCase swizzle_case = {image, work, size.width, size.height, orders[f], NULL};
+                run_case(results, "swizzle", names[f], size.width, size.height, swizzle_once, &swizzle_case);
+            }
+        }
+
+        if (bench_enabled("convert"))
+        {
+            /* 4:2:0 runs the SIMD kernels, the others the table-driven scalar one */
+            static const gchar* const yuv_formats[] = {"NV12", "I420", "YUY2", "Y444"};
+            for (guint f = 0; f < G_N_ELEMENTS(yuv_formats); ++f)
+            {
+                ConvertCase convert_case = {image, work, size.width, size.height, NULL, yuv_formats[f]};
+                run_case(results, "convert", yuv_formats[f], size.width, size.height, convert_once, &convert_case);
+            }
+        }
+
+        if (bench_enabled("create"))
+        {
+            for (guint f = 0; f < G_N_ELEMENTS(create_formats); ++f)
+            {
+                run_create_case(results, png_path, create_formats[f], size.width, size.height);
+            }
+        }
+
+        g_unlink(png_path);
+        g_unlink(jpeg_path);
+        g_free(png_path);
+        g_free(jpeg_path);
+        g_free(work);
+        g_free(image);
+    }
+
+    print_results(results, mode);
+
+    for (guint i = 0; i < results->len; ++i)
+    {
+        g_free(g_array_index(results, BenchResult, i).variant);
+    }
+    g_array_unref(results);
+    g_array_unref(sizes);
+    g_free(scale_src);
+    g_rmdir(tmp_dir);
+    g_free(tmp_dir);
+    return 0;
+}
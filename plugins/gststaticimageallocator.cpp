@@ -0,0 +1,294 @@
+/*
+ * Static Image Source - aligned, huge-page backed frame memory
+ *
+ * Frames are written once and then read by downstream on every buffer, so
+ * they are worth placing well: a large frame in 2 MiB pages needs a few dozen
+ * TLB entries instead of thousands of 4 KiB ones, and locking it keeps those
+ * reads from faulting under memory pressure. Blocks of a huge page or more are
+ * anonymous mappings aligned to one (MAP_HUGETLB, or MADV_HUGEPAGE for
+ * transparent huge pages); smaller ones come from the heap, aligned by hand.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimageallocator.h"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include <cstring>
+
+#define HUGE_PAGE_SIZE ((gsize)2 * 1024 * 1024)
+
+typedef struct
+{
+    GstMemory mem;
+    guint8* data;    /* start of the maxsize block */
+    gpointer base;   /* what to free or unmap; NULL in shared sub-memory */
+    gsize base_size; /* length of the mapping, 0 for heap blocks */
+    gboolean huge;
+    gboolean locked;
+} StaticImageMemory;
+
+struct _GstStaticImageAllocator
+{
+    GstAllocator parent;
+
+    StaticImageFrameMemory mode;
+    gboolean lock;
+};
+
+G_DEFINE_TYPE(GstStaticImageAllocator, gst_static_image_allocator, GST_TYPE_ALLOCATOR);
+
+static inline gsize round_up(gsize size, gsize to)
+{
+    return (size + to - 1) / to * to;
+}
+
+#ifdef HAVE_SYS_MMAN_H
+/* A huge-page aligned anonymous mapping of length bytes, or NULL */
+static guint8* map_huge(StaticImageFrameMemory mode, gsize length)
+{
+#ifdef MAP_HUGETLB
+    if (mode == STATIC_IMAGE_FRAME_MEMORY_HUGETLB)
+    {
+        void* p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED)
+        {
+            return (guint8*)p;
+        }
+        /* The hugetlb pool is empty or not configured; fall through to transparent huge pages */
+    }
+#else
+    (void)mode;
+#endif
+
+    /* Over-map by one huge page and trim both ends so the block starts on a huge page boundary */
+    void* p = mmap(NULL, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+    {
+        return NULL;
+    }
+    guint8* raw = (guint8*)p;
+    guint8* start = (guint8*)round_up((gsize)(guintptr)raw, HUGE_PAGE_SIZE);
+    if (start > raw)
+    {
+        munmap(raw, (gsize)(start - raw));
+    }
+    const gsize tail = (gsize)((raw + length + HUGE_PAGE_SIZE) - (start + length));
+    if (tail > 0)
+    {
+        munmap(start + length, tail);
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(start, length, MADV_HUGEPAGE);
+#endif
+    return start;
+}
+#endif
+
+static gboolean alloc_block(GstStaticImageAllocator* self, StaticImageMemory* mem, gsize size, gsize align)
+{
+#ifdef HAVE_SYS_MMAN_H
+    if (self->mode >= STATIC_IMAGE_FRAME_MEMORY_HUGEPAGES && size >= HUGE_PAGE_SIZE)
+    {
+        const gsize length = round_up(size, HUGE_PAGE_SIZE);
+        guint8* data = map_huge(self->mode, length);
+        if (data != NULL)
+        {
+            mem->data = data;
+            mem->base = data;
+            mem->base_size = length;
+            mem->huge = TRUE;
+            return TRUE;
+        }
+    }
+#endif
+
+    guint8* base = (guint8*)g_try_malloc(size + align);
+    if (base == NULL)
+    {
+        return FALSE;
+    }
+    mem->data = (guint8*)(((guintptr)base + align) & ~(guintptr)align);
+    mem->base = base;
+    mem->base_size = 0;
+    return TRUE;
+}
+
+static GstMemory* gst_static_image_allocator_alloc(GstAllocator* allocator, gsize size, GstAllocationParams* params)
+{
+    GstStaticImageAllocator* self = GST_STATIC_IMAGE_ALLOCATOR(allocator);
+
+    const gsize align = params->align | (STATIC_IMAGE_ALLOCATOR_ALIGN - 1);
+    const gsize maxsize = size + params->prefix + params->padding;
+    StaticImageMemory* mem = g_new0(StaticImageMemory, 1);
+    if (!alloc_block(self, mem, maxsize, align))
+    {
+        g_free(mem);
+        return NULL;
+    }
+    gst_memory_init(GST_MEMORY_CAST(mem), params->flags, allocator, NULL, maxsize, align, params->prefix, size);
+
+    if ((params->flags & GST_MEMORY_FLAG_ZERO_PREFIXED) && params->prefix > 0)
+    {
+        memset(mem->data, 0, params->prefix);
+    }
+    if ((params->flags & GST_MEMORY_FLAG_ZERO_PADDED) && params->padding > 0)
+    {
+        memset(mem->data + params->prefix + size, 0, params->padding);
+    }
+#ifdef HAVE_SYS_MMAN_H
+    mem->locked = self->lock && mlock(mem->data, maxsize) == 0;
+#endif
+    return GST_MEMORY_CAST(mem);
+}
+
+static void gst_static_image_allocator_free(GstAllocator* allocator, GstMemory* memory)
+{
+    StaticImageMemory* mem = (StaticImageMemory*)memory;
+    (void)allocator;
+
+    /* Shared sub-memory only borrows its parent's block */
+    if (mem->base != NULL)
+    {
+#ifdef HAVE_SYS_MMAN_H
+        if (mem->locked)
+        {
+            munlock(mem->data, memory->maxsize);
+        }
+        if (mem->base_size > 0)
+        {
+            munmap(mem->base, mem->base_size);
+        }
+        else
+#endif
+        {
+            g_free(mem->base);
+        }
+    }
+    g_free(mem);
+}
+
+static gpointer static_image_memory_map(GstMemory* memory, gsize maxsize, GstMapFlags flags)
+{
+    (void)maxsize;
+    (void)flags;
+    return ((StaticImageMemory*)memory)->data;
+}
+
+static void static_image_memory_unmap(GstMemory* memory)
+{
+    (void)memory;
+}
+
+static GstMemory* static_image_memory_share(GstMemory* memory, gssize offset, gssize size)
+{
+    StaticImageMemory* mem = (StaticImageMemory*)memory;
+    GstMemory* parent = memory->parent != NULL ? memory->parent : memory;
+    if (size == -1)
+    {
+        size = (gssize)memory->size - offset;
+    }
+
+    StaticImageMemory* sub = g_new0(StaticImageMemory, 1);
+    gst_memory_init(GST_MEMORY_CAST(sub),
+                    (GstMemoryFlags)(GST_MINI_OBJECT_FLAGS(parent) | GST_MINI_OBJECT_FLAG_LOCK_READONLY),
+                    memory->allocator, parent, memory->maxsize, memory->align, memory->offset + offset, (gsize)size);
+    sub->data = mem->data;
+    sub->huge = mem->huge;
+    sub->locked = mem->locked;
+    return GST_MEMORY_CAST(sub);
+}
+
+static void gst_static_image_allocator_class_init(GstStaticImageAllocatorClass* klass)
+{
+    GstAllocatorClass* allocator_class = GST_ALLOCATOR_CLASS(klass);
+
+    allocator_class->alloc = gst_static_image_allocator_alloc;
+    allocator_class->free = gst_static_image_allocator_free;
+}
+
+static void gst_static_image_allocator_init(GstStaticImageAllocator* self)
+{
+    GstAllocator* allocator = GST_ALLOCATOR_CAST(self);
+
+    allocator->mem_type = "StaticImageMemory";
+    allocator->mem_map = static_image_memory_map;
+    allocator->mem_unmap = static_image_memory_unmap;
+    allocator->mem_share = static_image_memory_share;
+    GST_OBJECT_FLAG_SET(self, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC);
+
+    self->mode = STATIC_IMAGE_FRAME_MEMORY_ALIGNED;
+    self->lock = FALSE;
+}
+
+GstAllocator* static_image_allocator_get(StaticImageFrameMemory mode, gboolean lock)
+{
+    static GMutex lock_mutex;
+    static GstAllocator* allocators[STATIC_IMAGE_FRAME_MEMORY_HUGETLB + 1][2];
+
+    if (mode == STATIC_IMAGE_FRAME_MEMORY_SYSTEM)
+    {
+        mode = STATIC_IMAGE_FRAME_MEMORY_ALIGNED;
+    }
+    g_return_val_if_fail(mode <= STATIC_IMAGE_FRAME_MEMORY_HUGETLB, NULL);
+
+    g_mutex_lock(&lock_mutex);
+    GstAllocator** slot = &allocators[mode][lock ? 1 : 0];
+    if (*slot == NULL)
+    {
+        GstStaticImageAllocator* allocator =
+            GST_STATIC_IMAGE_ALLOCATOR(g_object_new(GST_TYPE_STATIC_IMAGE_ALLOCATOR, NULL));
+        gst_object_ref_sink(allocator);
+        allocator->mode = mode;
+        allocator->lock = lock;
+        /* Kept for the life of the process, like the fd allocators */
+        GST_OBJECT_FLAG_SET(allocator, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+        *slot = GST_ALLOCATOR_CAST(allocator);
+    }
+    GstAllocator* allocator = *slot;
+    g_mutex_unlock(&lock_mutex);
+    return allocator;
+}
+
+GstMemory* static_image_allocator_copy(GstAllocator* allocator, GstMemory* memory)
+{
+    g_return_val_if_fail(GST_IS_STATIC_IMAGE_ALLOCATOR(allocator), NULL);
+
+    GstMapInfo src;
+    if (!gst_memory_map(memory, &src, GST_MAP_READ))
+    {
+        return NULL;
+    }
+
+    GstMemory* copy = gst_allocator_alloc(allocator, src.size, NULL);
+    GstMapInfo dst;
+    if (copy != NULL && gst_memory_map(copy, &dst, GST_MAP_WRITE))
+    {
+        memcpy(dst.data, src.data, src.size);
+        gst_memory_unmap(copy, &dst);
+        GST_MINI_OBJECT_FLAG_SET(copy, GST_MEMORY_FLAG_READONLY);
+    }
+    else if (copy != NULL)
+    {
+        gst_memory_unref(copy);
+        copy = NULL;
+    }
+    gst_memory_unmap(memory, &src);
+    return copy;
+}
+
+gboolean static_image_allocator_is_huge(GstMemory* memory)
+{
+    return memory != NULL && GST_IS_STATIC_IMAGE_ALLOCATOR(memory->allocator) && ((StaticImageMemory*)memory)->huge;
+}
+
+gboolean static_image_allocator_is_locked(GstMemory* memory)
+{
+    return memory != NULL && GST_IS_STATIC_IMAGE_ALLOCATOR(memory->allocator) &&
+           ((StaticImageMemory*)memory)->locked;
+}
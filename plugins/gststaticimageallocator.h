@@ -0,0 +1,45 @@
+/*
+ * Static Image Source - aligned, huge-page backed frame memory
+ */
+
+#ifndef __GST_STATIC_IMAGE_ALLOCATOR_H__
+#define __GST_STATIC_IMAGE_ALLOCATOR_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    STATIC_IMAGE_FRAME_MEMORY_SYSTEM,    /* plain g_malloc, not from this allocator */
+    STATIC_IMAGE_FRAME_MEMORY_ALIGNED,   /* STATIC_IMAGE_ALLOCATOR_ALIGN aligned, normal pages */
+    STATIC_IMAGE_FRAME_MEMORY_HUGEPAGES, /* frames of a huge page or more: aligned to one, MADV_HUGEPAGE */
+    STATIC_IMAGE_FRAME_MEMORY_HUGETLB    /* MAP_HUGETLB from the reserved pool, else as HUGEPAGES */
+} StaticImageFrameMemory;
+
+/* Minimum alignment of every block: a cache line, and the widest SIMD load (AVX-512) */
+#define STATIC_IMAGE_ALLOCATOR_ALIGN 64
+
+#define GST_TYPE_STATIC_IMAGE_ALLOCATOR (gst_static_image_allocator_get_type())
+
+G_DECLARE_FINAL_TYPE(GstStaticImageAllocator, gst_static_image_allocator, GST, STATIC_IMAGE_ALLOCATOR, GstAllocator)
+
+/*
+ * Returns the process-wide allocator for mode (SYSTEM is taken as ALIGNED),
+ * transfer none. With lock, blocks are mlock()ed so they are never paged out;
+ * when that fails (RLIMIT_MEMLOCK) the block is still handed out, unlocked.
+ */
+GstAllocator* static_image_allocator_get(StaticImageFrameMemory mode, gboolean lock);
+
+/* Copies memory into a new read-only block from allocator, or returns NULL */
+GstMemory* static_image_allocator_copy(GstAllocator* allocator, GstMemory* memory);
+
+/* TRUE if memory is from this allocator in a huge page mapping (hugetlb, or aligned and advised for THP) */
+gboolean static_image_allocator_is_huge(GstMemory* memory);
+
+/* TRUE if memory is from this allocator and mlock()ed */
+gboolean static_image_allocator_is_locked(GstMemory* memory);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_ALLOCATOR_H__ */
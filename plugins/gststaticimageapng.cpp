@@ -0,0 +1,420 @@
+/*
+ * Static Image Source - animated PNG (APNG) decoding and compositing
+ *
+ * libpng only reads the default image, so the APNG chunks are walked here:
+ * each frame's fdAT data is rewrapped as the IDAT of a standalone PNG (the
+ * original header chunks plus an IHDR with the frame's size) and decoded by
+ * the regular PNG decoder. The frames are then composited in order onto a
+ * canvas following their dispose and blend ops, and the canvas is handed to
+ * the caller after every frame.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimageapng.h"
+
+#include "gststaticimagedecode.h"
+
+#include <cstring>
+
+#define CHUNK_TYPE(a, b, c, d) (((guint32)(a) << 24) | ((guint32)(b) << 16) | ((guint32)(c) << 8) | (guint32)(d))
+#define CHUNK_IHDR CHUNK_TYPE('I', 'H', 'D', 'R')
+#define CHUNK_IDAT CHUNK_TYPE('I', 'D', 'A', 'T')
+#define CHUNK_IEND CHUNK_TYPE('I', 'E', 'N', 'D')
+#define CHUNK_ACTL CHUNK_TYPE('a', 'c', 'T', 'L')
+#define CHUNK_FCTL CHUNK_TYPE('f', 'c', 'T', 'L')
+#define CHUNK_FDAT CHUNK_TYPE('f', 'd', 'A', 'T')
+
+#define PNG_SIGNATURE_SIZE 8
+#define IHDR_SIZE 13
+#define FCTL_SIZE 26
+
+#define DISPOSE_OP_NONE 0
+#define DISPOSE_OP_BACKGROUND 1
+#define DISPOSE_OP_PREVIOUS 2
+#define BLEND_OP_SOURCE 0
+#define BLEND_OP_OVER 1
+
+typedef struct
+{
+    guint32 type;
+    const guint8* data;
+    guint32 length;
+    const guint8* raw; /* length, type, data and CRC as in the file */
+    gsize raw_size;
+} PngChunk;
+
+typedef struct
+{
+    guint32 width;
+    guint32 height;
+    guint32 x;
+    guint32 y;
+    guint delay_num;
+    guint delay_den;
+    guint8 dispose_op;
+    guint8 blend_op;
+} FrameControl;
+
+typedef struct
+{
+    const guint8* ihdr;
+    GByteArray* header_chunks; /* everything between IHDR and the image data, minus the APNG chunks */
+    gint width;
+    gint height;
+
+    guint8* canvas;
+    guint8* saved; /* canvas under the previous frame, for DISPOSE_OP_PREVIOUS */
+    gboolean have_previous;
+    FrameControl previous;
+
+    StaticImageApngFrameFunc frame_func;
+    gpointer user_data;
+    guint n_frames;
+} ApngDecoder;
+
+static guint32 read_u32(const guint8* p)
+{
+    return ((guint32)p[0] << 24) | ((guint32)p[1] << 16) | ((guint32)p[2] << 8) | (guint32)p[3];
+}
+
+static void write_u32(guint8* p, guint32 value)
+{
+    p[0] = (guint8)(value >> 24);
+    p[1] = (guint8)(value >> 16);
+    p[2] = (guint8)(value >> 8);
+    p[3] = (guint8)value;
+}
+
+static guint32 crc32_update(guint32 crc, const guint8* data, gsize size)
+{
+    static guint32 table[256];
+    static gsize table_ready = 0;
+    if (g_once_init_enter(&table_ready))
+    {
+        for (guint32 n = 0; n < 256; ++n)
+        {
+            guint32 c = n;
+            for (gint k = 0; k < 8; ++k)
+            {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        g_once_init_leave(&table_ready, 1);
+    }
+
+    for (gsize i = 0; i < size; ++i)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static void append_chunk(GByteArray* out, guint32 type, const guint8* data, guint32 length)
+{
+    guint8 head[8];
+    write_u32(head, length);
+    write_u32(head + 4, type);
+    guint32 crc = crc32_update(0xFFFFFFFFu, head + 4, 4);
+    crc = crc32_update(crc, data, length);
+    guint8 tail[4];
+    write_u32(tail, crc ^ 0xFFFFFFFFu);
+
+    g_byte_array_append(out, head, sizeof(head));
+    g_byte_array_append(out, data, length);
+    g_byte_array_append(out, tail, sizeof(tail));
+}
+
+/* Reads the chunk at *offset and moves past it; FALSE at the end of the data or on a truncated chunk */
+static gboolean next_chunk(const guint8* bytes, gsize size, gsize* offset, PngChunk* chunk)
+{
+    if (size - *offset < 12)
+    {
+        return FALSE;
+    }
+    const guint8* p = bytes + *offset;
+    const guint32 length = read_u32(p);
+    if (length > size - *offset - 12)
+    {
+        return FALSE;
+    }
+
+    chunk->type = read_u32(p + 4);
+    chunk->data = p + 8;
+    chunk->length = length;
+    chunk->raw = p;
+    chunk->raw_size = (gsize)length + 12;
+    *offset += chunk->raw_size;
+    return TRUE;
+}
+
+gboolean static_image_apng_is_animated(GBytes* data)
+{
+    if (!static_image_decode_is_png(data))
+    {
+        return FALSE;
+    }
+
+    gsize size = 0;
+    const guint8* bytes = (const guint8*)g_bytes_get_data(data, &size);
+    gsize offset = PNG_SIGNATURE_SIZE;
+    PngChunk chunk;
+    /* acTL must come before the first IDAT */
+    while (next_chunk(bytes, size, &offset, &chunk) && chunk.type != CHUNK_IDAT)
+    {
+        if (chunk.type == CHUNK_ACTL)
+        {
+            return chunk.length >= 8 && read_u32(chunk.data) > 0;
+        }
+    }
+    return FALSE;
+}
+
+static gboolean parse_frame_control(const PngChunk* chunk, gint canvas_w, gint canvas_h, FrameControl* fc)
+{
+    if (chunk->length < FCTL_SIZE)
+    {
+        return FALSE;
+    }
+    const guint8* p = chunk->data + 4; /* skip the sequence number */
+    fc->width = read_u32(p);
+    fc->height = read_u32(p + 4);
+    fc->x = read_u32(p + 8);
+    fc->y = read_u32(p + 12);
+    fc->delay_num = ((guint)p[16] << 8) | p[17];
+    fc->delay_den = ((guint)p[18] << 8) | p[19];
+    fc->dispose_op = p[20];
+    fc->blend_op = p[21];
+
+    /* A zero denominator means hundredths of a second */
+    if (fc->delay_den == 0)
+    {
+        fc->delay_den = 100;
+    }
+    return fc->width > 0 && fc->height > 0 && (guint64)fc->x + fc->width <= (guint64)canvas_w &&
+           (guint64)fc->y + fc->height <= (guint64)canvas_h && fc->dispose_op <= DISPOSE_OP_PREVIOUS &&
+           fc->blend_op <= BLEND_OP_OVER;
+}
+
+static void clear_region(ApngDecoder* dec, const FrameControl* fc)
+{
+    for (guint32 y = 0; y < fc->height; ++y)
+    {
+        guint8* row = dec->canvas + ((gsize)(fc->y + y) * dec->width + fc->x) * 4;
+        memset(row, 0, (gsize)fc->width * 4);
+    }
+}
+
+static void copy_region(guint8* dst, const guint8* src, gint stride_pixels, const FrameControl* fc)
+{
+    for (guint32 y = 0; y < fc->height; ++y)
+    {
+        const gsize at = ((gsize)(fc->y + y) * stride_pixels + fc->x) * 4;
+        memcpy(dst + at, src + at, (gsize)fc->width * 4);
+    }
+}
+
+/* Straight (non-premultiplied) alpha "over" of one pixel, as the APNG spec defines for APNG_BLEND_OP_OVER */
+static inline void blend_over(guint8* dst, const guint8* src)
+{
+    const guint32 src_a = src[3];
+    if (src_a == 255)
+    {
+        memcpy(dst, src, 4);
+        return;
+    }
+    if (src_a == 0)
+    {
+        return;
+    }
+
+    const guint32 dst_weight = dst[3] * (255 - src_a);
+    const guint32 total = src_a * 255 + dst_weight;
+    for (gint c = 0; c < 3; ++c)
+    {
+        dst[c] = (guint8)((src[c] * src_a * 255 + dst[c] * dst_weight + total / 2) / total);
+    }
+    dst[3] = (guint8)((total + 127) / 255);
+}
+
+static void render_frame(ApngDecoder* dec, const FrameControl* fc, const guint8* pixels)
+{
+    for (guint32 y = 0; y < fc->height; ++y)
+    {
+        guint8* dst = dec->canvas + ((gsize)(fc->y + y) * dec->width + fc->x) * 4;
+        const guint8* src = pixels + (gsize)y * fc->width * 4;
+        if (fc->blend_op == BLEND_OP_SOURCE)
+        {
+            memcpy(dst, src, (gsize)fc->width * 4);
+            continue;
+        }
+        for (guint32 x = 0; x < fc->width; ++x)
+        {
+            blend_over(dst + x * 4, src + x * 4);
+        }
+    }
+}
+
+/* Wraps the frame's image data in a standalone PNG, decodes it, composites it onto the canvas and passes that on */
+static gboolean finish_frame(ApngDecoder* dec, const FrameControl* fc, GByteArray* image_data)
+{
+    static const guint8 signature[PNG_SIGNATURE_SIZE] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+    guint8 ihdr[IHDR_SIZE];
+    memcpy(ihdr, dec->ihdr, IHDR_SIZE);
+    write_u32(ihdr, fc->width);
+    write_u32(ihdr + 4, fc->height);
+
+    GByteArray* png = g_byte_array_sized_new(image_data->len + dec->header_chunks->len + 64);
+    g_byte_array_append(png, signature, sizeof(signature));
+    append_chunk(png, CHUNK_IHDR, ihdr, IHDR_SIZE);
+    g_byte_array_append(png, dec->header_chunks->data, dec->header_chunks->len);
+    append_chunk(png, CHUNK_IDAT, image_data->data, image_data->len);
+    append_chunk(png, CHUNK_IEND, NULL, 0);
+
+    GBytes* bytes = g_byte_array_free_to_bytes(png);
+    guint8* pixels = NULL;
+    gint frame_w = 0;
+    gint frame_h = 0;
+    const gboolean decoded = static_image_decode_png(bytes, &pixels, &frame_w, &frame_h);
+    g_bytes_unref(bytes);
+    if (!decoded || (guint32)frame_w != fc->width || (guint32)frame_h != fc->height)
+    {
+        g_free(pixels);
+        return FALSE;
+    }
+
+    /* The previous frame's dispose op applies before this one is drawn */
+    if (dec->have_previous)
+    {
+        if (dec->previous.dispose_op == DISPOSE_OP_BACKGROUND)
+        {
+            clear_region(dec, &dec->previous);
+        }
+        else if (dec->previous.dispose_op == DISPOSE_OP_PREVIOUS)
+        {
+            copy_region(dec->canvas, dec->saved, dec->width, &dec->previous);
+        }
+    }
+
+    FrameControl current = *fc;
+    /* The first frame has nothing to go back to */
+    if (!dec->have_previous && current.dispose_op == DISPOSE_OP_PREVIOUS)
+    {
+        current.dispose_op = DISPOSE_OP_BACKGROUND;
+    }
+    if (current.dispose_op == DISPOSE_OP_PREVIOUS)
+    {
+        copy_region(dec->saved, dec->canvas, dec->width, &current);
+    }
+
+    render_frame(dec, &current, pixels);
+    g_free(pixels);
+
+    if (!dec->frame_func(dec->canvas, dec->width, dec->height, current.delay_num, current.delay_den, dec->user_data))
+    {
+        return FALSE;
+    }
+    dec->n_frames++;
+
+    dec->previous = current;
+    dec->have_previous = TRUE;
+    return TRUE;
+}
+
+gboolean static_image_apng_decode(GBytes* data, StaticImageApngFrameFunc frame_func, gpointer user_data,
+                                  guint* out_plays)
+{
+    if (!static_image_apng_is_animated(data))
+    {
+        return FALSE;
+    }
+
+    gsize size = 0;
+    const guint8* bytes = (const guint8*)g_bytes_get_data(data, &size);
+    gsize offset = PNG_SIGNATURE_SIZE;
+    PngChunk chunk;
+    if (!next_chunk(bytes, size, &offset, &chunk) || chunk.type != CHUNK_IHDR || chunk.length != IHDR_SIZE)
+    {
+        return FALSE;
+    }
+
+    ApngDecoder dec;
+    memset(&dec, 0, sizeof(dec));
+    dec.ihdr = chunk.data;
+    dec.width = (gint)MIN(read_u32(chunk.data), (guint32)G_MAXINT);
+    dec.height = (gint)MIN(read_u32(chunk.data + 4), (guint32)G_MAXINT);
+    const gsize canvas_size = (gsize)dec.width * (gsize)dec.height * 4;
+    dec.canvas = (guint8*)g_try_malloc0(canvas_size);
+    dec.saved = (guint8*)g_try_malloc0(canvas_size);
+    dec.header_chunks = g_byte_array_new();
+    dec.frame_func = frame_func;
+    dec.user_data = user_data;
+
+    guint plays = 0;
+    gboolean ok = dec.canvas != NULL && dec.saved != NULL && canvas_size > 0;
+    gboolean seen_image_data = FALSE;
+    gboolean in_frame = FALSE;
+    FrameControl fc;
+    memset(&fc, 0, sizeof(fc));
+    GByteArray* image_data = g_byte_array_new();
+
+    while (ok && next_chunk(bytes, size, &offset, &chunk) && chunk.type != CHUNK_IEND)
+    {
+        switch (chunk.type)
+        {
+            case CHUNK_ACTL:
+                plays = chunk.length >= 8 ? read_u32(chunk.data + 4) : 0;
+                break;
+            case CHUNK_FCTL:
+                if (in_frame && image_data->len > 0)
+                {
+                    ok = finish_frame(&dec, &fc, image_data);
+                    g_byte_array_set_size(image_data, 0);
+                }
+                in_frame = parse_frame_control(&chunk, dec.width, dec.height, &fc);
+                ok = ok && in_frame;
+                break;
+            case CHUNK_IDAT:
+                /* Without an fcTL before it the default image is not part of the animation */
+                seen_image_data = TRUE;
+                if (in_frame)
+                {
+                    g_byte_array_append(image_data, chunk.data, chunk.length);
+                }
+                break;
+            case CHUNK_FDAT:
+                seen_image_data = TRUE;
+                if (in_frame && chunk.length > 4)
+                {
+                    g_byte_array_append(image_data, chunk.data + 4, chunk.length - 4);
+                }
+                break;
+            default:
+                if (!seen_image_data)
+                {
+                    g_byte_array_append(dec.header_chunks, chunk.raw, (guint)chunk.raw_size);
+                }
+                break;
+        }
+    }
+    if (ok && in_frame && image_data->len > 0)
+    {
+        ok = finish_frame(&dec, &fc, image_data);
+    }
+
+    g_byte_array_unref(image_data);
+    g_byte_array_unref(dec.header_chunks);
+    g_free(dec.canvas);
+    g_free(dec.saved);
+
+    if (!ok || dec.n_frames == 0)
+    {
+        return FALSE;
+    }
+    *out_plays = plays;
+    return TRUE;
+}
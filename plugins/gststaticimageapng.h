@@ -0,0 +1,36 @@
+/*
+ * Static Image Source - animated PNG (APNG) decoding and compositing
+ */
+
+#ifndef __GST_STATIC_IMAGE_APNG_H__
+#define __GST_STATIC_IMAGE_APNG_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Receives one fully composited animation frame: the canvas as RGBA with
+ * stride = width * 4, valid only during the call, shown for delay_num /
+ * delay_den seconds. Returns FALSE to stop decoding.
+ */
+typedef gboolean (*StaticImageApngFrameFunc)(const guint8* canvas, gint width, gint height, guint delay_num,
+                                             guint delay_den, gpointer user_data);
+
+/* TRUE if data is a PNG with an acTL chunk, i.e. an APNG with more than a default image */
+gboolean static_image_apng_is_animated(GBytes* data);
+
+/*
+ * Decodes every animation frame and composites it onto the canvas (the IHDR
+ * size) with its dispose and blend ops, passing the canvas to frame_func after
+ * each frame, so each one is the complete picture shown at that point. Only
+ * the canvas and the copy DISPOSE_OP_PREVIOUS restores from are held, however
+ * long the animation. Returns the number of plays (0 = loop forever), or FALSE
+ * if the data is not a valid APNG, holds no frames or frame_func stopped it.
+ */
+gboolean static_image_apng_decode(GBytes* data, StaticImageApngFrameFunc frame_func, gpointer user_data,
+                                  guint* out_plays);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_APNG_H__ */
@@ -0,0 +1,125 @@
+/*
+ * Static Image Source - process-wide cache of decoded and converted frames
+ *
+ * Entries live while at least one element holds them; buffers already pushed
+ * keep their own memory refs, so dropping an entry never invalidates a frame
+ * in flight.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimagecache.h"
+
+#include <glib/gstdio.h>
+
+typedef struct
+{
+    GstMemory* memory; /* NULL while building */
+    guint users;
+} CacheEntry;
+
+static GMutex cache_lock;
+static GCond cache_cond;
+static GHashTable* cache_entries = NULL;
+
+static void cache_entry_free(gpointer data)
+{
+    CacheEntry* entry = (CacheEntry*)data;
+    if (entry->memory != NULL)
+    {
+        gst_memory_unref(entry->memory);
+    }
+    g_free(entry);
+}
+
+gchar* static_image_cache_make_key(const gchar* path, gint width, gint height, const gchar* format,
+                                   const gchar* variant)
+{
+    GStatBuf st;
+    if (path == NULL || g_stat(path, &st) != 0)
+    {
+        return NULL;
+    }
+
+    return g_strdup_printf("%s|%" G_GINT64_FORMAT "|%" G_GINT64_FORMAT "|%" G_GUINT64_FORMAT "|%dx%d|%s|%s", path,
+                           (gint64)st.st_mtime, (gint64)st.st_size, (guint64)st.st_ino, width, height, format,
+                           variant != NULL ? variant : "");
+}
+
+gchar* static_image_cache_make_data_key(GBytes* data, gint width, gint height, const gchar* format,
+                                        const gchar* variant)
+{
+    g_return_val_if_fail(data != NULL, NULL);
+
+    gchar* checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, data);
+    gchar* key = g_strdup_printf("data:%s|%" G_GSIZE_FORMAT "|%dx%d|%s|%s", checksum, g_bytes_get_size(data), width,
+                                 height, format, variant != NULL ? variant : "");
+    g_free(checksum);
+    return key;
+}
+
+GstMemory* static_image_cache_acquire(const gchar* key, StaticImageCacheBuildFunc build_func, gpointer user_data)
+{
+    g_return_val_if_fail(key != NULL && build_func != NULL, NULL);
+
+    g_mutex_lock(&cache_lock);
+    if (cache_entries == NULL)
+    {
+        cache_entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, cache_entry_free);
+    }
+
+    for (;;)
+    {
+        CacheEntry* entry = (CacheEntry*)g_hash_table_lookup(cache_entries, key);
+        if (entry == NULL)
+        {
+            break;
+        }
+        if (entry->memory != NULL)
+        {
+            entry->users++;
+            GstMemory* memory = gst_memory_ref(entry->memory);
+            g_mutex_unlock(&cache_lock);
+            return memory;
+        }
+        /* Another instance is building it; a failed build removes the entry and we try ourselves */
+        g_cond_wait(&cache_cond, &cache_lock);
+    }
+
+    CacheEntry* entry = g_new0(CacheEntry, 1);
+    entry->users = 1;
+    g_hash_table_insert(cache_entries, g_strdup(key), entry);
+    g_mutex_unlock(&cache_lock);
+
+    GstMemory* memory = build_func(user_data);
+
+    g_mutex_lock(&cache_lock);
+    if (memory == NULL)
+    {
+        g_hash_table_remove(cache_entries, key);
+    }
+    else
+    {
+        GST_MINI_OBJECT_FLAG_SET(memory, GST_MEMORY_FLAG_READONLY);
+        entry->memory = gst_memory_ref(memory);
+    }
+    g_cond_broadcast(&cache_cond);
+    g_mutex_unlock(&cache_lock);
+
+    return memory;
+}
+
+void static_image_cache_release(const gchar* key)
+{
+    g_return_if_fail(key != NULL);
+
+    g_mutex_lock(&cache_lock);
+    CacheEntry* entry = cache_entries != NULL ? (CacheEntry*)g_hash_table_lookup(cache_entries, key) : NULL;
+    if (entry != NULL && entry->memory != NULL && --entry->users == 0)
+    {
+        g_hash_table_remove(cache_entries, key);
+    }
+    g_mutex_unlock(&cache_lock);
+}
@@ -0,0 +1,40 @@
+/*
+ * Static Image Source - process-wide cache of decoded and converted frames
+ */
+
+#ifndef __GST_STATIC_IMAGE_CACHE_H__
+#define __GST_STATIC_IMAGE_CACHE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Produces the memory for a cache miss; returns NULL on failure */
+typedef GstMemory* (*StaticImageCacheBuildFunc)(gpointer user_data);
+
+/*
+ * Builds the key for a frame derived from the file at path. The file's mtime,
+ * size and inode are part of the key, so a replaced file never hits a stale
+ * entry. variant carries every other setting the frame depends on. Returns
+ * NULL if the file cannot be stat'ed (the caller then bypasses the cache).
+ */
+gchar* static_image_cache_make_key(const gchar* path, gint width, gint height, const gchar* format,
+                                   const gchar* variant);
+
+/* As above for an image held in memory, keyed by a checksum of its bytes */
+gchar* static_image_cache_make_data_key(GBytes* data, gint width, gint height, const gchar* format,
+                                        const gchar* variant);
+
+/*
+ * Returns a new ref to the memory cached under key, calling build_func on a
+ * miss. Concurrent callers for the same key wait for the first build instead
+ * of repeating it. Cached memory is marked read-only. Each successful acquire
+ * holds the entry alive until the matching static_image_cache_release().
+ */
+GstMemory* static_image_cache_acquire(const gchar* key, StaticImageCacheBuildFunc build_func, gpointer user_data);
+
+void static_image_cache_release(const gchar* key);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_CACHE_H__ */
@@ -0,0 +1,794 @@
+/*
+ * Static Image Source - RGBA to YUV conversion kernels
+ *
+ * The scalar kernel defines the output. The SSE4.1, AVX2 and NEON kernels use
+ * the same fixed-point arithmetic (including the per-pixel chroma rounding that
+ * happens before the 2x2 average), so the selected path never changes a frame.
+ * Formats other than 4:2:0 are converted by one scalar kernel that reads
+ * subsampling and sample positions from a table, again with the same
+ * arithmetic.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimageconvert.h"
+
+#include "gststaticimagecpu.h"
+#include "gststaticimageparallel.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STATIC_IMAGE_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#define STATIC_IMAGE_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Fixed-point RGB->YUV coefficients with 8 fractional bits */
+typedef struct
+{
+    gint16 y[3];
+    gint16 u[3];
+    gint16 v[3];
+    gint16 y_offset;
+} YuvCoeffs;
+
+/*
+ * Indexed by StaticImageMatrix, then limited/full range. Limited range scales
+ * luma to 16-235 and chroma to 16-240. Rounding is corrected on the green
+ * term so luma rows sum to the range's white and chroma rows to zero (grey
+ * stays exactly neutral).
+ */
+static const YuvCoeffs yuv_coeffs[3][2] = {
+    /* BT.601 */
+    {{{66, 129, 25}, {-38, -74, 112}, {112, -94, -18}, 16}, {{77, 150, 29}, {-43, -85, 128}, {128, -107, -21}, 0}},
+    /* BT.709 */
+    {{{47, 157, 16}, {-26, -86, 112}, {112, -102, -10}, 16}, {{54, 184, 18}, {-29, -99, 128}, {128, -116, -12}, 0}},
+    /* BT.2020 (non-constant luminance) */
+    {{{58, 149, 13}, {-31, -81, 112}, {112, -103, -9}, 16}, {{67, 174, 15}, {-36, -92, 128}, {128, -118, -10}, 0}},
+};
+
+static const YuvCoeffs* get_coeffs(StaticImageMatrix matrix, gboolean full_range)
+{
+    const gint m = CLAMP((gint)matrix, (gint)STATIC_IMAGE_MATRIX_BT601, (gint)STATIC_IMAGE_MATRIX_BT2020);
+    return &yuv_coeffs[m][full_range ? 1 : 0];
+}
+
+/* Converts one pair of source rows; s1 == s0 and y1 == NULL for the last row of an odd height */
+typedef void (*Yuv420RowFunc)(const guint8* s0, const guint8* s1, gint width, guint8* y0, guint8* y1, guint8* u,
+                              guint8* v, gint uv_step, const YuvCoeffs* c);
+
+static inline guint8 luma_scalar(const YuvCoeffs* c, const guint8* p)
+{
+    gint yv = (c->y[0] * p[0] + c->y[1] * p[1] + c->y[2] * p[2] + 128) >> 8;
+    return (guint8)CLAMP(yv + c->y_offset, 0, 255);
+}
+
+static inline gint chroma_scalar(const gint16* k, const guint8* p)
+{
+    return (k[0] * p[0] + k[1] * p[1] + k[2] * p[2] + 128) >> 8;
+}
+
+static inline guint8 chroma_average(gint sum, gint count)
+{
+    gint value = sum / count + 128;
+    return (guint8)CLAMP(value, 0, 255);
+}
+
+/* Reference kernel; the SIMD kernels call it for the columns left after their last full block */
+static void yuv420_row_scalar_from(gint x_start, const guint8* s0, const guint8* s1, gint width, guint8* y0,
+                                   guint8* y1, guint8* u, guint8* v, gint uv_step, const YuvCoeffs* c)
+{
+    for (gint x = x_start; x < width; x += 2)
+    {
+        const gint x1 = (x + 1 < width) ? x + 1 : x;
+        const guint8* p0 = s0 + (gsize)x * 4;
+        const guint8* p1 = s0 + (gsize)x1 * 4;
+        const guint8* p2 = s1 + (gsize)x * 4;
+        const guint8* p3 = s1 + (gsize)x1 * 4;
+
+        y0[x] = luma_scalar(c, p0);
+        if (x1 != x)
+        {
+            y0[x1] = luma_scalar(c, p1);
+        }
+        if (y1 != NULL)
+        {
+            y1[x] = luma_scalar(c, p2);
+            if (x1 != x)
+            {
+                y1[x1] = luma_scalar(c, p3);
+            }
+        }
+
+        gint u_sum = chroma_scalar(c->u, p0) + chroma_scalar(c->u, p1) + chroma_scalar(c->u, p2) +
+                     chroma_scalar(c->u, p3);
+        gint v_sum = chroma_scalar(c->v, p0) + chroma_scalar(c->v, p1) + chroma_scalar(c->v, p2) +
+                     chroma_scalar(c->v, p3);
+
+        const gsize ci = (gsize)(x / 2) * (gsize)uv_step;
+        u[ci] = chroma_average(u_sum, 4);
+        v[ci] = chroma_average(v_sum, 4);
+    }
+}
+
+static void yuv420_row_scalar(const guint8* s0, const guint8* s1, gint width, guint8* y0, guint8* y1, guint8* u,
+                              guint8* v, gint uv_step, const YuvCoeffs* c)
+{
+    yuv420_row_scalar_from(0, s0, s1, width, y0, y1, u, v, uv_step, c);
+}
+
+#ifdef STATIC_IMAGE_HAVE_X86_SIMD
+
+/* Coefficients laid out for _mm_madd_epi16 over interleaved (R,G) and (B,1) lanes */
+static inline gint32 pack_coeff_pair(gint16 lo, gint16 hi)
+{
+    return (gint32)(((guint32)(guint16)hi << 16) | (guint32)(guint16)lo);
+}
+
+typedef struct
+{
+    __m128i y_rg, y_b1, u_rg, u_b1, v_rg, v_b1;
+} Sse41Coeffs;
+
+TARGET_SSE41 static inline void sse41_load_coeffs(const YuvCoeffs* c, Sse41Coeffs* k)
+{
+    k->y_rg = _mm_set1_epi32(pack_coeff_pair(c->y[0], c->y[1]));
+    k->y_b1 = _mm_set1_epi32(pack_coeff_pair(c->y[2], 128));
+    k->u_rg = _mm_set1_epi32(pack_coeff_pair(c->u[0], c->u[1]));
+    k->u_b1 = _mm_set1_epi32(pack_coeff_pair(c->u[2], 128));
+    k->v_rg = _mm_set1_epi32(pack_coeff_pair(c->v[0], c->v[1]));
+    k->v_b1 = _mm_set1_epi32(pack_coeff_pair(c->v[2], 128));
+}
+
+/* (k . rgb + 128) >> 8 for 8 pixels, given the interleaved operands for pixels 0-3 and 4-7 */
+TARGET_SSE41 static inline __m128i sse41_dot8(__m128i rg_lo, __m128i rg_hi, __m128i b1_lo, __m128i b1_hi,
+                                              __m128i k_rg, __m128i k_b1)
+{
+    __m128i lo = _mm_add_epi32(_mm_madd_epi16(rg_lo, k_rg), _mm_madd_epi16(b1_lo, k_b1));
+    __m128i hi = _mm_add_epi32(_mm_madd_epi16(rg_hi, k_rg), _mm_madd_epi16(b1_hi, k_b1));
+    return _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+}
+
+/* 8 RGBA pixels -> unbiased luma and per-pixel chroma as int16 */
+TARGET_SSE41 static inline void sse41_rgba8(const guint8* p, const Sse41Coeffs* k, __m128i* y, __m128i* u,
+                                            __m128i* v)
+{
+    const __m128i shuf = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    const __m128i one = _mm_set1_epi16(1);
+
+    __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)p), shuf);
+    __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 16)), shuf);
+    __m128i rg = _mm_unpacklo_epi32(a, b); /* R0-7 G0-7 */
+    __m128i ba = _mm_unpackhi_epi32(a, b); /* B0-7 A0-7 */
+
+    __m128i r16 = _mm_cvtepu8_epi16(rg);
+    __m128i g16 = _mm_cvtepu8_epi16(_mm_srli_si128(rg, 8));
+    __m128i b16 = _mm_cvtepu8_epi16(ba);
+
+    __m128i rg_lo = _mm_unpacklo_epi16(r16, g16);
+    __m128i rg_hi = _mm_unpackhi_epi16(r16, g16);
+    __m128i b1_lo = _mm_unpacklo_epi16(b16, one);
+    __m128i b1_hi = _mm_unpackhi_epi16(b16, one);
+
+    *y = sse41_dot8(rg_lo, rg_hi, b1_lo, b1_hi, k->y_rg, k->y_b1);
+    *u = sse41_dot8(rg_lo, rg_hi, b1_lo, b1_hi, k->u_rg, k->u_b1);
+    *v = sse41_dot8(rg_lo, rg_hi, b1_lo, b1_hi, k->v_rg, k->v_b1);
+}
+
+/* 8 sums of four per-pixel chroma values -> C division by 4, re-biased and stored */
+TARGET_SSE41 static inline void sse41_store_chroma(__m128i u_sum, __m128i v_sum, guint8* u, guint8* v, gint uv_step)
+{
+    const __m128i three = _mm_set1_epi16(3);
+    const __m128i bias = _mm_set1_epi16(128);
+
+    /* Round toward zero like the scalar '/': add 3 to negative sums before shifting */
+    u_sum = _mm_add_epi16(u_sum, _mm_and_si128(_mm_srai_epi16(u_sum, 15), three));
+    v_sum = _mm_add_epi16(v_sum, _mm_and_si128(_mm_srai_epi16(v_sum, 15), three));
+    __m128i uq = _mm_add_epi16(_mm_srai_epi16(u_sum, 2), bias);
+    __m128i vq = _mm_add_epi16(_mm_srai_epi16(v_sum, 2), bias);
+    __m128i uv8 = _mm_packus_epi16(uq, vq); /* U0-7 V0-7 */
+
+    if (uv_step == 2)
+    {
+        _mm_storeu_si128((__m128i*)u, _mm_unpacklo_epi8(uv8, _mm_srli_si128(uv8, 8)));
+    }
+    else
+    {
+        _mm_storel_epi64((__m128i*)u, uv8);
+        _mm_storel_epi64((__m128i*)v, _mm_srli_si128(uv8, 8));
+    }
+}
+
+TARGET_SSE41 static void yuv420_row_sse41(const guint8* s0, const guint8* s1, gint width, guint8* y0, guint8* y1,
+                                          guint8* u, guint8* v, gint uv_step, const YuvCoeffs* c)
+{
+    Sse41Coeffs k;
+    sse41_load_coeffs(c, &k);
+    const __m128i y_off = _mm_set1_epi16(c->y_offset);
+
+    gint x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i ya0, ua0, va0, yb0, ub0, vb0;
+        __m128i ya1, ua1, va1, yb1, ub1, vb1;
+        sse41_rgba8(s0 + (gsize)x * 4, &k, &ya0, &ua0, &va0);
+        sse41_rgba8(s0 + (gsize)x * 4 + 32, &k, &yb0, &ub0, &vb0);
+        sse41_rgba8(s1 + (gsize)x * 4, &k, &ya1, &ua1, &va1);
+        sse41_rgba8(s1 + (gsize)x * 4 + 32, &k, &yb1, &ub1, &vb1);
+
+        _mm_storeu_si128((__m128i*)(y0 + x),
+                         _mm_packus_epi16(_mm_add_epi16(ya0, y_off), _mm_add_epi16(yb0, y_off)));
+        if (y1 != NULL)
+        {
+            _mm_storeu_si128((__m128i*)(y1 + x),
+                             _mm_packus_epi16(_mm_add_epi16(ya1, y_off), _mm_add_epi16(yb1, y_off)));
+        }
+
+        /* Vertical sums first, then horizontal pairs: pixels 0-7 -> sums 0-3, pixels 8-15 -> sums 4-7 */
+        __m128i u_sum = _mm_hadd_epi16(_mm_add_epi16(ua0, ua1), _mm_add_epi16(ub0, ub1));
+        __m128i v_sum = _mm_hadd_epi16(_mm_add_epi16(va0, va1), _mm_add_epi16(vb0, vb1));
+        const gsize ci = (gsize)(x / 2) * (gsize)uv_step;
+        sse41_store_chroma(u_sum, v_sum, u + ci, v + ci, uv_step);
+    }
+
+    yuv420_row_scalar_from(x, s0, s1, width, y0, y1, u, v, uv_step, c);
+}
+
+typedef struct
+{
+    __m256i y_rg, y_b1, u_rg, u_b1, v_rg, v_b1;
+} Avx2Coeffs;
+
+TARGET_AVX2 static inline void avx2_load_coeffs(const YuvCoeffs* c, Avx2Coeffs* k)
+{
+    k->y_rg = _mm256_set1_epi32(pack_coeff_pair(c->y[0], c->y[1]));
+    k->y_b1 = _mm256_set1_epi32(pack_coeff_pair(c->y[2], 128));
+    k->u_rg = _mm256_set1_epi32(pack_coeff_pair(c->u[0], c->u[1]));
+    k->u_b1 = _mm256_set1_epi32(pack_coeff_pair(c->u[2], 128));
+    k->v_rg = _mm256_set1_epi32(pack_coeff_pair(c->v[0], c->v[1]));
+    k->v_b1 = _mm256_set1_epi32(pack_coeff_pair(c->v[2], 128));
+}
+
+/* Same as sse41_dot8 per 128-bit lane; the unpack/pack pair keeps pixels 0-15 in order */
+TARGET_AVX2 static inline __m256i avx2_dot16(__m256i rg_lo, __m256i rg_hi, __m256i b1_lo, __m256i b1_hi,
+                                             __m256i k_rg, __m256i k_b1)
+{
+    __m256i lo = _mm256_add_epi32(_mm256_madd_epi16(rg_lo, k_rg), _mm256_madd_epi16(b1_lo, k_b1));
+    __m256i hi = _mm256_add_epi32(_mm256_madd_epi16(rg_hi, k_rg), _mm256_madd_epi16(b1_hi, k_b1));
+    return _mm256_packs_epi32(_mm256_srai_epi32(lo, 8), _mm256_srai_epi32(hi, 8));
+}
+
+/* 16 RGBA pixels -> unbiased luma and per-pixel chroma as int16 */
+TARGET_AVX2 static inline void avx2_rgba16(const guint8* p, const Avx2Coeffs* k, __m256i* y, __m256i* u, __m256i* v)
+{
+    const __m256i shuf = _mm256_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15, 0, 4, 8, 12, 1, 5, 9,
+                                          13, 2, 6, 10, 14, 3, 7, 11, 15);
+    const __m256i perm = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const __m256i one = _mm256_set1_epi16(1);
+
+    /* Each vector becomes R0-7 G0-7 | B0-7 A0-7 */
+    __m256i t0 = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)p), shuf), perm);
+    __m256i t1 =
+        _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(p + 32)), shuf), perm);
+
+    __m128i r8 = _mm_unpacklo_epi64(_mm256_castsi256_si128(t0), _mm256_castsi256_si128(t1));
+    __m128i g8 = _mm_unpackhi_epi64(_mm256_castsi256_si128(t0), _mm256_castsi256_si128(t1));
+    __m128i b8 = _mm_unpacklo_epi64(_mm256_extracti128_si256(t0, 1), _mm256_extracti128_si256(t1, 1));
+
+    __m256i r16 = _mm256_cvtepu8_epi16(r8);
+    __m256i g16 = _mm256_cvtepu8_epi16(g8);
+    __m256i b16 = _mm256_cvtepu8_epi16(b8);
+
+    __m256i rg_lo = _mm256_unpacklo_epi16(r16, g16);
+    __m256i rg_hi = _mm256_unpackhi_epi16(r16, g16);
+    __m256i b1_lo = _mm256_unpacklo_epi16(b16, one);
+    __m256i b1_hi = _mm256_unpackhi_epi16(b16, one);
+
+    *y = avx2_dot16(rg_lo, rg_hi, b1_lo, b1_hi, k->y_rg, k->y_b1);
+    *u = avx2_dot16(rg_lo, rg_hi, b1_lo, b1_hi, k->u_rg, k->u_b1);
+    *v = avx2_dot16(rg_lo, rg_hi, b1_lo, b1_hi, k->v_rg, k->v_b1);
+}
+
+TARGET_AVX2 static void yuv420_row_avx2(const guint8* s0, const guint8* s1, gint width, guint8* y0, guint8* y1,
+                                        guint8* u, guint8* v, gint uv_step, const YuvCoeffs* c)
+{
+    Avx2Coeffs k;
+    avx2_load_coeffs(c, &k);
+    const __m256i y_off = _mm256_set1_epi16(c->y_offset);
+
+    gint x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m256i ya, ua, va, yb, ub, vb;
+        avx2_rgba16(s0 + (gsize)x * 4, &k, &ya, &ua, &va);
+        avx2_rgba16(s1 + (gsize)x * 4, &k, &yb, &ub, &vb);
+
+        ya = _mm256_add_epi16(ya, y_off);
+        _mm_storeu_si128((__m128i*)(y0 + x),
+                         _mm_packus_epi16(_mm256_castsi256_si128(ya), _mm256_extracti128_si256(ya, 1)));
+        if (y1 != NULL)
+        {
+            yb = _mm256_add_epi16(yb, y_off);
+            _mm_storeu_si128((__m128i*)(y1 + x),
+                             _mm_packus_epi16(_mm256_castsi256_si128(yb), _mm256_extracti128_si256(yb, 1)));
+        }
+
+        __m256i us = _mm256_add_epi16(ua, ub);
+        __m256i vs = _mm256_add_epi16(va, vb);
+        __m128i u_sum = _mm_hadd_epi16(_mm256_castsi256_si128(us), _mm256_extracti128_si256(us, 1));
+        __m128i v_sum = _mm_hadd_epi16(_mm256_castsi256_si128(vs), _mm256_extracti128_si256(vs, 1));
+        const gsize ci = (gsize)(x / 2) * (gsize)uv_step;
+        sse41_store_chroma(u_sum, v_sum, u + ci, v + ci, uv_step);
+    }
+
+    yuv420_row_scalar_from(x, s0, s1, width, y0, y1, u, v, uv_step, c);
+}
+
+#endif /* STATIC_IMAGE_HAVE_X86_SIMD */
+
+#ifdef STATIC_IMAGE_HAVE_NEON
+
+static inline int16x8_t neon_dot8(int16x8_t r, int16x8_t g, int16x8_t b, const gint16* k)
+{
+    int32x4_t lo = vdupq_n_s32(128);
+    int32x4_t hi = vdupq_n_s32(128);
+    lo = vmlal_n_s16(lo, vget_low_s16(r), k[0]);
+    hi = vmlal_n_s16(hi, vget_high_s16(r), k[0]);
+    lo = vmlal_n_s16(lo, vget_low_s16(g), k[1]);
+    hi = vmlal_n_s16(hi, vget_high_s16(g), k[1]);
+    lo = vmlal_n_s16(lo, vget_low_s16(b), k[2]);
+    hi = vmlal_n_s16(hi, vget_high_s16(b), k[2]);
+    return vcombine_s16(vshrn_n_s32(lo, 8), vshrn_n_s32(hi, 8));
+}
+
+typedef struct
+{
+    int16x8_t y[2], u[2], v[2];
+} NeonYuv16;
+
+/* 16 RGBA pixels -> unbiased luma and per-pixel chroma as int16 (pixels 0-7 in [0], 8-15 in [1]) */
+static inline void neon_rgba16(const guint8* p, const YuvCoeffs* c, NeonYuv16* out)
+{
+    uint8x16x4_t px = vld4q_u8(p);
+    for (gint h = 0; h < 2; ++h)
+    {
+        uint8x8_t r8 = h == 0 ? vget_low_u8(px.val[0]) : vget_high_u8(px.val[0]);
+        uint8x8_t g8 = h == 0 ? vget_low_u8(px.val[1]) : vget_high_u8(px.val[1]);
+        uint8x8_t b8 = h == 0 ? vget_low_u8(px.val[2]) : vget_high_u8(px.val[2]);
+        int16x8_t r = vreinterpretq_s16_u16(vmovl_u8(r8));
+        int16x8_t g = vreinterpretq_s16_u16(vmovl_u8(g8));
+        int16x8_t b = vreinterpretq_s16_u16(vmovl_u8(b8));
+        out->y[h] = neon_dot8(r, g, b, c->y);
+        out->u[h] = neon_dot8(r, g, b, c->u);
+        out->v[h] = neon_dot8(r, g, b, c->v);
+    }
+}
+
+static inline uint8x8_t neon_chroma_average(int16x8_t sum_lo, int16x8_t sum_hi)
+{
+    int16x8_t sum = vcombine_s16(vpadd_s16(vget_low_s16(sum_lo), vget_high_s16(sum_lo)),
+                                 vpadd_s16(vget_low_s16(sum_hi), vget_high_s16(sum_hi)));
+    /* Round toward zero like the scalar '/' */
+    sum = vaddq_s16(sum, vandq_s16(vshrq_n_s16(sum, 15), vdupq_n_s16(3)));
+    return vqmovun_s16(vaddq_s16(vshrq_n_s16(sum, 2), vdupq_n_s16(128)));
+}
+
+static void yuv420_row_neon(const guint8* s0, const guint8* s1, gint width, guint8* y0, guint8* y1, guint8* u,
+                            guint8* v, gint uv_step, const YuvCoeffs* c)
+{
+    const int16x8_t y_off = vdupq_n_s16(c->y_offset);
+
+    gint x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        NeonYuv16 a;
+        NeonYuv16 b;
+        neon_rgba16(s0 + (gsize)x * 4, c, &a);
+        neon_rgba16(s1 + (gsize)x * 4, c, &b);
+
+        vst1q_u8(y0 + x, vcombine_u8(vqmovun_s16(vaddq_s16(a.y[0], y_off)), vqmovun_s16(vaddq_s16(a.y[1], y_off))));
+        if (y1 != NULL)
+        {
+            vst1q_u8(y1 + x,
+                     vcombine_u8(vqmovun_s16(vaddq_s16(b.y[0], y_off)), vqmovun_s16(vaddq_s16(b.y[1], y_off))));
+        }
+
+        uint8x8_t u8 = neon_chroma_average(vaddq_s16(a.u[0], b.u[0]), vaddq_s16(a.u[1], b.u[1]));
+        uint8x8_t v8 = neon_chroma_average(vaddq_s16(a.v[0], b.v[0]), vaddq_s16(a.v[1], b.v[1]));
+        const gsize ci = (gsize)(x / 2) * (gsize)uv_step;
+        if (uv_step == 2)
+        {
+            uint8x8x2_t uv;
+            uv.val[0] = u8;
+            uv.val[1] = v8;
+            vst2_u8(u + ci, uv);
+        }
+        else
+        {
+            vst1_u8(u + ci, u8);
+            vst1_u8(v + ci, v8);
+        }
+    }
+
+    yuv420_row_scalar_from(x, s0, s1, width, y0, y1, u, v, uv_step, c);
+}
+
+#endif /* STATIC_IMAGE_HAVE_NEON */
+
+typedef struct
+{
+    const gchar* name;
+    Yuv420RowFunc yuv420_row;
+} ConvertImpl;
+
+static const ConvertImpl* get_impl(void)
+{
+    static gsize initialized = 0;
+    static ConvertImpl impl = {"scalar", yuv420_row_scalar};
+
+    if (g_once_init_enter(&initialized))
+    {
+        guint flags = static_image_cpu_get_flags();
+        (void)flags;
+#ifdef STATIC_IMAGE_HAVE_X86_SIMD
+        if (flags & STATIC_IMAGE_CPU_AVX2)
+        {
+            impl.name = "avx2";
+            impl.yuv420_row = yuv420_row_avx2;
+        }
+        else if (flags & STATIC_IMAGE_CPU_SSE41)
+        {
+            impl.name = "sse4.1";
+            impl.yuv420_row = yuv420_row_sse41;
+        }
+#endif
+#ifdef STATIC_IMAGE_HAVE_NEON
+        if (flags & STATIC_IMAGE_CPU_NEON)
+        {
+            impl.name = "neon";
+            impl.yuv420_row = yuv420_row_neon;
+        }
+#endif
+        g_once_init_leave(&initialized, 1);
+    }
+
+    return &impl;
+}
+
+typedef struct
+{
+    Yuv420RowFunc row_func;
+    const guint8* src;
+    gint src_stride;
+    gint width;
+    gint height;
+    guint8* y_plane;
+    gint y_stride;
+    guint8* u_plane;
+    gint u_stride;
+    guint8* v_plane;
+    gint v_stride;
+    gint uv_step;
+    const YuvCoeffs* coeffs;
+} Yuv420Job;
+
+static void yuv420_band(gint start, gint end, gpointer user_data)
+{
+    const Yuv420Job* job = (const Yuv420Job*)user_data;
+
+    for (gint y = start; y < end; y += 2)
+    {
+        const gboolean has_row1 = (y + 1 < job->height);
+        const guint8* s0 = job->src + (gsize)y * (gsize)job->src_stride;
+        const guint8* s1 = has_row1 ? s0 + job->src_stride : s0;
+        guint8* y0 = job->y_plane + (gsize)y * (gsize)job->y_stride;
+        guint8* y1 = has_row1 ? y0 + job->y_stride : NULL;
+        guint8* u = job->u_plane + (gsize)(y / 2) * (gsize)job->u_stride;
+        guint8* v = job->v_plane + (gsize)(y / 2) * (gsize)job->v_stride;
+
+        job->row_func(s0, s1, job->width, y0, y1, u, v, job->uv_step, job->coeffs);
+    }
+}
+
+void static_image_convert_rgba_to_yuv420(const guint8* src, gint src_stride, gint width, gint height, guint8* y_plane,
+                                         gint y_stride, guint8* u_plane, gint u_stride, guint8* v_plane, gint v_stride,
+                                         gint uv_step, StaticImageMatrix matrix, gboolean full_range,
+                                         guint n_threads)
+{
+    g_return_if_fail(src != NULL && y_plane != NULL && u_plane != NULL && v_plane != NULL);
+    g_return_if_fail(uv_step == 1 || (uv_step == 2 && (v_plane == u_plane + 1 || v_plane + 1 == u_plane)));
+
+    const YuvCoeffs* coeffs = get_coeffs(matrix, full_range);
+
+    /* The kernels store interleaved chroma U first; NV21 swaps the chroma rows of the matrix instead */
+    YuvCoeffs swapped;
+    if (uv_step == 2 && v_plane + 1 == u_plane)
+    {
+        swapped = *coeffs;
+        memcpy(swapped.u, coeffs->v, sizeof(swapped.u));
+        memcpy(swapped.v, coeffs->u, sizeof(swapped.v));
+        coeffs = &swapped;
+        guint8* first = v_plane;
+        v_plane = u_plane;
+        u_plane = first;
+        const gint first_stride = v_stride;
+        v_stride = u_stride;
+        u_stride = first_stride;
+    }
+
+    Yuv420Job job = {get_impl()->yuv420_row, src,     src_stride, width,   height,   y_plane, y_stride,
+                     u_plane,                u_stride, v_plane,   v_stride, uv_step, coeffs};
+
+    /* Bands start on even rows so every band owns whole chroma rows */
+    static_image_parallel_for(height, 2, n_threads, yuv420_band, &job);
+}
+
+typedef struct
+{
+    guint8* pixels;
+    gint stride;
+    gint width;
+    guint8 order[4];
+} SwizzleJob;
+
+static void swizzle_band(gint start, gint end, gpointer user_data)
+{
+    const SwizzleJob* job = (const SwizzleJob*)user_data;
+    const guint8 o0 = job->order[0];
+    const guint8 o1 = job->order[1];
+    const guint8 o2 = job->order[2];
+    const guint8 o3 = job->order[3];
+
+    for (gint y = start; y < end; ++y)
+    {
+        guint8* p = job->pixels + (gsize)y * (gsize)job->stride;
+        for (gint x = 0; x < job->width; ++x, p += 4)
+        {
+            const guint8 in[4] = {p[0], p[1], p[2], p[3]};
+            p[0] = in[o0];
+            p[1] = in[o1];
+            p[2] = in[o2];
+            p[3] = in[o3];
+        }
+    }
+}
+
+void static_image_convert_swizzle(guint8* pixels, gint stride, gint width, gint height, const guint8 order[4],
+                                  guint n_threads)
+{
+    g_return_if_fail(pixels != NULL && order != NULL);
+
+    SwizzleJob job = {pixels, stride, width, {order[0], order[1], order[2], order[3]}};
+    static_image_parallel_for(height, 1, n_threads, swizzle_band, &job);
+}
+
+/* Where one component's samples go: byte offset of the first sample in its plane and distance between samples */
+typedef struct
+{
+    guint8 plane;
+    guint8 offset;
+    guint8 step;
+} YuvComponent;
+
+/* A YUV output format; chroma step 0 means no chroma (grey) */
+typedef struct
+{
+    const gchar* name;
+    guint8 h_shift; /* log2 of the chroma subsampling */
+    guint8 v_shift;
+    guint8 n_planes;
+    YuvComponent y;
+    YuvComponent u;
+    YuvComponent v;
+} YuvFormat;
+
+static const YuvFormat yuv_formats[] = {
+    /* name, h/v shift, planes, Y, U, V */
+    {"I420", 1, 1, 3, {0, 0, 1}, {1, 0, 1}, {2, 0, 1}},
+    {"NV12", 1, 1, 2, {0, 0, 1}, {1, 0, 2}, {1, 1, 2}},
+    {"NV21", 1, 1, 2, {0, 0, 1}, {1, 1, 2}, {1, 0, 2}},
+    {"Y42B", 1, 0, 3, {0, 0, 1}, {1, 0, 1}, {2, 0, 1}},
+    {"NV16", 1, 0, 2, {0, 0, 1}, {1, 0, 2}, {1, 1, 2}},
+    {"YUY2", 1, 0, 1, {0, 0, 2}, {0, 1, 4}, {0, 3, 4}},
+    {"UYVY", 1, 0, 1, {0, 1, 2}, {0, 0, 4}, {0, 2, 4}},
+    {"Y444", 0, 0, 3, {0, 0, 1}, {1, 0, 1}, {2, 0, 1}},
+    {"GRAY8", 0, 0, 1, {0, 0, 1}, {0, 0, 0}, {0, 0, 0}},
+};
+
+static const YuvFormat* find_yuv_format(const gchar* format)
+{
+    for (guint i = 0; i < G_N_ELEMENTS(yuv_formats); ++i)
+    {
+        if (g_strcmp0(yuv_formats[i].name, format) == 0)
+        {
+            return &yuv_formats[i];
+        }
+    }
+    return NULL;
+}
+
+gboolean static_image_convert_is_yuv(const gchar* format)
+{
+    return find_yuv_format(format) != NULL;
+}
+
+typedef struct
+{
+    const YuvFormat* format;
+    const StaticImageFrameLayout* layout;
+    const guint8* src;
+    gint src_stride;
+    guint8* dst;
+    const YuvCoeffs* coeffs;
+} YuvJob;
+
+static inline guint8* component_sample(const YuvJob* job, const YuvComponent* comp, gint row, gint index)
+{
+    return job->dst + job->layout->offsets[comp->plane] + (gsize)row * (gsize)job->layout->strides[comp->plane] +
+           comp->offset + (gsize)index * comp->step;
+}
+
+/*
+ * Converts whole chroma rows [start, end) in source rows. Luma is per pixel;
+ * chroma averages each pixel's rounded chroma over the subsampling block,
+ * replicating the last column/row at odd edges, exactly as the 4:2:0 kernels.
+ */
+static void yuv_band(gint start, gint end, gpointer user_data)
+{
+    const YuvJob* job = (const YuvJob*)user_data;
+    const YuvFormat* fmt = job->format;
+    const YuvCoeffs* c = job->coeffs;
+    const gint width = job->layout->width;
+    const gint height = job->layout->height;
+    const gint block_w = 1 << fmt->h_shift;
+    const gint block_h = 1 << fmt->v_shift;
+    const gint count = block_w * block_h;
+
+    for (gint y = start; y < end; y += block_h)
+    {
+        for (gint by = 0; by < block_h && y + by < height; ++by)
+        {
+            const guint8* s = job->src + (gsize)(y + by) * (gsize)job->src_stride;
+            for (gint x = 0; x < width; ++x)
+            {
+                *component_sample(job, &fmt->y, y + by, x) = luma_scalar(c, s + (gsize)x * 4);
+            }
+        }
+
+        if (fmt->u.step == 0)
+        {
+            continue;
+        }
+        const gint chroma_row = y >> fmt->v_shift;
+        for (gint x = 0; x < width; x += block_w)
+        {
+            gint u_sum = 0;
+            gint v_sum = 0;
+            for (gint by = 0; by < block_h; ++by)
+            {
+                const guint8* s = job->src + (gsize)MIN(y + by, height - 1) * (gsize)job->src_stride;
+                for (gint bx = 0; bx < block_w; ++bx)
+                {
+                    const guint8* p = s + (gsize)MIN(x + bx, width - 1) * 4;
+                    u_sum += chroma_scalar(c->u, p);
+                    v_sum += chroma_scalar(c->v, p);
+                }
+            }
+            const gint index = x >> fmt->h_shift;
+            *component_sample(job, &fmt->u, chroma_row, index) = chroma_average(u_sum, count);
+            *component_sample(job, &fmt->v, chroma_row, index) = chroma_average(v_sum, count);
+        }
+    }
+}
+
+gboolean static_image_convert_rgba_to_yuv(const guint8* src, gint src_stride, const gchar* format,
+                                          const StaticImageFrameLayout* layout, guint8* dst, StaticImageMatrix matrix,
+                                          gboolean full_range, guint n_threads)
+{
+    g_return_val_if_fail(src != NULL && layout != NULL && dst != NULL, FALSE);
+
+    const YuvFormat* fmt = find_yuv_format(format);
+    if (fmt == NULL)
+    {
+        return FALSE;
+    }
+
+    if (fmt->h_shift == 1 && fmt->v_shift == 1)
+    {
+        guint8* u_plane = dst + layout->offsets[fmt->u.plane] + fmt->u.offset;
+        guint8* v_plane = dst + layout->offsets[fmt->v.plane] + fmt->v.offset;
+        guint8* y_plane = dst + layout->offsets[fmt->y.plane];
+        static_image_convert_rgba_to_yuv420(src, src_stride, layout->width, layout->height, y_plane,
+                                            layout->strides[fmt->y.plane], u_plane, layout->strides[fmt->u.plane],
+                                            v_plane, layout->strides[fmt->v.plane], fmt->u.step, matrix, full_range,
+                                            n_threads);
+        return TRUE;
+    }
+
+    YuvJob job = {fmt, layout, src, src_stride, dst, get_coeffs(matrix, full_range)};
+    static_image_parallel_for(layout->height, 1 << fmt->v_shift, n_threads, yuv_band, &job);
+    return TRUE;
+}
+
+gboolean static_image_convert_rgba_to_yuv_rows(const guint8* src, gint src_stride, const gchar* format,
+                                               const StaticImageFrameLayout* layout, gint first_row, gint n_rows,
+                                               guint8* dst, StaticImageMatrix matrix, gboolean full_range)
+{
+    g_return_val_if_fail(src != NULL && layout != NULL && dst != NULL, FALSE);
+
+    const YuvFormat* fmt = find_yuv_format(format);
+    if (fmt == NULL || first_row % (1 << fmt->v_shift) != 0 || first_row + n_rows > layout->height)
+    {
+        return FALSE;
+    }
+
+    /* The band as a frame of its own: every plane starts at the band's first row of it */
+    StaticImageFrameLayout band = *layout;
+    band.height = n_rows;
+    for (guint p = 0; p < band.n_planes; ++p)
+    {
+        const gint row = p == fmt->y.plane ? first_row : first_row >> fmt->v_shift;
+        band.offsets[p] += (gsize)row * (gsize)band.strides[p];
+    }
+    return static_image_convert_rgba_to_yuv(src, src_stride, format, &band, dst, matrix, full_range, 1);
+}
+
+gboolean static_image_frame_layout_init(StaticImageFrameLayout* layout, const gchar* format, gint width, gint height)
+{
+    g_return_val_if_fail(layout != NULL && format != NULL, FALSE);
+
+    memset(layout, 0, sizeof(*layout));
+    layout->width = width;
+    layout->height = height;
+
+    if (g_strcmp0(format, "RGBA") == 0 || g_strcmp0(format, "BGRA") == 0 || g_strcmp0(format, "ARGB") == 0 ||
+        g_strcmp0(format, "ABGR") == 0)
+    {
+        layout->n_planes = 1;
+        layout->strides[0] = width * 4;
+        layout->size = (gsize)width * (gsize)height * 4;
+        return TRUE;
+    }
+
+    const YuvFormat* fmt = find_yuv_format(format);
+    if (fmt == NULL)
+    {
+        return FALSE;
+    }
+
+    const gint chroma_w = (width + (1 << fmt->h_shift) - 1) >> fmt->h_shift;
+    const gint chroma_h = (height + (1 << fmt->v_shift) - 1) >> fmt->v_shift;
+    layout->n_planes = fmt->n_planes;
+    for (guint p = 0; p < fmt->n_planes; ++p)
+    {
+        /* Each plane is as wide as the widest component in it needs; packed 4:2:2 holds one chroma pair per 2 pixels */
+        gint stride = 0;
+        if (fmt->y.plane == p)
+        {
+            stride = width * fmt->y.step;
+        }
+        if (fmt->u.step > 0 && (fmt->u.plane == p || fmt->v.plane == p))
+        {
+            stride = MAX(stride, chroma_w * fmt->u.step);
+        }
+        const gint rows = p == fmt->y.plane ? height : chroma_h;
+        layout->strides[p] = stride;
+        layout->offsets[p] = layout->size;
+        layout->size += (gsize)stride * (gsize)rows;
+    }
+    return TRUE;
+}
+
+const gchar* static_image_convert_get_impl_name(void)
+{
+    return get_impl()->name;
+}
@@ -0,0 +1,91 @@
+/*
+ * Static Image Source - RGBA to YUV conversion kernels
+ */
+
+#ifndef __GST_STATIC_IMAGE_CONVERT_H__
+#define __GST_STATIC_IMAGE_CONVERT_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define STATIC_IMAGE_MAX_PLANES 4
+
+/* Plane layout of one tightly packed output frame */
+typedef struct
+{
+    gint width;
+    gint height;
+    guint n_planes;
+    gint strides[STATIC_IMAGE_MAX_PLANES];
+    gsize offsets[STATIC_IMAGE_MAX_PLANES];
+    gsize size;
+} StaticImageFrameLayout;
+
+/* RGB to YCbCr matrix */
+typedef enum
+{
+    STATIC_IMAGE_MATRIX_BT601,
+    STATIC_IMAGE_MATRIX_BT709,
+    STATIC_IMAGE_MATRIX_BT2020
+} StaticImageMatrix;
+
+/*
+ * Fills layout for format: "RGBA", "BGRA", "ARGB", "ABGR", or any format for
+ * which static_image_convert_is_yuv() is TRUE. Subsampled chroma rounds odd
+ * dimensions up. Returns FALSE for any other format.
+ */
+gboolean static_image_frame_layout_init(StaticImageFrameLayout* layout, const gchar* format, gint width, gint height);
+
+/* TRUE for the YUV and grey formats: I420, NV12, NV21, Y42B, NV16, YUY2, UYVY, Y444 and GRAY8 */
+gboolean static_image_convert_is_yuv(const gchar* format);
+
+/*
+ * Converts tightly or loosely packed RGBA into 4:2:0 YUV in a single pass: each
+ * pair of source rows yields two luma rows and one row of averaged 2x2 chroma.
+ * With uv_step == 1 the U and V planes are separate (I420); with uv_step == 2
+ * they are interleaved and v_plane must be u_plane + 1 (NV12) or u_plane - 1
+ * (NV21). Odd widths and heights replicate the last column/row into the final
+ * chroma sample. full_range selects 0-255 instead of 16-235/240 samples. Row
+ * pairs are spread over n_threads (0 = one per CPU).
+ */
+void static_image_convert_rgba_to_yuv420(const guint8* src, gint src_stride, gint width, gint height, guint8* y_plane,
+                                         gint y_stride, guint8* u_plane, gint u_stride, guint8* v_plane, gint v_stride,
+                                         gint uv_step, StaticImageMatrix matrix, gboolean full_range,
+                                         guint n_threads);
+
+/*
+ * Converts RGBA into a frame of any YUV or grey format, laid out in dst as by
+ * static_image_frame_layout_init(). 4:2:0 formats use the kernels above; the
+ * others a scalar kernel driven by a per-format table of sample positions,
+ * with the same rounding, so a given pixel converts identically in every
+ * format. Returns FALSE if format is not a YUV format.
+ */
+gboolean static_image_convert_rgba_to_yuv(const guint8* src, gint src_stride, const gchar* format,
+                                          const StaticImageFrameLayout* layout, guint8* dst, StaticImageMatrix matrix,
+                                          gboolean full_range, guint n_threads);
+
+/*
+ * As above for rows first_row .. first_row + n_rows - 1 of the frame only,
+ * with src holding just those rows. Everything else in dst stays untouched.
+ * first_row must be a multiple of the format's vertical subsampling (2 for
+ * 4:2:0), and so must n_rows unless the band ends the frame. Runs on the
+ * calling thread.
+ */
+gboolean static_image_convert_rgba_to_yuv_rows(const guint8* src, gint src_stride, const gchar* format,
+                                               const StaticImageFrameLayout* layout, gint first_row, gint n_rows,
+                                               guint8* dst, StaticImageMatrix matrix, gboolean full_range);
+
+/*
+ * Reorders packed 4-byte pixels in place: output byte i of every pixel becomes
+ * input byte order[i] (e.g. {2, 1, 0, 3} turns RGBA into BGRA).
+ */
+void static_image_convert_swizzle(guint8* pixels, gint stride, gint width, gint height, const guint8 order[4],
+                                  guint n_threads);
+
+/* Name of the kernel selected for this CPU ("avx2", "sse4.1", "neon" or "scalar") */
+const gchar* static_image_convert_get_impl_name(void);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_CONVERT_H__ */
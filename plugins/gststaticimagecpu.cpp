@@ -0,0 +1,41 @@
+/*
+ * Static Image Source - CPU feature detection for SIMD kernel dispatch
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimagecpu.h"
+
+guint static_image_cpu_get_flags(void)
+{
+    static gsize initialized = 0;
+    static guint flags = STATIC_IMAGE_CPU_NONE;
+
+    if (g_once_init_enter(&initialized))
+    {
+        guint detected = STATIC_IMAGE_CPU_NONE;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse4.1"))
+        {
+            detected |= STATIC_IMAGE_CPU_SSE41;
+        }
+        /* libgcc also checks XCR0, so this is false when the OS does not save YMM state */
+        if (__builtin_cpu_supports("avx2"))
+        {
+            detected |= STATIC_IMAGE_CPU_AVX2;
+        }
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+        /* NEON is mandatory on AArch64; 32-bit builds only get here when compiled with -mfpu=neon */
+        detected |= STATIC_IMAGE_CPU_NEON;
+#endif
+
+        flags = detected;
+        g_once_init_leave(&initialized, 1);
+    }
+
+    return flags;
+}
@@ -0,0 +1,25 @@
+/*
+ * Static Image Source - CPU feature detection for SIMD kernel dispatch
+ */
+
+#ifndef __GST_STATIC_IMAGE_CPU_H__
+#define __GST_STATIC_IMAGE_CPU_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    STATIC_IMAGE_CPU_NONE = 0,
+    STATIC_IMAGE_CPU_SSE41 = 1 << 0,
+    STATIC_IMAGE_CPU_AVX2 = 1 << 1,
+    STATIC_IMAGE_CPU_NEON = 1 << 2
+} StaticImageCpuFlags;
+
+/* Detected once per process; safe to call from any thread */
+guint static_image_cpu_get_flags(void);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_CPU_H__ */
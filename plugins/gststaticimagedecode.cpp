@@ -0,0 +1,852 @@
+/*
+ * Static Image Source - PNG and JPEG decoding to RGBA
+ *
+ * Both decoders read from memory: files are mmapped rather than streamed
+ * through stdio, and an embedding application can hand over encoded bytes it
+ * already holds. libjpeg errors longjmp back into the decode call instead of
+ * exiting the process, so a corrupt or half-written JPEG is just a failed
+ * decode. Decoder state that must survive the jump lives in a heap-allocated
+ * JpegDecoder.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimagedecode.h"
+
+#include "gststaticimageconvert.h"
+
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <jpeglib.h>
+#include <png.h>
+
+GBytes* static_image_decode_map_file(const gchar* path)
+{
+    GMappedFile* mapped = g_mapped_file_new(path, FALSE, NULL);
+    if (mapped == NULL)
+    {
+        return NULL;
+    }
+
+    /* The bytes keep the mapping alive */
+    GBytes* bytes = g_mapped_file_get_bytes(mapped);
+    g_mapped_file_unref(mapped);
+    return bytes;
+}
+
+GBytes* static_image_decode_read_file(const gchar* path)
+{
+    gchar* contents = NULL;
+    gsize length = 0;
+    if (!g_file_get_contents(path, &contents, &length, NULL))
+    {
+        return NULL;
+    }
+    return g_bytes_new_take(contents, length);
+}
+
+gboolean static_image_decode_is_png(GBytes* data)
+{
+    gsize size = 0;
+    const guint8* bytes = (const guint8*)g_bytes_get_data(data, &size);
+    return size >= 8 && png_sig_cmp((png_const_bytep)bytes, 0, 8) == 0;
+}
+
+gboolean static_image_decode_is_jpeg(GBytes* data)
+{
+    gsize size = 0;
+    const guint8* bytes = (const guint8*)g_bytes_get_data(data, &size);
+    return size >= 3 && bytes[0] == 0xFF && bytes[1] == 0xD8 && bytes[2] == 0xFF;
+}
+
+typedef struct
+{
+    const guint8* data;
+    gsize size;
+    gsize offset;
+} PngReader;
+
+static void png_read_from_memory(png_structp png_ptr, png_bytep out, png_size_t length)
+{
+    PngReader* reader = (PngReader*)png_get_io_ptr(png_ptr);
+    if (length > reader->size - reader->offset)
+    {
+        png_error(png_ptr, "truncated PNG");
+    }
+    memcpy(out, reader->data + reader->offset, length);
+    reader->offset += length;
+}
+
+/* Expands every colour type and bit depth to 8-bit RGBA; call after png_read_info() */
+static void png_set_rgba_transforms(png_structp png_ptr, png_infop info_ptr)
+{
+    int bit_depth = png_get_bit_depth(png_ptr, info_ptr);
+    int color_type = png_get_color_type(png_ptr, info_ptr);
+
+    if (bit_depth == 16)
+    {
+        png_set_strip_16(png_ptr);
+    }
+
+    if (color_type == PNG_COLOR_TYPE_PALETTE)
+    {
+        png_set_palette_to_rgb(png_ptr);
+    }
+
+    if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
+    {
+        png_set_expand_gray_1_2_4_to_8(png_ptr);
+    }
+
+    if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
+    {
+        png_set_tRNS_to_alpha(png_ptr);
+    }
+
+    if (color_type == PNG_COLOR_TYPE_RGB || color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_PALETTE)
+    {
+        png_set_filler(png_ptr, 0xFF, PNG_FILLER_AFTER);
+    }
+
+    if (color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+    {
+        png_set_gray_to_rgb(png_ptr);
+    }
+}
+
+gboolean static_image_decode_png_size(GBytes* data, gint* out_w, gint* out_h)
+{
+    PngReader reader = {NULL, 0, 0};
+    reader.data = (const guint8*)g_bytes_get_data(data, &reader.size);
+
+    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop info_ptr = png_ptr != NULL ? png_create_info_struct(png_ptr) : NULL;
+    if (!info_ptr)
+    {
+        png_destroy_read_struct(&png_ptr, NULL, NULL);
+        return FALSE;
+    }
+
+    if (setjmp(png_jmpbuf(png_ptr)))
+    {
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        return FALSE;
+    }
+
+    png_set_read_fn(png_ptr, &reader, png_read_from_memory);
+    png_read_info(png_ptr, info_ptr);
+    *out_w = (gint)png_get_image_width(png_ptr, info_ptr);
+    *out_h = (gint)png_get_image_height(png_ptr, info_ptr);
+
+    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+    return *out_w > 0 && *out_h > 0;
+}
+
+gboolean static_image_decode_png(GBytes* data, guint8** out_pixels, gint* out_w, gint* out_h)
+{
+    *out_pixels = NULL;
+    *out_w = 0;
+    *out_h = 0;
+
+    PngReader reader = {NULL, 0, 0};
+    reader.data = (const guint8*)g_bytes_get_data(data, &reader.size);
+
+    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (!png_ptr)
+    {
+        return FALSE;
+    }
+
+    png_infop info_ptr = png_create_info_struct(png_ptr);
+    if (!info_ptr)
+    {
+        png_destroy_read_struct(&png_ptr, NULL, NULL);
+        return FALSE;
+    }
+
+    /* Locals touched after setjmp must be volatile to survive the jump */
+    guint8* volatile pixels = NULL;
+    png_bytep* volatile row_pointers = NULL;
+    if (setjmp(png_jmpbuf(png_ptr)))
+    {
+        g_free(row_pointers);
+        g_free(pixels);
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        return FALSE;
+    }
+
+    png_set_read_fn(png_ptr, &reader, png_read_from_memory);
+    png_read_info(png_ptr, info_ptr);
+
+    png_uint_32 width = png_get_image_width(png_ptr, info_ptr);
+    png_uint_32 height = png_get_image_height(png_ptr, info_ptr);
+    png_set_rgba_transforms(png_ptr, info_ptr);
+    png_read_update_info(png_ptr, info_ptr);
+
+    png_size_t rowbytes = png_get_rowbytes(png_ptr, info_ptr);
+
+    pixels = (guint8*)g_malloc((gsize)rowbytes * height);
+    row_pointers = (png_bytep*)g_malloc(sizeof(png_bytep) * height);
+    for (png_uint_32 y = 0; y < height; ++y)
+    {
+        row_pointers[y] = pixels + y * rowbytes;
+    }
+
+    png_read_image(png_ptr, row_pointers);
+    png_read_end(png_ptr, NULL);
+
+    g_free(row_pointers);
+    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+
+    guint8* result = pixels;
+    /* Re-pack to tightly-packed RGBA if libpng rowbytes differ from width*4 */
+    if (rowbytes != width * 4)
+    {
+        guint8* tight = (guint8*)g_malloc((gsize)width * height * 4);
+        for (png_uint_32 y = 0; y < height; ++y)
+        {
+            memcpy(tight + (gsize)y * (gsize)width * 4, result + (gsize)y * (gsize)rowbytes, (gsize)width * 4);
+        }
+        g_free(result);
+        result = tight;
+    }
+
+    *out_pixels = result;
+    *out_w = (gint)width;
+    *out_h = (gint)height;
+    return TRUE;
+}
+
+/* Feeds a whole decoded image row by row; interlaced PNGs have no final row before the last pass */
+static void feed_rows(const guint8* pixels, gint width, gint height, StaticImageDecodeRowFunc func,
+                      gpointer user_data)
+{
+    for (gint y = 0; y < height; ++y)
+    {
+        func(pixels + (gsize)y * (gsize)width * 4, user_data);
+    }
+}
+
+gboolean static_image_decode_png_rows(GBytes* data, StaticImageDecodeRowFunc func, gpointer user_data)
+{
+    PngReader reader = {NULL, 0, 0};
+    reader.data = (const guint8*)g_bytes_get_data(data, &reader.size);
+
+    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop info_ptr = png_ptr != NULL ? png_create_info_struct(png_ptr) : NULL;
+    if (!info_ptr)
+    {
+        png_destroy_read_struct(&png_ptr, NULL, NULL);
+        return FALSE;
+    }
+
+    /* Locals touched after setjmp must be volatile to survive the jump */
+    guint8* volatile row = NULL;
+    if (setjmp(png_jmpbuf(png_ptr)))
+    {
+        g_free(row);
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        return FALSE;
+    }
+
+    png_set_read_fn(png_ptr, &reader, png_read_from_memory);
+    png_read_info(png_ptr, info_ptr);
+    if (png_get_interlace_type(png_ptr, info_ptr) != PNG_INTERLACE_NONE)
+    {
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+
+        guint8* pixels = NULL;
+        gint width = 0;
+        gint height = 0;
+        if (!static_image_decode_png(data, &pixels, &width, &height))
+        {
+            return FALSE;
+        }
+        feed_rows(pixels, width, height, func, user_data);
+        g_free(pixels);
+        return TRUE;
+    }
+
+    const png_uint_32 height = png_get_image_height(png_ptr, info_ptr);
+    png_set_rgba_transforms(png_ptr, info_ptr);
+    png_read_update_info(png_ptr, info_ptr);
+
+    row = (guint8*)g_malloc(png_get_rowbytes(png_ptr, info_ptr));
+    for (png_uint_32 y = 0; y < height; ++y)
+    {
+        png_read_row(png_ptr, row, NULL);
+        func(row, user_data);
+    }
+    png_read_end(png_ptr, NULL);
+
+    g_free(row);
+    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+    return TRUE;
+}
+
+#if defined(JCS_EXTENSIONS) && defined(JCS_ALPHA_EXTENSIONS)
+#define HAVE_JPEG_ALPHA_EXTENSIONS 1
+#endif
+
+/* libjpeg 7 split the DCT scaled size into horizontal and vertical */
+#if JPEG_LIB_VERSION >= 70
+#define JPEG_MIN_V_SCALED_SIZE(cinfo) ((cinfo)->min_DCT_v_scaled_size)
+#define JPEG_COMP_H_SCALED_SIZE(comp) ((comp)->DCT_h_scaled_size)
+#define JPEG_COMP_V_SCALED_SIZE(comp) ((comp)->DCT_v_scaled_size)
+#else
+#define JPEG_MIN_V_SCALED_SIZE(cinfo) ((cinfo)->min_DCT_scaled_size)
+#define JPEG_COMP_H_SCALED_SIZE(comp) ((comp)->DCT_scaled_size)
+#define JPEG_COMP_V_SCALED_SIZE(comp) ((comp)->DCT_scaled_size)
+#endif
+
+typedef struct
+{
+    struct jpeg_error_mgr pub;
+    jmp_buf jump;
+} JpegErrorMgr;
+
+typedef struct
+{
+    struct jpeg_decompress_struct cinfo;
+    JpegErrorMgr err;
+    GBytes* data;
+    guint8* pixels;  /* output, freed unless handed to the caller */
+    guint8* scratch; /* raw-data band */
+    StaticImageFrameLayout layout; /* of pixels */
+} JpegDecoder;
+
+static void jpeg_error_exit(j_common_ptr cinfo)
+{
+    JpegErrorMgr* err = (JpegErrorMgr*)cinfo->err;
+    longjmp(err->jump, 1);
+}
+
+/* Warnings (e.g. premature end of data) would otherwise go to stderr */
+static void jpeg_output_message(j_common_ptr cinfo)
+{
+    (void)cinfo;
+}
+
+#if JPEG_LIB_VERSION < 80 && !defined(MEM_SRCDST_SUPPORTED)
+/* Minimal jpeg_mem_src() for libjpeg 6b/7, which only read from stdio */
+static void mem_src_init(j_decompress_ptr cinfo)
+{
+    (void)cinfo;
+}
+
+static boolean mem_src_fill(j_decompress_ptr cinfo)
+{
+    /* Past the end: feed an EOI marker so a truncated file ends as a warning, like libjpeg's own sources */
+    static const JOCTET eoi[2] = {0xFF, JPEG_EOI};
+    cinfo->src->next_input_byte = eoi;
+    cinfo->src->bytes_in_buffer = 2;
+    return TRUE;
+}
+
+static void mem_src_skip(j_decompress_ptr cinfo, long num_bytes)
+{
+    struct jpeg_source_mgr* src = cinfo->src;
+    if (num_bytes <= 0)
+    {
+        return;
+    }
+    if ((size_t)num_bytes > src->bytes_in_buffer)
+    {
+        mem_src_fill(cinfo);
+        return;
+    }
+    src->next_input_byte += num_bytes;
+    src->bytes_in_buffer -= (size_t)num_bytes;
+}
+
+static void mem_src_term(j_decompress_ptr cinfo)
+{
+    (void)cinfo;
+}
+
+static void jpeg_mem_src(j_decompress_ptr cinfo, const unsigned char* buffer, unsigned long size)
+{
+    struct jpeg_source_mgr* src = (struct jpeg_source_mgr*)(*cinfo->mem->alloc_small)(
+        (j_common_ptr)cinfo, JPOOL_PERMANENT, sizeof(struct jpeg_source_mgr));
+    src->init_source = mem_src_init;
+    src->fill_input_buffer = mem_src_fill;
+    src->skip_input_data = mem_src_skip;
+    src->resync_to_restart = jpeg_resync_to_restart;
+    src->term_source = mem_src_term;
+    src->next_input_byte = (const JOCTET*)buffer;
+    src->bytes_in_buffer = (size_t)size;
+    cinfo->src = src;
+}
+#endif
+
+static JpegDecoder* jpeg_decoder_new(GBytes* data)
+{
+    gsize size = 0;
+    const guint8* bytes = (const guint8*)g_bytes_get_data(data, &size);
+    /* jpeg_mem_src() raises an error on empty input, and no error handler is armed yet */
+    if (size == 0)
+    {
+        return NULL;
+    }
+
+    JpegDecoder* dec = g_new0(JpegDecoder, 1);
+    dec->data = g_bytes_ref(data);
+    dec->cinfo.err = jpeg_std_error(&dec->err.pub);
+    dec->err.pub.error_exit = jpeg_error_exit;
+    dec->err.pub.output_message = jpeg_output_message;
+    jpeg_create_decompress(&dec->cinfo);
+    /* Older jpeg_mem_src() prototypes take a non-const buffer; it is only read */
+    jpeg_mem_src(&dec->cinfo, (unsigned char*)bytes, (unsigned long)size);
+    return dec;
+}
+
+/* Smallest n with ceil(size * n / 8) >= min in both dimensions; 8 (no scaling) if min is unset or larger */
+static guint jpeg_scale_num(gint image_w, gint image_h, gint min_w, gint min_h)
+{
+    if (min_w <= 0 || min_h <= 0)
+    {
+        return 8;
+    }
+    for (guint num = 1; num < 8; ++num)
+    {
+        if (((gint64)image_w * num + 7) / 8 >= min_w && ((gint64)image_h * num + 7) / 8 >= min_h)
+        {
+            return num;
+        }
+    }
+    return 8;
+}
+
+/* Sets DCT-domain downscaling and computes the output size; call after choosing out_color_space */
+static void jpeg_apply_scale(j_decompress_ptr cinfo, gint min_w, gint min_h)
+{
+    cinfo->scale_num = jpeg_scale_num((gint)cinfo->image_width, (gint)cinfo->image_height, min_w, min_h);
+    cinfo->scale_denom = 8;
+    jpeg_calc_output_dimensions(cinfo);
+}
+
+static void jpeg_decoder_free(JpegDecoder* dec)
+{
+    jpeg_destroy_decompress(&dec->cinfo);
+    g_bytes_unref(dec->data);
+    g_free(dec->pixels);
+    g_free(dec->scratch);
+    g_free(dec);
+}
+
+/* 4:2:0 YCbCr, the only layout the raw-data path copies straight into I420/NV12/NV21 */
+static gboolean jpeg_is_yuv420(j_decompress_ptr cinfo)
+{
+    return cinfo->jpeg_color_space == JCS_YCbCr && cinfo->num_components == 3 &&
+           cinfo->comp_info[0].h_samp_factor == 2 && cinfo->comp_info[0].v_samp_factor == 2 &&
+           cinfo->comp_info[1].h_samp_factor == 1 && cinfo->comp_info[1].v_samp_factor == 1 &&
+           cinfo->comp_info[2].h_samp_factor == 1 && cinfo->comp_info[2].v_samp_factor == 1;
+}
+
+/*
+ * Picks dec->layout for a width x height decode: the caller's layout if it
+ * has that size (FALSE if not), otherwise the packed one. Allocates pixels,
+ * zeroed if the layout has row padding.
+ */
+static gboolean jpeg_alloc_output(JpegDecoder* dec, const gchar* format, const StaticImageFrameLayout* want, gint width,
+                                  gint height)
+{
+    StaticImageFrameLayout packed;
+    if (!static_image_frame_layout_init(&packed, format, width, height))
+    {
+        return FALSE;
+    }
+    if (want != NULL && (want->width != width || want->height != height))
+    {
+        return FALSE;
+    }
+    dec->layout = want != NULL ? *want : packed;
+    dec->pixels = (guint8*)(dec->layout.size != packed.size ? g_malloc0(dec->layout.size) : g_malloc(dec->layout.size));
+    return TRUE;
+}
+
+/* Decodes into dec->pixels as tightly packed 4-byte pixels; only RGBA without libjpeg-turbo's extensions */
+static gboolean jpeg_read_packed(JpegDecoder* dec, const gchar* format, const StaticImageFrameLayout* want, gint min_w,
+                                 gint min_h)
+{
+    j_decompress_ptr cinfo = &dec->cinfo;
+
+#ifdef HAVE_JPEG_ALPHA_EXTENSIONS
+    if (g_strcmp0(format, "RGBA") == 0)
+    {
+        cinfo->out_color_space = JCS_EXT_RGBA;
+    }
+    else if (g_strcmp0(format, "BGRA") == 0)
+    {
+        cinfo->out_color_space = JCS_EXT_BGRA;
+    }
+    else if (g_strcmp0(format, "ARGB") == 0)
+    {
+        cinfo->out_color_space = JCS_EXT_ARGB;
+    }
+    else if (g_strcmp0(format, "ABGR") == 0)
+    {
+        cinfo->out_color_space = JCS_EXT_ABGR;
+    }
+    else
+    {
+        return FALSE;
+    }
+#else
+    if (g_strcmp0(format, "RGBA") != 0)
+    {
+        return FALSE;
+    }
+    cinfo->out_color_space = JCS_RGB;
+#endif
+
+    jpeg_apply_scale(cinfo, min_w, min_h);
+    jpeg_start_decompress(cinfo);
+
+    const gint width = (gint)cinfo->output_width;
+    const gint height = (gint)cinfo->output_height;
+    if (!jpeg_alloc_output(dec, format, want, width, height))
+    {
+        return FALSE;
+    }
+    const gsize stride = (gsize)dec->layout.strides[0];
+
+#ifdef HAVE_JPEG_ALPHA_EXTENSIONS
+    /* The decoder writes the final layout itself, several rows per call */
+    while (cinfo->output_scanline < cinfo->output_height)
+    {
+        JSAMPROW rows[16];
+        const gint n_rows = MIN(16, height - (gint)cinfo->output_scanline);
+        for (gint i = 0; i < n_rows; ++i)
+        {
+            rows[i] = dec->pixels + (gsize)(cinfo->output_scanline + i) * stride;
+        }
+        jpeg_read_scanlines(cinfo, rows, (JDIMENSION)n_rows);
+    }
+#else
+    JSAMPARRAY buffer = (*cinfo->mem->alloc_sarray)((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                                     cinfo->output_width * cinfo->output_components, 1);
+    while (cinfo->output_scanline < cinfo->output_height)
+    {
+        guint8* dst = dec->pixels + (gsize)cinfo->output_scanline * stride;
+        jpeg_read_scanlines(cinfo, buffer, 1);
+
+        const guint8* src = buffer[0];
+        for (gint x = 0; x < width; ++x)
+        {
+            dst[x * 4 + 0] = src[x * 3 + 0];
+            dst[x * 4 + 1] = src[x * 3 + 1];
+            dst[x * 4 + 2] = src[x * 3 + 2];
+            dst[x * 4 + 3] = 255;
+        }
+    }
+#endif
+
+    jpeg_finish_decompress(cinfo);
+    return TRUE;
+}
+
+/* JFIF samples are full range; for limited-range output the raw planes are remapped to match the RGBA converters */
+static void build_range_luts(gboolean full_range, guint8 luma[256], guint8 chroma[256])
+{
+    for (gint i = 0; i < 256; ++i)
+    {
+        if (full_range)
+        {
+            luma[i] = (guint8)i;
+            chroma[i] = (guint8)i;
+            continue;
+        }
+        luma[i] = (guint8)(16 + (i * 219 + 127) / 255);
+        const gint c = (i - 128) * 224;
+        chroma[i] = (guint8)(128 + (c >= 0 ? c + 127 : c - 127) / 255);
+    }
+}
+
+static inline void copy_row_lut(guint8* dst, const guint8* src, gint width, const guint8 lut[256])
+{
+    for (gint x = 0; x < width; ++x)
+    {
+        dst[x] = lut[src[x]];
+    }
+}
+
+/* Averages 2x2 blocks of two full-resolution chroma rows down to one 4:2:0 row */
+static inline void halve_chroma_row(guint8* dst, const guint8* row0, const guint8* row1, gint width)
+{
+    for (gint x = 0; x < width; ++x)
+    {
+        dst[x] = (guint8)((row0[x * 2] + row0[x * 2 + 1] + row1[x * 2] + row1[x * 2 + 1] + 2) >> 2);
+    }
+}
+
+/* Takes the 4:2:0 planes straight from the decoder (no colour conversion or upsampling) into I420/NV12/NV21 */
+static gboolean jpeg_read_yuv420(JpegDecoder* dec, const gchar* format, gboolean full_range,
+                                 const StaticImageFrameLayout* want, gint min_w, gint min_h)
+{
+    j_decompress_ptr cinfo = &dec->cinfo;
+    const gboolean nv12 = g_strcmp0(format, "NV12") == 0;
+    const gboolean nv21 = g_strcmp0(format, "NV21") == 0;
+    if ((!nv12 && !nv21 && g_strcmp0(format, "I420") != 0) || !jpeg_is_yuv420(cinfo))
+    {
+        return FALSE;
+    }
+
+    cinfo->out_color_space = JCS_YCbCr;
+    cinfo->raw_data_out = TRUE;
+    cinfo->do_fancy_upsampling = FALSE;
+    jpeg_apply_scale(cinfo, min_w, min_h);
+
+    /*
+     * At small scales libjpeg-turbo decodes chroma with a doubled DCT size, so
+     * it comes out at full resolution and is averaged back down here.
+     */
+    const gint width = (gint)cinfo->output_width;
+    const gint height = (gint)cinfo->output_height;
+    const jpeg_component_info* comp = cinfo->comp_info;
+    const gint block = JPEG_MIN_V_SCALED_SIZE(cinfo);
+    const gint chroma_ratio = JPEG_COMP_V_SCALED_SIZE(&comp[1]) / block;
+    if ((chroma_ratio != 1 && chroma_ratio != 2) ||
+        JPEG_COMP_H_SCALED_SIZE(&comp[1]) != JPEG_COMP_V_SCALED_SIZE(&comp[1]) ||
+        JPEG_COMP_H_SCALED_SIZE(&comp[0]) != block || JPEG_COMP_V_SCALED_SIZE(&comp[0]) != block ||
+        (gint)comp[0].downsampled_width != width || (gint)comp[0].downsampled_height != height)
+    {
+        return FALSE;
+    }
+
+    if (!jpeg_alloc_output(dec, format, want, width, height))
+    {
+        return FALSE;
+    }
+    const StaticImageFrameLayout layout = dec->layout;
+    jpeg_start_decompress(cinfo);
+
+    /* One iMCU row per read (16 luma and 8 chroma rows unscaled), padded to whole blocks */
+    const gint band_rows = 2 * block;
+    const gint chroma_band_rows = block * chroma_ratio;
+    const gint chroma_w = (width + 1) / 2;
+    const gint chroma_h = (height + 1) / 2;
+    const gsize y_raw = (gsize)comp[0].width_in_blocks * block;
+    const gsize c_raw = (gsize)comp[1].width_in_blocks * block * chroma_ratio;
+    dec->scratch = (guint8*)g_malloc(y_raw * band_rows + c_raw * chroma_band_rows * 2 + (gsize)chroma_w * 2);
+
+    JSAMPROW y_rows[2 * DCTSIZE];
+    JSAMPROW u_rows[2 * DCTSIZE];
+    JSAMPROW v_rows[2 * DCTSIZE];
+    for (gint i = 0; i < band_rows; ++i)
+    {
+        y_rows[i] = dec->scratch + (gsize)i * y_raw;
+    }
+    guint8* chroma_base = dec->scratch + y_raw * band_rows;
+    for (gint i = 0; i < chroma_band_rows; ++i)
+    {
+        u_rows[i] = chroma_base + (gsize)i * c_raw;
+        v_rows[i] = chroma_base + (gsize)(chroma_band_rows + i) * c_raw;
+    }
+    guint8* halved_u = chroma_base + c_raw * chroma_band_rows * 2;
+    guint8* halved_v = halved_u + chroma_w;
+    JSAMPARRAY planes[3] = {y_rows, u_rows, v_rows};
+
+    guint8 luma_lut[256];
+    guint8 chroma_lut[256];
+    build_range_luts(full_range, luma_lut, chroma_lut);
+
+    while (cinfo->output_scanline < cinfo->output_height)
+    {
+        const gint band_y = (gint)cinfo->output_scanline;
+        if (jpeg_read_raw_data(cinfo, planes, (JDIMENSION)band_rows) == 0)
+        {
+            return FALSE;
+        }
+
+        const gint n_rows = MIN(band_rows, height - band_y);
+        for (gint i = 0; i < n_rows; ++i)
+        {
+            copy_row_lut(dec->pixels + layout.offsets[0] + (gsize)(band_y + i) * layout.strides[0], y_rows[i], width,
+                         luma_lut);
+        }
+
+        const gint chroma_y = band_y / 2;
+        const gint n_chroma_rows = MIN(block, chroma_h - chroma_y);
+        for (gint i = 0; i < n_chroma_rows; ++i)
+        {
+            const gsize row = (gsize)(chroma_y + i);
+            const guint8* u = u_rows[i];
+            const guint8* v = v_rows[i];
+            if (chroma_ratio == 2)
+            {
+                halve_chroma_row(halved_u, u_rows[i * 2], u_rows[i * 2 + 1], chroma_w);
+                halve_chroma_row(halved_v, v_rows[i * 2], v_rows[i * 2 + 1], chroma_w);
+                u = halved_u;
+                v = halved_v;
+            }
+
+            if (nv12 || nv21)
+            {
+                guint8* dst = dec->pixels + layout.offsets[1] + row * layout.strides[1];
+                const guint8* first = nv12 ? u : v;
+                const guint8* second = nv12 ? v : u;
+                for (gint x = 0; x < chroma_w; ++x)
+                {
+                    dst[x * 2 + 0] = chroma_lut[first[x]];
+                    dst[x * 2 + 1] = chroma_lut[second[x]];
+                }
+            }
+            else
+            {
+                copy_row_lut(dec->pixels + layout.offsets[1] + row * layout.strides[1], u, chroma_w, chroma_lut);
+                copy_row_lut(dec->pixels + layout.offsets[2] + row * layout.strides[2], v, chroma_w, chroma_lut);
+            }
+        }
+    }
+
+    jpeg_finish_decompress(cinfo);
+    return TRUE;
+}
+
+gboolean static_image_decode_jpeg_size(GBytes* data, gint* out_w, gint* out_h)
+{
+    JpegDecoder* dec = jpeg_decoder_new(data);
+    if (dec == NULL)
+    {
+        return FALSE;
+    }
+    if (setjmp(dec->err.jump))
+    {
+        jpeg_decoder_free(dec);
+        return FALSE;
+    }
+
+    gboolean ok = jpeg_read_header(&dec->cinfo, TRUE) == JPEG_HEADER_OK;
+    if (ok)
+    {
+        *out_w = (gint)dec->cinfo.image_width;
+        *out_h = (gint)dec->cinfo.image_height;
+    }
+
+    jpeg_decoder_free(dec);
+    return ok && *out_w > 0 && *out_h > 0;
+}
+
+void static_image_decode_jpeg_scaled_size(gint image_w, gint image_h, gint min_w, gint min_h, gint* out_w,
+                                          gint* out_h)
+{
+    const guint num = jpeg_scale_num(image_w, image_h, min_w, min_h);
+    *out_w = (gint)(((gint64)image_w * num + 7) / 8);
+    *out_h = (gint)(((gint64)image_h * num + 7) / 8);
+}
+
+gboolean static_image_decode_jpeg(GBytes* data, gint min_w, gint min_h, guint8** out_pixels, gint* out_w,
+                                  gint* out_h)
+{
+    gsize size = 0;
+    return static_image_decode_jpeg_to_format(data, "RGBA", FALSE, NULL, min_w, min_h, out_pixels, &size, out_w,
+                                              out_h);
+}
+
+gboolean static_image_decode_jpeg_to_format(GBytes* data, const gchar* format, gboolean full_range,
+                                            const StaticImageFrameLayout* layout, gint min_w, gint min_h,
+                                            guint8** out_pixels, gsize* out_size, gint* out_w, gint* out_h)
+{
+    *out_pixels = NULL;
+    *out_size = 0;
+    *out_w = 0;
+    *out_h = 0;
+
+    JpegDecoder* dec = jpeg_decoder_new(data);
+    if (dec == NULL)
+    {
+        return FALSE;
+    }
+    if (setjmp(dec->err.jump))
+    {
+        jpeg_decoder_free(dec);
+        return FALSE;
+    }
+
+    if (jpeg_read_header(&dec->cinfo, TRUE) != JPEG_HEADER_OK)
+    {
+        jpeg_decoder_free(dec);
+        return FALSE;
+    }
+
+    gboolean ok = static_image_convert_is_yuv(format)
+                      ? jpeg_read_yuv420(dec, format, full_range, layout, min_w, min_h)
+                      : jpeg_read_packed(dec, format, layout, min_w, min_h);
+    if (ok)
+    {
+        *out_pixels = dec->pixels;
+        *out_size = dec->layout.size;
+        *out_w = (gint)dec->cinfo.output_width;
+        *out_h = (gint)dec->cinfo.output_height;
+        dec->pixels = NULL;
+    }
+
+    jpeg_decoder_free(dec);
+    return ok;
+}
+
+gboolean static_image_decode_jpeg_rows(GBytes* data, gint min_w, gint min_h, StaticImageDecodeRowFunc func,
+                                       gpointer user_data)
+{
+    JpegDecoder* dec = jpeg_decoder_new(data);
+    if (dec == NULL)
+    {
+        return FALSE;
+    }
+    if (setjmp(dec->err.jump))
+    {
+        jpeg_decoder_free(dec);
+        return FALSE;
+    }
+
+    j_decompress_ptr cinfo = &dec->cinfo;
+    if (jpeg_read_header(cinfo, TRUE) != JPEG_HEADER_OK)
+    {
+        jpeg_decoder_free(dec);
+        return FALSE;
+    }
+#ifdef HAVE_JPEG_ALPHA_EXTENSIONS
+    cinfo->out_color_space = JCS_EXT_RGBA;
+#else
+    cinfo->out_color_space = JCS_RGB;
+#endif
+    jpeg_apply_scale(cinfo, min_w, min_h);
+    jpeg_start_decompress(cinfo);
+
+    const gint width = (gint)cinfo->output_width;
+    dec->scratch = (guint8*)g_malloc((gsize)width * 4);
+#ifdef HAVE_JPEG_ALPHA_EXTENSIONS
+    JSAMPROW row = dec->scratch;
+    while (cinfo->output_scanline < cinfo->output_height)
+    {
+        jpeg_read_scanlines(cinfo, &row, 1);
+        func(dec->scratch, user_data);
+    }
+#else
+    JSAMPARRAY buffer = (*cinfo->mem->alloc_sarray)((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                                     cinfo->output_width * cinfo->output_components, 1);
+    while (cinfo->output_scanline < cinfo->output_height)
+    {
+        jpeg_read_scanlines(cinfo, buffer, 1);
+
+        const guint8* src = buffer[0];
+        guint8* dst = dec->scratch;
+        for (gint x = 0; x < width; ++x)
+        {
+            dst[x * 4 + 0] = src[x * 3 + 0];
+            dst[x * 4 + 1] = src[x * 3 + 1];
+            dst[x * 4 + 2] = src[x * 3 + 2];
+            dst[x * 4 + 3] = 255;
+        }
+        func(dec->scratch, user_data);
+    }
+#endif
+
+    jpeg_finish_decompress(cinfo);
+    jpeg_decoder_free(dec);
+    return TRUE;
+}
@@ -0,0 +1,89 @@
+/*
+ * Static Image Source - PNG and JPEG decoding to RGBA
+ */
+
+#ifndef __GST_STATIC_IMAGE_DECODE_H__
+#define __GST_STATIC_IMAGE_DECODE_H__
+
+#include "gststaticimageconvert.h"
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Maps the file read-only and returns its contents, or NULL if it cannot be
+ * opened. The decoders below all work on encoded bytes in memory, either such
+ * a mapping or data supplied by the application.
+ */
+GBytes* static_image_decode_map_file(const gchar* path);
+
+/*
+ * Reads the whole file into memory instead, for files that may be rewritten
+ * while in use: a mapping of a file truncated underneath it faults on access.
+ */
+GBytes* static_image_decode_read_file(const gchar* path);
+
+/* Checks the signature at the start of the data */
+gboolean static_image_decode_is_png(GBytes* data);
+gboolean static_image_decode_is_jpeg(GBytes* data);
+
+/* Reads only the image header; returns FALSE if the data is not a valid image */
+gboolean static_image_decode_png_size(GBytes* data, gint* out_w, gint* out_h);
+gboolean static_image_decode_jpeg_size(GBytes* data, gint* out_w, gint* out_h);
+
+/*
+ * Decodes the whole image into tightly packed RGBA (stride = width * 4), freed
+ * with g_free(). Palette, grey and 16-bit PNGs are expanded; images without
+ * alpha get 0xFF.
+ */
+gboolean static_image_decode_png(GBytes* data, guint8** out_pixels, gint* out_w, gint* out_h);
+
+/*
+ * As above for JPEG. With min_w/min_h > 0 the image is downscaled in the DCT
+ * domain by the smallest n/8 that still yields at least min_w x min_h, which
+ * cuts decode time and memory for large photos; the caller resizes the rest.
+ */
+gboolean static_image_decode_jpeg(GBytes* data, gint min_w, gint min_h, guint8** out_pixels, gint* out_w,
+                                  gint* out_h);
+
+/* Size static_image_decode_jpeg() produces for an image_w x image_h file and the given minimum */
+void static_image_decode_jpeg_scaled_size(gint image_w, gint image_h, gint min_w, gint min_h, gint* out_w,
+                                          gint* out_h);
+
+/*
+ * Decodes a JPEG straight into an output format, with no RGBA intermediate.
+ * With a layout the frame is written in it (strides and plane offsets) and
+ * the decode fails unless it comes out at the layout's size; NULL lays it out
+ * as static_image_frame_layout_init() does. "RGBA",
+ * "BGRA", "ARGB" and "ABGR" come from libjpeg-turbo's extended colour spaces;
+ * "I420", "NV12" and "NV21" are the raw 4:2:0 YCbCr planes, which are BT.601:
+ * kept as they are with full_range, otherwise remapped to limited range like
+ * the RGBA converters produce. Returns FALSE for other formats, when libjpeg
+ * lacks the extensions or the image is not 4:2:0 (for YUV), so the caller can
+ * fall back to RGBA and convert. min_w/min_h select DCT scaling as for
+ * static_image_decode_jpeg().
+ */
+gboolean static_image_decode_jpeg_to_format(GBytes* data, const gchar* format, gboolean full_range,
+                                            const StaticImageFrameLayout* layout, gint min_w, gint min_h,
+                                            guint8** out_pixels, gsize* out_size, gint* out_w, gint* out_h);
+
+/* Receives one decoded row of tightly packed RGBA, valid only during the call */
+typedef void (*StaticImageDecodeRowFunc)(const guint8* row, gpointer user_data);
+
+/*
+ * Row-at-a-time forms of static_image_decode_png() and
+ * static_image_decode_jpeg() for the low-memory path: rows go to func top
+ * to bottom as they are decoded, so only a row is buffered instead of the
+ * whole image. The image size is the one the _size() functions (and, for
+ * JPEG, static_image_decode_jpeg_scaled_size()) report. Interlaced PNGs are
+ * the exception: no row is final before the last pass, so they are decoded
+ * whole first. On failure func may already have seen some of the rows.
+ */
+gboolean static_image_decode_png_rows(GBytes* data, StaticImageDecodeRowFunc func, gpointer user_data);
+gboolean static_image_decode_jpeg_rows(GBytes* data, gint min_w, gint min_h, StaticImageDecodeRowFunc func,
+                                       gpointer user_data);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_DECODE_H__ */
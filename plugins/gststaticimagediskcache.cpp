@@ -0,0 +1,171 @@
+/*
+ * Static Image Source - persistent cache of converted frames
+ *
+ * One file per frame, named by the SHA-256 of its key. A fixed header (plus
+ * the key itself) is padded to a page boundary so the mmapped payload is page
+ * aligned. The header is host-endian; the cache is not meant to be shared
+ * between machines.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimagediskcache.h"
+
+#include <glib/gstdio.h>
+
+#include <cstdio>
+#include <cstring>
+
+#define DISK_CACHE_MAGIC "SIMGFRM1"
+#define DISK_CACHE_PAYLOAD_ALIGN 4096
+
+typedef struct
+{
+    gchar magic[8];
+    guint32 header_size; /* payload offset */
+    guint32 key_length;  /* key bytes follow this struct */
+    guint8 key_hash[32];
+    gint32 width;
+    gint32 height;
+    gchar format[8];
+    guint32 n_planes;
+    gint32 strides[STATIC_IMAGE_MAX_PLANES];
+    guint64 offsets[STATIC_IMAGE_MAX_PLANES];
+    guint64 payload_size;
+} DiskCacheHeader;
+
+static gchar* cache_file_path(const gchar* cache_dir, const gchar* key)
+{
+    gchar* hash = g_compute_checksum_for_string(G_CHECKSUM_SHA256, key, -1);
+    gchar* name = g_strconcat(hash, ".frame", NULL);
+    gchar* path = g_build_filename(cache_dir, name, NULL);
+    g_free(name);
+    g_free(hash);
+    return path;
+}
+
+/* Builds the header a valid file for this frame must start with; padding bytes stay zero so it compares with memcmp */
+static void fill_header(DiskCacheHeader* header, const gchar* key, const gchar* format,
+                        const StaticImageFrameLayout* layout)
+{
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, DISK_CACHE_MAGIC, sizeof(header->magic));
+
+    const gsize key_length = strlen(key);
+    header->key_length = (guint32)key_length;
+    header->header_size =
+        (guint32)((sizeof(*header) + key_length + DISK_CACHE_PAYLOAD_ALIGN - 1) / DISK_CACHE_PAYLOAD_ALIGN *
+                  DISK_CACHE_PAYLOAD_ALIGN);
+
+    GChecksum* checksum = g_checksum_new(G_CHECKSUM_SHA256);
+    g_checksum_update(checksum, (const guchar*)key, (gssize)key_length);
+    gsize digest_len = sizeof(header->key_hash);
+    g_checksum_get_digest(checksum, header->key_hash, &digest_len);
+    g_checksum_free(checksum);
+
+    header->width = layout->width;
+    header->height = layout->height;
+    g_strlcpy(header->format, format, sizeof(header->format));
+    header->n_planes = layout->n_planes;
+    for (guint i = 0; i < STATIC_IMAGE_MAX_PLANES; ++i)
+    {
+        header->strides[i] = layout->strides[i];
+        header->offsets[i] = layout->offsets[i];
+    }
+    header->payload_size = layout->size;
+}
+
+GstMemory* static_image_disk_cache_load(const gchar* cache_dir, const gchar* key, const gchar* format,
+                                        const StaticImageFrameLayout* layout)
+{
+    g_return_val_if_fail(cache_dir != NULL && key != NULL && format != NULL && layout != NULL, NULL);
+
+    gchar* path = cache_file_path(cache_dir, key);
+    GMappedFile* mapped = g_mapped_file_new(path, FALSE, NULL);
+    g_free(path);
+    if (mapped == NULL)
+    {
+        return NULL;
+    }
+
+    DiskCacheHeader expected;
+    fill_header(&expected, key, format, layout);
+
+    const gchar* contents = g_mapped_file_get_contents(mapped);
+    const gsize length = g_mapped_file_get_length(mapped);
+    if (contents == NULL || length != (gsize)expected.header_size + layout->size ||
+        memcmp(contents, &expected, sizeof(expected)) != 0 ||
+        memcmp(contents + sizeof(expected), key, expected.key_length) != 0)
+    {
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    return gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY, (gpointer)contents, length, expected.header_size,
+                                  layout->size, mapped, (GDestroyNotify)g_mapped_file_unref);
+}
+
+gboolean static_image_disk_cache_store(const gchar* cache_dir, const gchar* key, const gchar* format,
+                                       const StaticImageFrameLayout* layout, GstMemory* memory)
+{
+    g_return_val_if_fail(cache_dir != NULL && key != NULL && format != NULL && layout != NULL && memory != NULL,
+                         FALSE);
+
+    if (g_mkdir_with_parents(cache_dir, 0755) != 0)
+    {
+        return FALSE;
+    }
+
+    GstMapInfo map;
+    if (!gst_memory_map(memory, &map, GST_MAP_READ))
+    {
+        return FALSE;
+    }
+    if (map.size != layout->size)
+    {
+        gst_memory_unmap(memory, &map);
+        return FALSE;
+    }
+
+    DiskCacheHeader header;
+    fill_header(&header, key, format, layout);
+    guint8* head = (guint8*)g_malloc0(header.header_size);
+    memcpy(head, &header, sizeof(header));
+    memcpy(head + sizeof(header), key, header.key_length);
+
+    gchar* path = cache_file_path(cache_dir, key);
+    gchar* tmp_path = g_strconcat(path, ".XXXXXX", NULL);
+    gboolean ok = FALSE;
+    gint fd = g_mkstemp(tmp_path);
+    if (fd >= 0)
+    {
+        FILE* fp = fdopen(fd, "wb");
+        if (fp != NULL)
+        {
+            ok = fwrite(head, 1, header.header_size, fp) == header.header_size &&
+                 fwrite(map.data, 1, map.size, fp) == map.size;
+            ok = fclose(fp) == 0 && ok;
+        }
+        else
+        {
+            g_close(fd, NULL);
+        }
+
+        if (ok)
+        {
+            ok = g_chmod(tmp_path, 0644) == 0 && g_rename(tmp_path, path) == 0;
+        }
+        if (!ok)
+        {
+            g_unlink(tmp_path);
+        }
+    }
+
+    g_free(tmp_path);
+    g_free(path);
+    g_free(head);
+    gst_memory_unmap(memory, &map);
+    return ok;
+}
@@ -0,0 +1,33 @@
+/*
+ * Static Image Source - persistent cache of converted frames
+ */
+
+#ifndef __GST_STATIC_IMAGE_DISK_CACHE_H__
+#define __GST_STATIC_IMAGE_DISK_CACHE_H__
+
+#include "gststaticimageconvert.h"
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Looks up the frame stored under key in cache_dir. On a hit the file is
+ * mmapped and its payload wrapped as a read-only GstMemory without copying;
+ * the mapping is released with the last memory ref. Returns NULL on a miss or
+ * if the file's header does not match key, format and layout.
+ */
+GstMemory* static_image_disk_cache_load(const gchar* cache_dir, const gchar* key, const gchar* format,
+                                        const StaticImageFrameLayout* layout);
+
+/*
+ * Writes memory as the frame for key, creating cache_dir if needed. The file
+ * is written under a temporary name and renamed into place, so concurrent
+ * readers and writers never see a partial frame.
+ */
+gboolean static_image_disk_cache_store(const gchar* cache_dir, const gchar* key, const gchar* format,
+                                       const StaticImageFrameLayout* layout, GstMemory* memory);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_DISK_CACHE_H__ */
@@ -0,0 +1,206 @@
+/*
+ * Static Image Source - RGBA encoding to JPEG and PNG
+ *
+ * Only used when downstream asked for compressed caps at a size other than
+ * the image's own, so the encoded frame is made once and then pushed like
+ * any other. Both encoders write into a growing GByteArray; errors longjmp
+ * back into the encode call as they do when decoding.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimageencode.h"
+
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <jpeglib.h>
+#include <png.h>
+
+#define ENCODE_CHUNK 65536
+
+#if defined(JCS_EXTENSIONS) && defined(JCS_ALPHA_EXTENSIONS)
+#define HAVE_JPEG_ALPHA_EXTENSIONS 1
+#endif
+
+typedef struct
+{
+    struct jpeg_error_mgr pub;
+    jmp_buf jump;
+} JpegErrorMgr;
+
+typedef struct
+{
+    struct jpeg_destination_mgr pub;
+    GByteArray* out;
+    gsize used; /* bytes of out already written */
+} JpegDestination;
+
+typedef struct
+{
+    struct jpeg_compress_struct cinfo;
+    JpegErrorMgr err;
+    JpegDestination dest;
+    guint8* row; /* RGB conversion of one row, without the alpha extensions */
+} JpegEncoder;
+
+static void jpeg_error_exit(j_common_ptr cinfo)
+{
+    JpegErrorMgr* err = (JpegErrorMgr*)cinfo->err;
+    longjmp(err->jump, 1);
+}
+
+static void jpeg_output_message(j_common_ptr cinfo)
+{
+    (void)cinfo;
+}
+
+static void dest_init(j_compress_ptr cinfo)
+{
+    JpegDestination* dest = (JpegDestination*)cinfo->dest;
+    g_byte_array_set_size(dest->out, ENCODE_CHUNK);
+    dest->used = 0;
+    dest->pub.next_output_byte = dest->out->data;
+    dest->pub.free_in_buffer = dest->out->len;
+}
+
+/* The whole buffer is full: keep it and hand libjpeg the next chunk */
+static boolean dest_empty(j_compress_ptr cinfo)
+{
+    JpegDestination* dest = (JpegDestination*)cinfo->dest;
+    dest->used = dest->out->len;
+    g_byte_array_set_size(dest->out, dest->out->len * 2);
+    dest->pub.next_output_byte = dest->out->data + dest->used;
+    dest->pub.free_in_buffer = dest->out->len - dest->used;
+    return TRUE;
+}
+
+static void dest_term(j_compress_ptr cinfo)
+{
+    JpegDestination* dest = (JpegDestination*)cinfo->dest;
+    g_byte_array_set_size(dest->out, dest->out->len - (guint)dest->pub.free_in_buffer);
+}
+
+gboolean static_image_encode_jpeg(const guint8* rgba, gint width, gint height, gint quality, guint8** out_data,
+                                  gsize* out_size)
+{
+    *out_data = NULL;
+    *out_size = 0;
+    g_return_val_if_fail(rgba != NULL && width > 0 && height > 0, FALSE);
+
+    JpegEncoder* enc = g_new0(JpegEncoder, 1);
+    enc->dest.out = g_byte_array_new();
+    enc->cinfo.err = jpeg_std_error(&enc->err.pub);
+    enc->err.pub.error_exit = jpeg_error_exit;
+    enc->err.pub.output_message = jpeg_output_message;
+
+    if (setjmp(enc->err.jump))
+    {
+        jpeg_destroy_compress(&enc->cinfo);
+        g_byte_array_unref(enc->dest.out);
+        g_free(enc->row);
+        g_free(enc);
+        return FALSE;
+    }
+
+    jpeg_create_compress(&enc->cinfo);
+    enc->dest.pub.init_destination = dest_init;
+    enc->dest.pub.empty_output_buffer = dest_empty;
+    enc->dest.pub.term_destination = dest_term;
+    enc->cinfo.dest = &enc->dest.pub;
+
+    enc->cinfo.image_width = (JDIMENSION)width;
+    enc->cinfo.image_height = (JDIMENSION)height;
+#ifdef HAVE_JPEG_ALPHA_EXTENSIONS
+    enc->cinfo.input_components = 4;
+    enc->cinfo.in_color_space = JCS_EXT_RGBA;
+#else
+    enc->cinfo.input_components = 3;
+    enc->cinfo.in_color_space = JCS_RGB;
+    enc->row = (guint8*)g_malloc((gsize)width * 3);
+#endif
+    jpeg_set_defaults(&enc->cinfo);
+    jpeg_set_quality(&enc->cinfo, CLAMP(quality, 1, 100), TRUE);
+    jpeg_start_compress(&enc->cinfo, TRUE);
+
+    const gsize stride = (gsize)width * 4;
+    while (enc->cinfo.next_scanline < enc->cinfo.image_height)
+    {
+        const guint8* src = rgba + (gsize)enc->cinfo.next_scanline * stride;
+#ifdef HAVE_JPEG_ALPHA_EXTENSIONS
+        JSAMPROW row = (JSAMPROW)src;
+#else
+        for (gint x = 0; x < width; ++x)
+        {
+            memcpy(enc->row + (gsize)x * 3, src + (gsize)x * 4, 3);
+        }
+        JSAMPROW row = enc->row;
+#endif
+        jpeg_write_scanlines(&enc->cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&enc->cinfo);
+    jpeg_destroy_compress(&enc->cinfo);
+
+    *out_size = enc->dest.out->len;
+    *out_data = g_byte_array_free(enc->dest.out, FALSE);
+    g_free(enc->row);
+    g_free(enc);
+    return TRUE;
+}
+
+static void png_write_to_array(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+    g_byte_array_append((GByteArray*)png_get_io_ptr(png_ptr), data, (guint)length);
+}
+
+static void png_flush_array(png_structp png_ptr)
+{
+    (void)png_ptr;
+}
+
+gboolean static_image_encode_png(const guint8* rgba, gint width, gint height, guint8** out_data, gsize* out_size)
+{
+    *out_data = NULL;
+    *out_size = 0;
+    g_return_val_if_fail(rgba != NULL && width > 0 && height > 0, FALSE);
+
+    png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop info_ptr = png_ptr != NULL ? png_create_info_struct(png_ptr) : NULL;
+    if (!info_ptr)
+    {
+        png_destroy_write_struct(&png_ptr, NULL);
+        return FALSE;
+    }
+
+    /* Locals touched after setjmp must be volatile to survive the jump */
+    GByteArray* volatile out = g_byte_array_sized_new(ENCODE_CHUNK);
+    png_bytep* volatile row_pointers = NULL;
+    if (setjmp(png_jmpbuf(png_ptr)))
+    {
+        g_free(row_pointers);
+        g_byte_array_unref(out);
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        return FALSE;
+    }
+
+    png_set_write_fn(png_ptr, out, png_write_to_array, png_flush_array);
+    png_set_IHDR(png_ptr, info_ptr, (png_uint_32)width, (png_uint_32)height, 8, PNG_COLOR_TYPE_RGB_ALPHA,
+                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+    row_pointers = g_new(png_bytep, height);
+    for (gint y = 0; y < height; ++y)
+    {
+        row_pointers[y] = (png_bytep)(rgba + (gsize)y * (gsize)width * 4);
+    }
+    png_write_info(png_ptr, info_ptr);
+    png_write_image(png_ptr, row_pointers);
+    png_write_end(png_ptr, NULL);
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+    g_free(row_pointers);
+
+    *out_size = out->len;
+    *out_data = g_byte_array_free(out, FALSE);
+    return TRUE;
+}
@@ -0,0 +1,24 @@
+/*
+ * Static Image Source - RGBA encoding to JPEG and PNG
+ */
+
+#ifndef __GST_STATIC_IMAGE_ENCODE_H__
+#define __GST_STATIC_IMAGE_ENCODE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Encodes tightly packed RGBA (stride = width * 4) as a baseline JPEG at
+ * quality 1-100, dropping alpha. The result is freed with g_free().
+ */
+gboolean static_image_encode_jpeg(const guint8* rgba, gint width, gint height, gint quality, guint8** out_data,
+                                  gsize* out_size);
+
+/* As above as an 8-bit RGBA PNG */
+gboolean static_image_encode_png(const guint8* rgba, gint width, gint height, guint8** out_data, gsize* out_size);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_ENCODE_H__ */
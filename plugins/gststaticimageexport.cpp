@@ -0,0 +1,184 @@
+/*
+ * Static Image Source - fd-backed export of output frames
+ *
+ * The frame is copied once into a memfd, which is then sealed against
+ * resizing (and, for plain fd memory, against writes) so importers can trust
+ * its contents for the lifetime of the fd. udmabuf refuses write-sealed
+ * memfds, so the dmabuf path only seals the size.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimageexport.h"
+
+#include <gst/allocators/allocators.h>
+
+#ifdef HAVE_MEMFD_CREATE
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef HAVE_LINUX_UDMABUF_H
+#include <linux/udmabuf.h>
+#endif
+#endif
+
+#include <cstring>
+
+#ifdef HAVE_MEMFD_CREATE
+
+#if GST_CHECK_VERSION(1, 16, 0)
+#define EXPORT_FD_FLAGS GST_FD_MEMORY_FLAG_KEEP_MAPPED
+#else
+#define EXPORT_FD_FLAGS GST_FD_MEMORY_FLAG_NONE
+#endif
+
+static GstAllocator* get_fd_allocator(void)
+{
+    static gsize allocator = 0;
+    if (g_once_init_enter(&allocator))
+    {
+        g_once_init_leave(&allocator, (gsize)gst_fd_allocator_new());
+    }
+    return (GstAllocator*)allocator;
+}
+
+#ifdef HAVE_LINUX_UDMABUF_H
+static GstAllocator* get_dmabuf_allocator(void)
+{
+    static gsize allocator = 0;
+    if (g_once_init_enter(&allocator))
+    {
+        g_once_init_leave(&allocator, (gsize)gst_dmabuf_allocator_new());
+    }
+    return (GstAllocator*)allocator;
+}
+
+/* Returns a dmabuf fd for the memfd, or -1 if /dev/udmabuf is missing or refuses it */
+static gint udmabuf_from_memfd(gint memfd, gsize size)
+{
+    gint dev = open("/dev/udmabuf", O_RDWR | O_CLOEXEC);
+    if (dev < 0)
+    {
+        return -1;
+    }
+
+    struct udmabuf_create create;
+    memset(&create, 0, sizeof(create));
+    create.memfd = (__u32)memfd;
+    create.flags = UDMABUF_FLAGS_CLOEXEC;
+    create.offset = 0;
+    create.size = size;
+    gint dmabuf_fd = ioctl(dev, UDMABUF_CREATE, &create);
+    close(dev);
+    return dmabuf_fd;
+}
+#endif
+
+/* Creates a memfd of alloc_size holding a copy of data; writable mappings are gone on return so it can be sealed */
+static gint memfd_from_data(const guint8* data, gsize size, gsize alloc_size)
+{
+    gint fd = memfd_create("staticimagesrc-frame", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    if (ftruncate(fd, (off_t)alloc_size) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    void* dst = mmap(NULL, alloc_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (dst == MAP_FAILED)
+    {
+        close(fd);
+        return -1;
+    }
+    memcpy(dst, data, size);
+    munmap(dst, alloc_size);
+    return fd;
+}
+
+GstMemory* static_image_export_memory(GstMemory* memory, StaticImageExportMode mode)
+{
+    g_return_val_if_fail(memory != NULL, NULL);
+
+    if (mode == STATIC_IMAGE_EXPORT_NONE)
+    {
+        return NULL;
+    }
+
+    GstMapInfo map;
+    if (!gst_memory_map(memory, &map, GST_MAP_READ))
+    {
+        return NULL;
+    }
+
+    /* udmabuf works in whole pages */
+    const gsize page = (gsize)sysconf(_SC_PAGESIZE);
+    const gsize size = map.size;
+    const gsize alloc_size = (size + page - 1) / page * page;
+    gint fd = memfd_from_data(map.data, size, alloc_size);
+    gst_memory_unmap(memory, &map);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    GstMemory* exported = NULL;
+#ifdef HAVE_LINUX_UDMABUF_H
+    if (mode == STATIC_IMAGE_EXPORT_DMABUF && fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) == 0)
+    {
+        gint dmabuf_fd = udmabuf_from_memfd(fd, alloc_size);
+        if (dmabuf_fd >= 0)
+        {
+            /* The dmabuf holds its own reference to the memfd pages */
+            exported = gst_dmabuf_allocator_alloc(get_dmabuf_allocator(), dmabuf_fd, alloc_size);
+            if (exported != NULL)
+            {
+                close(fd);
+                fd = -1;
+            }
+            else
+            {
+                close(dmabuf_fd);
+            }
+        }
+    }
+#endif
+
+    if (exported == NULL)
+    {
+        /* Unsealed, a consumer could write to the frame every buffer shares: not exported then */
+        if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0)
+        {
+            close(fd);
+            return NULL;
+        }
+        exported = gst_fd_allocator_alloc(get_fd_allocator(), fd, alloc_size, EXPORT_FD_FLAGS);
+        if (exported == NULL)
+        {
+            close(fd);
+            return NULL;
+        }
+    }
+
+    gst_memory_resize(exported, 0, size);
+    GST_MINI_OBJECT_FLAG_SET(exported, GST_MEMORY_FLAG_READONLY);
+    return exported;
+}
+
+#else /* !HAVE_MEMFD_CREATE */
+
+GstMemory* static_image_export_memory(GstMemory* memory, StaticImageExportMode mode)
+{
+    (void)memory;
+    (void)mode;
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,30 @@
+/*
+ * Static Image Source - fd-backed export of output frames
+ */
+
+#ifndef __GST_STATIC_IMAGE_EXPORT_H__
+#define __GST_STATIC_IMAGE_EXPORT_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    STATIC_IMAGE_EXPORT_NONE,
+    STATIC_IMAGE_EXPORT_MEMFD,
+    STATIC_IMAGE_EXPORT_DMABUF
+} StaticImageExportMode;
+
+/*
+ * Copies memory into a sealed memfd and returns it as read-only fd memory
+ * (GstFdAllocator). With STATIC_IMAGE_EXPORT_DMABUF the memfd is turned into a
+ * dmabuf through /dev/udmabuf (GstDmaBufAllocator) when the device exists,
+ * falling back to plain fd memory otherwise. Returns NULL if memfds are not
+ * available or any step fails.
+ */
+GstMemory* static_image_export_memory(GstMemory* memory, StaticImageExportMode mode);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_EXPORT_H__ */
@@ -0,0 +1,35 @@
+/*
+ * Static Image Source - bitmap-font text overlay tiles
+ */
+
+#ifndef __GST_STATIC_IMAGE_OVERLAY_H__
+#define __GST_STATIC_IMAGE_OVERLAY_H__
+
+#include "gststaticimageconvert.h"
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Glyphs are 8x8 font pixels; a character cell is this times the scale on each side */
+#define STATIC_IMAGE_OVERLAY_GLYPH_SIZE 8
+
+/*
+ * Draws character c (printable ASCII; anything else shows as '?') into an
+ * opaque RGBA cell of GLYPH_SIZE * scale pixels square, stride = cell * 4.
+ * fg_rgb and bg_rgb are 0xRRGGBB.
+ */
+void static_image_overlay_render_glyph(gchar c, guint scale, guint32 fg_rgb, guint32 bg_rgb, guint8* rgba);
+
+/*
+ * Copies a width x height pixel rectangle between two frames of the same
+ * format, plane by plane. Positions and sizes must be even so subsampled
+ * chroma is copied whole; the rectangles must lie inside both frames.
+ */
+void static_image_overlay_copy_rect(const gchar* format, guint8* dst, const StaticImageFrameLayout* dst_layout,
+                                    gint dst_x, gint dst_y, const guint8* src, const StaticImageFrameLayout* src_layout,
+                                    gint src_x, gint src_y, gint width, gint height);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_OVERLAY_H__ */
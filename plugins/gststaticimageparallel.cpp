@@ -0,0 +1,157 @@
+/*
+ * Static Image Source - row-band parallelism on a process-wide bounded worker pool
+ *
+ * All element instances share one GThreadPool capped at the number of CPUs, so
+ * bringing up many sources at once queues bands instead of oversubscribing the
+ * machine. Callers always work on their own job as well, which keeps progress
+ * guaranteed even when every pool thread is busy with other jobs.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimageparallel.h"
+
+/* Below this many items per band the hand-off costs more than it saves */
+#define MIN_ITEMS_PER_BAND 32
+
+typedef struct
+{
+    gint refcount;
+
+    StaticImageParallelFunc func;
+    gpointer user_data;
+    gint n_items;
+    gint band_size;
+    gint n_bands;
+
+    gint next_band;
+    gint bands_done;
+    GMutex lock;
+    GCond cond;
+} ParallelJob;
+
+static void parallel_job_unref(ParallelJob* job)
+{
+    if (g_atomic_int_dec_and_test(&job->refcount))
+    {
+        g_mutex_clear(&job->lock);
+        g_cond_clear(&job->cond);
+        g_free(job);
+    }
+}
+
+static void parallel_job_run_bands(ParallelJob* job)
+{
+    for (;;)
+    {
+        gint band = g_atomic_int_add(&job->next_band, 1);
+        if (band >= job->n_bands)
+        {
+            break;
+        }
+
+        gint start = band * job->band_size;
+        gint end = MIN(start + job->band_size, job->n_items);
+        job->func(start, end, job->user_data);
+
+        g_mutex_lock(&job->lock);
+        job->bands_done++;
+        if (job->bands_done == job->n_bands)
+        {
+            g_cond_broadcast(&job->cond);
+        }
+        g_mutex_unlock(&job->lock);
+    }
+}
+
+static void parallel_worker_func(gpointer data, gpointer user_data)
+{
+    (void)user_data;
+    ParallelJob* job = (ParallelJob*)data;
+    parallel_job_run_bands(job);
+    parallel_job_unref(job);
+}
+
+static GThreadPool* get_shared_pool(void)
+{
+    static gsize initialized = 0;
+    static GThreadPool* pool = NULL;
+
+    if (g_once_init_enter(&initialized))
+    {
+        GError* error = NULL;
+        pool = g_thread_pool_new(parallel_worker_func, NULL, (gint)g_get_num_processors(), FALSE, &error);
+        if (pool == NULL)
+        {
+            g_warning("staticimagesrc: failed to create worker pool: %s", error != NULL ? error->message : "unknown");
+            g_clear_error(&error);
+        }
+        g_once_init_leave(&initialized, 1);
+    }
+
+    return pool;
+}
+
+void static_image_parallel_for(gint n_items, gint granularity, guint n_threads, StaticImageParallelFunc func,
+                               gpointer user_data)
+{
+    if (n_items <= 0)
+    {
+        return;
+    }
+
+    if (granularity < 1)
+    {
+        granularity = 1;
+    }
+    if (n_threads == 0)
+    {
+        n_threads = g_get_num_processors();
+    }
+
+    /* Band size: an even split over the threads, rounded up to the granularity, never tiny */
+    gint band_size = (n_items + (gint)n_threads - 1) / (gint)n_threads;
+    band_size = MAX(band_size, MIN_ITEMS_PER_BAND);
+    band_size = ((band_size + granularity - 1) / granularity) * granularity;
+    gint n_bands = (n_items + band_size - 1) / band_size;
+
+    GThreadPool* pool = n_bands > 1 ? get_shared_pool() : NULL;
+    if (pool == NULL)
+    {
+        func(0, n_items, user_data);
+        return;
+    }
+
+    ParallelJob* job = g_new0(ParallelJob, 1);
+    job->refcount = 1;
+    job->func = func;
+    job->user_data = user_data;
+    job->n_items = n_items;
+    job->band_size = band_size;
+    job->n_bands = n_bands;
+    g_mutex_init(&job->lock);
+    g_cond_init(&job->cond);
+
+    for (gint i = 1; i < n_bands; ++i)
+    {
+        g_atomic_int_inc(&job->refcount);
+        if (!g_thread_pool_push(pool, job, NULL))
+        {
+            g_atomic_int_add(&job->refcount, -1);
+            break;
+        }
+    }
+
+    parallel_job_run_bands(job);
+
+    g_mutex_lock(&job->lock);
+    while (job->bands_done < job->n_bands)
+    {
+        g_cond_wait(&job->cond, &job->lock);
+    }
+    g_mutex_unlock(&job->lock);
+
+    parallel_job_unref(job);
+}
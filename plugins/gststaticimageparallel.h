@@ -0,0 +1,27 @@
+/*
+ * Static Image Source - row-band parallelism on a process-wide bounded worker pool
+ */
+
+#ifndef __GST_STATIC_IMAGE_PARALLEL_H__
+#define __GST_STATIC_IMAGE_PARALLEL_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Processes items [start, end) of a larger range */
+typedef void (*StaticImageParallelFunc)(gint start, gint end, gpointer user_data);
+
+/*
+ * Splits [0, n_items) into contiguous bands whose starts are multiples of
+ * granularity and runs func on them using up to n_threads threads (0 = one per
+ * CPU). The calling thread processes bands too and the call returns once all
+ * bands are done. Bands never overlap, so row-independent kernels produce the
+ * same output for any thread count.
+ */
+void static_image_parallel_for(gint n_items, gint granularity, guint n_threads, StaticImageParallelFunc func,
+                               gpointer user_data);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_PARALLEL_H__ */
@@ -0,0 +1,141 @@
+/*
+ * Static Image Source - playlist of images with per-item durations
+ *
+ * Only the list is read here; the images themselves are checked when they
+ * are first decoded, so a bad entry is skipped at playback time rather than
+ * failing the whole playlist.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimageplaylist.h"
+
+#include <cstring>
+
+static void playlist_item_free(gpointer data)
+{
+    StaticImagePlaylistItem* item = (StaticImagePlaylistItem*)data;
+    g_free(item->path);
+    g_free(item);
+}
+
+static void add_item(GPtrArray* items, const gchar* dir, const gchar* path, guint duration_ms)
+{
+    StaticImagePlaylistItem* item = g_new0(StaticImagePlaylistItem, 1);
+    item->path = g_path_is_absolute(path) ? g_strdup(path) : g_build_filename(dir, path, NULL);
+    item->duration_ms = MAX(duration_ms, 1u);
+    g_ptr_array_add(items, item);
+}
+
+static gboolean has_image_extension(const gchar* name)
+{
+    const gchar* dot = strrchr(name, '.');
+    if (dot == NULL)
+    {
+        return FALSE;
+    }
+    gchar* ext = g_ascii_strdown(dot + 1, -1);
+    const gboolean image = g_strcmp0(ext, "png") == 0 || g_strcmp0(ext, "jpg") == 0 || g_strcmp0(ext, "jpeg") == 0 ||
+                           g_strcmp0(ext, "jpp") == 0;
+    g_free(ext);
+    return image;
+}
+
+static gint compare_names(gconstpointer a, gconstpointer b)
+{
+    return strcmp(*(const gchar* const*)a, *(const gchar* const*)b);
+}
+
+static void load_directory(GPtrArray* items, const gchar* dir_path, guint default_duration_ms)
+{
+    GDir* dir = g_dir_open(dir_path, 0, NULL);
+    if (dir == NULL)
+    {
+        return;
+    }
+
+    GPtrArray* names = g_ptr_array_new_with_free_func(g_free);
+    const gchar* name = NULL;
+    while ((name = g_dir_read_name(dir)) != NULL)
+    {
+        if (has_image_extension(name))
+        {
+            g_ptr_array_add(names, g_strdup(name));
+        }
+    }
+    g_dir_close(dir);
+
+    g_ptr_array_sort(names, compare_names);
+    for (guint i = 0; i < names->len; ++i)
+    {
+        add_item(items, dir_path, (const gchar*)g_ptr_array_index(names, i), default_duration_ms);
+    }
+    g_ptr_array_unref(names);
+}
+
+/* A trailing number on the line is the duration in seconds; anything else is part of the path */
+static void parse_line(GPtrArray* items, const gchar* dir, gchar* line, guint default_duration_ms)
+{
+    g_strstrip(line);
+    if (line[0] == '\0' || line[0] == '#')
+    {
+        return;
+    }
+
+    guint duration_ms = default_duration_ms;
+    gchar* sep = strrchr(line, ' ');
+    gchar* tab = strrchr(line, '\t');
+    if (tab != NULL && (sep == NULL || tab > sep))
+    {
+        sep = tab;
+    }
+    if (sep != NULL)
+    {
+        gchar* end = NULL;
+        const gdouble seconds = g_ascii_strtod(sep + 1, &end);
+        if (end != sep + 1 && *end == '\0' && seconds >= 0.0)
+        {
+            duration_ms = (guint)MIN(seconds * 1000.0 + 0.5, (gdouble)G_MAXUINT);
+            *sep = '\0';
+            g_strchomp(line);
+        }
+    }
+
+    add_item(items, dir, line, duration_ms);
+}
+
+GPtrArray* static_image_playlist_load(const gchar* spec, guint default_duration_ms)
+{
+    g_return_val_if_fail(spec != NULL, NULL);
+
+    GPtrArray* items = g_ptr_array_new_with_free_func(playlist_item_free);
+    if (g_file_test(spec, G_FILE_TEST_IS_DIR))
+    {
+        load_directory(items, spec, default_duration_ms);
+    }
+    else
+    {
+        gchar* contents = NULL;
+        if (g_file_get_contents(spec, &contents, NULL, NULL))
+        {
+            gchar* dir = g_path_get_dirname(spec);
+            gchar** lines = g_strsplit(contents, "\n", -1);
+            for (gchar** line = lines; *line != NULL; ++line)
+            {
+                parse_line(items, dir, *line, default_duration_ms);
+            }
+            g_strfreev(lines);
+            g_free(dir);
+            g_free(contents);
+        }
+    }
+
+    if (items->len == 0)
+    {
+        g_ptr_array_unref(items);
+        return NULL;
+    }
+    return items;
+}
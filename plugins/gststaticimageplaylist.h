@@ -0,0 +1,36 @@
+/*
+ * Static Image Source - playlist of images with per-item durations
+ */
+
+#ifndef __GST_STATIC_IMAGE_PLAYLIST_H__
+#define __GST_STATIC_IMAGE_PLAYLIST_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+    gchar* path;
+    guint duration_ms;
+} StaticImagePlaylistItem;
+
+/*
+ * Loads a playlist from spec, which is either a directory (its PNG and JPEG
+ * files in name order, each shown for default_duration_ms) or a text file
+ * with one image per line, optionally followed by a duration in seconds:
+ *
+ *   # comment
+ *   intro.png 10
+ *   /srv/slides/photo.jpg 2.5
+ *   outro.png
+ *
+ * Relative paths are resolved against the playlist's directory. Returns a
+ * GPtrArray of StaticImagePlaylistItem (freed with the array), or NULL if spec
+ * cannot be read or lists no images.
+ */
+GPtrArray* static_image_playlist_load(const gchar* spec, guint default_duration_ms);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_PLAYLIST_H__ */
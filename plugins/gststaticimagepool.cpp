@@ -0,0 +1,254 @@
+/*
+ * Static Image Source - buffer pool recycling buffers around the shared frame
+ *
+ * Every buffer holds a ref to the same read-only frame memory, which the base
+ * class release path would reject as "not writable" and free. This pool keeps
+ * its own stack of idle buffers instead, so once warmed up an acquire/release
+ * cycle allocates nothing: the memory and video meta stay on the buffer.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimagepool.h"
+
+#include <cstring>
+
+struct _GstStaticImageBufferPool
+{
+    GstBufferPool parent;
+
+    GMutex lock;
+    GPtrArray* idle; /* released buffers carrying the current frame */
+    GstMemory* memory;
+    GstVideoFormat format;
+    StaticImageFrameLayout layout;
+};
+
+G_DEFINE_TYPE(GstStaticImageBufferPool, gst_static_image_buffer_pool, GST_TYPE_BUFFER_POOL);
+
+static GPtrArray* new_idle_array(void)
+{
+    return g_ptr_array_new_with_free_func((GDestroyNotify)gst_buffer_unref);
+}
+
+static GstFlowReturn gst_static_image_buffer_pool_alloc_buffer(GstBufferPool* pool, GstBuffer** buffer,
+                                                               GstBufferPoolAcquireParams* params)
+{
+    GstStaticImageBufferPool* self = GST_STATIC_IMAGE_BUFFER_POOL(pool);
+    (void)params;
+
+    g_mutex_lock(&self->lock);
+    GstMemory* memory = self->memory != NULL ? gst_memory_ref(self->memory) : NULL;
+    GstVideoFormat format = self->format;
+    StaticImageFrameLayout layout = self->layout;
+    g_mutex_unlock(&self->lock);
+
+    if (memory == NULL)
+    {
+        return GST_FLOW_NOT_NEGOTIATED;
+    }
+
+    GstBuffer* buf = gst_buffer_new();
+    gst_buffer_append_memory(buf, memory);
+    GstVideoMeta* meta = format == GST_VIDEO_FORMAT_ENCODED
+                             ? NULL
+                             : gst_buffer_add_video_meta_full(buf, (GstVideoFrameFlags)0, format, (guint)layout.width,
+                                                              (guint)layout.height, layout.n_planes, layout.offsets,
+                                                              layout.strides);
+    if (meta != NULL)
+    {
+        GST_META_FLAG_SET(meta, (GstMetaFlags)(GST_META_FLAG_POOLED | GST_META_FLAG_LOCKED));
+    }
+
+    /* Untagged memory is how a buffer is expected to come back */
+    GST_BUFFER_FLAG_UNSET(buf, GST_BUFFER_FLAG_TAG_MEMORY);
+
+    *buffer = buf;
+    return GST_FLOW_OK;
+}
+
+static GstFlowReturn gst_static_image_buffer_pool_acquire_buffer(GstBufferPool* pool, GstBuffer** buffer,
+                                                                 GstBufferPoolAcquireParams* params)
+{
+    GstStaticImageBufferPool* self = GST_STATIC_IMAGE_BUFFER_POOL(pool);
+
+    GstBuffer* buf = NULL;
+    g_mutex_lock(&self->lock);
+    if (self->idle->len > 0)
+    {
+        buf = (GstBuffer*)g_ptr_array_steal_index_fast(self->idle, self->idle->len - 1);
+    }
+    g_mutex_unlock(&self->lock);
+
+    if (buf != NULL)
+    {
+        *buffer = buf;
+        return GST_FLOW_OK;
+    }
+
+    return GST_BUFFER_POOL_GET_CLASS(pool)->alloc_buffer(pool, buffer, params);
+}
+
+static gboolean remove_unpooled_meta(GstBuffer* buffer, GstMeta** meta, gpointer user_data)
+{
+    (void)buffer;
+    (void)user_data;
+
+    if (!GST_META_FLAG_IS_SET(*meta, GST_META_FLAG_POOLED))
+    {
+        GST_META_FLAG_UNSET(*meta, GST_META_FLAG_LOCKED);
+        *meta = NULL;
+    }
+    return TRUE;
+}
+
+/* Unlike the default, never resizes the buffer (that would need writable memory) */
+static void gst_static_image_buffer_pool_reset_buffer(GstBufferPool* pool, GstBuffer* buffer)
+{
+    (void)pool;
+
+    GST_BUFFER_FLAGS(buffer) &= GST_BUFFER_FLAG_TAG_MEMORY;
+    GST_BUFFER_PTS(buffer) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_DTS(buffer) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_DURATION(buffer) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_OFFSET(buffer) = GST_BUFFER_OFFSET_NONE;
+    GST_BUFFER_OFFSET_END(buffer) = GST_BUFFER_OFFSET_NONE;
+    gst_buffer_foreach_meta(buffer, remove_unpooled_meta, NULL);
+}
+
+static void gst_static_image_buffer_pool_release_buffer(GstBufferPool* pool, GstBuffer* buffer)
+{
+    GstStaticImageBufferPool* self = GST_STATIC_IMAGE_BUFFER_POOL(pool);
+
+    g_mutex_lock(&self->lock);
+    if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_TAG_MEMORY) && gst_buffer_n_memory(buffer) == 1 &&
+        gst_buffer_peek_memory(buffer, 0) == self->memory)
+    {
+        g_ptr_array_add(self->idle, buffer);
+        buffer = NULL;
+    }
+    g_mutex_unlock(&self->lock);
+
+    /* Stale or modified: the pool link is already cleared, so this frees it */
+    if (buffer != NULL)
+    {
+        gst_buffer_unref(buffer);
+    }
+}
+
+/* Buffers are created on first acquire; nothing to preallocate */
+static gboolean gst_static_image_buffer_pool_start(GstBufferPool* pool)
+{
+    (void)pool;
+    return TRUE;
+}
+
+static gboolean gst_static_image_buffer_pool_stop(GstBufferPool* pool)
+{
+    GstStaticImageBufferPool* self = GST_STATIC_IMAGE_BUFFER_POOL(pool);
+
+    g_mutex_lock(&self->lock);
+    GPtrArray* idle = self->idle;
+    self->idle = new_idle_array();
+    g_mutex_unlock(&self->lock);
+
+    g_ptr_array_unref(idle);
+    return TRUE;
+}
+
+static void gst_static_image_buffer_pool_finalize(GObject* object)
+{
+    GstStaticImageBufferPool* self = GST_STATIC_IMAGE_BUFFER_POOL(object);
+
+    g_ptr_array_unref(self->idle);
+    if (self->memory != NULL)
+    {
+        gst_memory_unref(self->memory);
+    }
+    g_mutex_clear(&self->lock);
+
+    G_OBJECT_CLASS(gst_static_image_buffer_pool_parent_class)->finalize(object);
+}
+
+static void gst_static_image_buffer_pool_class_init(GstStaticImageBufferPoolClass* klass)
+{
+    GObjectClass* gobject_class = G_OBJECT_CLASS(klass);
+    GstBufferPoolClass* pool_class = GST_BUFFER_POOL_CLASS(klass);
+
+    gobject_class->finalize = gst_static_image_buffer_pool_finalize;
+
+    pool_class->start = gst_static_image_buffer_pool_start;
+    pool_class->stop = gst_static_image_buffer_pool_stop;
+    pool_class->alloc_buffer = gst_static_image_buffer_pool_alloc_buffer;
+    pool_class->acquire_buffer = gst_static_image_buffer_pool_acquire_buffer;
+    pool_class->reset_buffer = gst_static_image_buffer_pool_reset_buffer;
+    pool_class->release_buffer = gst_static_image_buffer_pool_release_buffer;
+}
+
+static void gst_static_image_buffer_pool_init(GstStaticImageBufferPool* self)
+{
+    g_mutex_init(&self->lock);
+    self->idle = new_idle_array();
+    self->memory = NULL;
+    self->format = GST_VIDEO_FORMAT_UNKNOWN;
+    memset(&self->layout, 0, sizeof(self->layout));
+}
+
+GstBufferPool* static_image_buffer_pool_new(void)
+{
+    GstBufferPool* pool = GST_BUFFER_POOL(g_object_new(GST_TYPE_STATIC_IMAGE_BUFFER_POOL, NULL));
+
+    /* Buffer size comes from the frame; the config only exists to allow activation */
+    GstStructure* config = gst_buffer_pool_get_config(pool);
+    gst_buffer_pool_config_set_params(config, NULL, 0, 0, 0);
+    if (!gst_buffer_pool_set_config(pool, config) || !gst_buffer_pool_set_active(pool, TRUE))
+    {
+        gst_object_unref(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void static_image_buffer_pool_set_frame(GstBufferPool* pool, GstMemory* memory, GstVideoFormat format,
+                                        const StaticImageFrameLayout* layout)
+{
+    GstStaticImageBufferPool* self = GST_STATIC_IMAGE_BUFFER_POOL(pool);
+    g_return_if_fail(memory != NULL && layout != NULL);
+
+    g_mutex_lock(&self->lock);
+    GstMemory* old_memory = self->memory;
+    GPtrArray* stale = self->idle;
+    self->memory = gst_memory_ref(memory);
+    self->format = format;
+    self->layout = *layout;
+    self->idle = new_idle_array();
+    g_mutex_unlock(&self->lock);
+
+    g_ptr_array_unref(stale);
+    if (old_memory != NULL)
+    {
+        gst_memory_unref(old_memory);
+    }
+}
+
+gboolean static_image_buffer_pool_reclaim_frame(GstBufferPool* pool)
+{
+    GstStaticImageBufferPool* self = GST_STATIC_IMAGE_BUFFER_POOL(pool);
+
+    /* One ref is the pool's own, one per idle buffer; any other is a buffer (or a copy) in flight */
+    GPtrArray* surplus = new_idle_array();
+    g_mutex_lock(&self->lock);
+    const gboolean reclaimed =
+        self->memory != NULL && GST_MINI_OBJECT_REFCOUNT_VALUE(self->memory) == 1 + (gint)self->idle->len;
+    while (reclaimed && self->idle->len > 1)
+    {
+        g_ptr_array_add(surplus, g_ptr_array_steal_index_fast(self->idle, self->idle->len - 1));
+    }
+    g_mutex_unlock(&self->lock);
+
+    g_ptr_array_unref(surplus);
+    return reclaimed;
+}
@@ -0,0 +1,40 @@
+/*
+ * Static Image Source - buffer pool recycling buffers around the shared frame
+ */
+
+#ifndef __GST_STATIC_IMAGE_POOL_H__
+#define __GST_STATIC_IMAGE_POOL_H__
+
+#include "gststaticimageconvert.h"
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_STATIC_IMAGE_BUFFER_POOL (gst_static_image_buffer_pool_get_type())
+
+G_DECLARE_FINAL_TYPE(GstStaticImageBufferPool, gst_static_image_buffer_pool, GST, STATIC_IMAGE_BUFFER_POOL,
+                     GstBufferPool)
+
+GstBufferPool* static_image_buffer_pool_new(void);
+
+/*
+ * Sets the frame every buffer carries: a ref to memory plus video meta built
+ * from format and layout (none for GST_VIDEO_FORMAT_ENCODED). Idle buffers for the previous frame are dropped, and
+ * buffers still in flight are freed instead of recycled when they come back.
+ */
+void static_image_buffer_pool_set_frame(GstBufferPool* pool, GstMemory* memory, GstVideoFormat format,
+                                        const StaticImageFrameLayout* layout);
+
+/*
+ * TRUE if every buffer carrying the frame is back in the pool and nothing else
+ * holds its memory, so the caller may draw into it again. Idle buffers past
+ * the first are dropped then: memory shared by two buffers cannot be mapped
+ * for writing.
+ */
+gboolean static_image_buffer_pool_reclaim_frame(GstBufferPool* pool);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_POOL_H__ */
@@ -0,0 +1,204 @@
+/*
+ * Static Image Source - bounded background prefetch of upcoming frames
+ *
+ * One thread builds the items just ahead of the current position, nearest
+ * first, and parks them until the streaming thread takes them. Every slot
+ * records the generation it was built for; a reset bumps the generation, so a
+ * build that was running across it is thrown away instead of stored.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimageprefetch.h"
+
+typedef enum
+{
+    SLOT_EMPTY,
+    SLOT_READY,
+    SLOT_FAILED
+} SlotState;
+
+typedef struct
+{
+    SlotState state;
+    guint generation;
+    GstMemory* memory;
+} PrefetchSlot;
+
+struct _StaticImagePrefetch
+{
+    guint n_items;
+    guint depth;
+    StaticImagePrefetchBuildFunc build_func;
+    gpointer user_data;
+
+    GMutex lock;
+    GCond cond;
+    PrefetchSlot* slots;
+    guint position;
+    guint generation;
+    gboolean stopping;
+    GThread* thread;
+};
+
+static void clear_slot(PrefetchSlot* slot)
+{
+    if (slot->memory != NULL)
+    {
+        gst_memory_unref(slot->memory);
+    }
+    slot->memory = NULL;
+    slot->state = SLOT_EMPTY;
+}
+
+/* 1 for the item right after the position, depth for the furthest one kept; 0 outside the window */
+static guint window_distance(StaticImagePrefetch* prefetch, guint index)
+{
+    const guint distance = (index + prefetch->n_items - prefetch->position) % prefetch->n_items;
+    return distance >= 1 && distance <= prefetch->depth ? distance : 0;
+}
+
+/* Called with the lock held: drops slots that left the window and returns the nearest item still to build */
+static gboolean next_to_build(StaticImagePrefetch* prefetch, guint* out_index)
+{
+    for (guint i = 0; i < prefetch->n_items; ++i)
+    {
+        PrefetchSlot* slot = &prefetch->slots[i];
+        if (slot->state != SLOT_EMPTY && (window_distance(prefetch, i) == 0 || slot->generation != prefetch->generation))
+        {
+            clear_slot(slot);
+        }
+    }
+
+    for (guint distance = 1; distance <= prefetch->depth; ++distance)
+    {
+        const guint index = (prefetch->position + distance) % prefetch->n_items;
+        if (prefetch->slots[index].state == SLOT_EMPTY)
+        {
+            *out_index = index;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static gpointer prefetch_thread_func(gpointer data)
+{
+    StaticImagePrefetch* prefetch = (StaticImagePrefetch*)data;
+
+    g_mutex_lock(&prefetch->lock);
+    while (!prefetch->stopping)
+    {
+        guint index = 0;
+        if (!next_to_build(prefetch, &index))
+        {
+            g_cond_wait(&prefetch->cond, &prefetch->lock);
+            continue;
+        }
+
+        const guint generation = prefetch->generation;
+        g_mutex_unlock(&prefetch->lock);
+        GstMemory* memory = prefetch->build_func(index, prefetch->user_data);
+        g_mutex_lock(&prefetch->lock);
+
+        if (generation == prefetch->generation && window_distance(prefetch, index) != 0)
+        {
+            PrefetchSlot* slot = &prefetch->slots[index];
+            clear_slot(slot);
+            slot->state = memory != NULL ? SLOT_READY : SLOT_FAILED;
+            slot->generation = generation;
+            slot->memory = memory;
+        }
+        else if (memory != NULL)
+        {
+            gst_memory_unref(memory);
+        }
+    }
+    g_mutex_unlock(&prefetch->lock);
+    return NULL;
+}
+
+StaticImagePrefetch* static_image_prefetch_new(guint n_items, guint depth, StaticImagePrefetchBuildFunc build_func,
+                                               gpointer user_data)
+{
+    g_return_val_if_fail(n_items > 0 && build_func != NULL, NULL);
+
+    StaticImagePrefetch* prefetch = g_new0(StaticImagePrefetch, 1);
+    prefetch->n_items = n_items;
+    /* The current item is never prefetched */
+    prefetch->depth = MIN(depth, n_items - 1);
+    prefetch->build_func = build_func;
+    prefetch->user_data = user_data;
+    g_mutex_init(&prefetch->lock);
+    g_cond_init(&prefetch->cond);
+    prefetch->slots = g_new0(PrefetchSlot, n_items);
+
+    prefetch->thread = g_thread_try_new("staticimageprefetch", prefetch_thread_func, prefetch, NULL);
+    if (prefetch->thread == NULL)
+    {
+        static_image_prefetch_free(prefetch);
+        return NULL;
+    }
+    return prefetch;
+}
+
+GstMemory* static_image_prefetch_take(StaticImagePrefetch* prefetch, guint index, gboolean* out_failed)
+{
+    g_return_val_if_fail(prefetch != NULL && index < prefetch->n_items, NULL);
+
+    *out_failed = FALSE;
+    GstMemory* memory = NULL;
+
+    g_mutex_lock(&prefetch->lock);
+    PrefetchSlot* slot = &prefetch->slots[index];
+    if (slot->generation == prefetch->generation && slot->state != SLOT_EMPTY)
+    {
+        *out_failed = slot->state == SLOT_FAILED;
+        memory = slot->memory;
+        slot->memory = NULL;
+        slot->state = SLOT_EMPTY;
+        prefetch->position = index;
+        g_cond_signal(&prefetch->cond);
+    }
+    g_mutex_unlock(&prefetch->lock);
+
+    return memory;
+}
+
+void static_image_prefetch_reset(StaticImagePrefetch* prefetch)
+{
+    g_return_if_fail(prefetch != NULL);
+
+    g_mutex_lock(&prefetch->lock);
+    prefetch->generation++;
+    g_cond_signal(&prefetch->cond);
+    g_mutex_unlock(&prefetch->lock);
+}
+
+void static_image_prefetch_free(StaticImagePrefetch* prefetch)
+{
+    if (prefetch == NULL)
+    {
+        return;
+    }
+
+    if (prefetch->thread != NULL)
+    {
+        g_mutex_lock(&prefetch->lock);
+        prefetch->stopping = TRUE;
+        g_cond_signal(&prefetch->cond);
+        g_mutex_unlock(&prefetch->lock);
+        g_thread_join(prefetch->thread);
+    }
+
+    for (guint i = 0; i < prefetch->n_items; ++i)
+    {
+        clear_slot(&prefetch->slots[i]);
+    }
+    g_free(prefetch->slots);
+    g_cond_clear(&prefetch->cond);
+    g_mutex_clear(&prefetch->lock);
+    g_free(prefetch);
+}
@@ -0,0 +1,41 @@
+/*
+ * Static Image Source - bounded background prefetch of upcoming frames
+ */
+
+#ifndef __GST_STATIC_IMAGE_PREFETCH_H__
+#define __GST_STATIC_IMAGE_PREFETCH_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _StaticImagePrefetch StaticImagePrefetch;
+
+/* Builds the frame for item index on the prefetch thread; NULL if it cannot be built */
+typedef GstMemory* (*StaticImagePrefetchBuildFunc)(guint index, gpointer user_data);
+
+/*
+ * Starts a thread that keeps the depth items following the current position
+ * (wrapping around n_items) built and ready; frames further ahead are not
+ * built and passed ones are dropped, so at most depth frames are held.
+ * Returns NULL if the thread cannot be started.
+ */
+StaticImagePrefetch* static_image_prefetch_new(guint n_items, guint depth, StaticImagePrefetchBuildFunc build_func,
+                                               gpointer user_data);
+
+/*
+ * Never blocks: returns the ready frame for index (transferring the ref) and
+ * makes index the current position, or NULL if it is not built yet. A build
+ * that failed also returns NULL, sets *out_failed and moves past the item.
+ */
+GstMemory* static_image_prefetch_take(StaticImagePrefetch* prefetch, guint index, gboolean* out_failed);
+
+/* Drops every prefetched frame and builds them again, e.g. after the output size or format changed */
+void static_image_prefetch_reset(StaticImagePrefetch* prefetch);
+
+/* Waits for a build in progress */
+void static_image_prefetch_free(StaticImagePrefetch* prefetch);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_PREFETCH_H__ */
@@ -0,0 +1,822 @@
+/*
+ * Static Image Source - separable RGBA resampling
+ *
+ * Coefficients follow the usual convolution resampler layout: for every output
+ * sample the filter is centred on (i + 0.5) * in / out, stretched by the scale
+ * factor when shrinking, normalised and quantised to 14-bit integers whose sum
+ * is exactly 1.0. The scalar and SIMD passes share that table and the same
+ * rounding/saturation, so the selected kernel does not change the output.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimagescale.h"
+
+#include "gststaticimagecpu.h"
+#include "gststaticimageparallel.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STATIC_IMAGE_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#define STATIC_IMAGE_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define COEFF_BITS 14
+#define COEFF_ONE (1 << COEFF_BITS)
+#define COEFF_ROUND (1 << (COEFF_BITS - 1))
+
+typedef struct
+{
+    gdouble (*func)(gdouble x);
+    gdouble support;
+} ScaleFilter;
+
+static gdouble filter_bilinear(gdouble x)
+{
+    x = fabs(x);
+    return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+/* Keys cubic with a = -0.5 (Catmull-Rom) */
+static gdouble filter_bicubic(gdouble x)
+{
+    const gdouble a = -0.5;
+    x = fabs(x);
+    if (x < 1.0)
+    {
+        return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+    }
+    if (x < 2.0)
+    {
+        return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+    }
+    return 0.0;
+}
+
+static gdouble sinc(gdouble x)
+{
+    if (x == 0.0)
+    {
+        return 1.0;
+    }
+    x *= G_PI;
+    return sin(x) / x;
+}
+
+static gdouble filter_lanczos3(gdouble x)
+{
+    if (x > -3.0 && x < 3.0)
+    {
+        return sinc(x) * sinc(x / 3.0);
+    }
+    return 0.0;
+}
+
+static const ScaleFilter bilinear_filter = {filter_bilinear, 1.0};
+static const ScaleFilter bicubic_filter = {filter_bicubic, 2.0};
+static const ScaleFilter lanczos_filter = {filter_lanczos3, 3.0};
+
+/* Per-axis coefficient table: output sample i reads counts[i] inputs from starts[i] */
+typedef struct
+{
+    gint n_out;
+    gint n_taps;
+    gint* starts;
+    gint* counts;
+    gint16* coeffs; /* n_out rows of n_taps, zero padded */
+} ScaleCoeffs;
+
+static void scale_coeffs_clear(ScaleCoeffs* c)
+{
+    g_free(c->starts);
+    g_free(c->counts);
+    g_free(c->coeffs);
+    memset(c, 0, sizeof(*c));
+}
+
+static gboolean scale_coeffs_init(ScaleCoeffs* c, gint in_size, gint out_size, const ScaleFilter* filter)
+{
+    memset(c, 0, sizeof(*c));
+
+    const gdouble scale = (gdouble)in_size / (gdouble)out_size;
+    const gdouble filter_scale = MAX(scale, 1.0);
+    const gdouble support = filter->support * filter_scale;
+    const gdouble inv_filter_scale = 1.0 / filter_scale;
+
+    c->n_out = out_size;
+    c->n_taps = (gint)ceil(support) * 2 + 1;
+    c->starts = (gint*)g_try_malloc(sizeof(gint) * (gsize)out_size);
+    c->counts = (gint*)g_try_malloc(sizeof(gint) * (gsize)out_size);
+    c->coeffs = (gint16*)g_try_malloc0(sizeof(gint16) * (gsize)out_size * (gsize)c->n_taps);
+    gdouble* weights = (gdouble*)g_try_malloc(sizeof(gdouble) * (gsize)c->n_taps);
+    if (c->starts == NULL || c->counts == NULL || c->coeffs == NULL || weights == NULL)
+    {
+        g_free(weights);
+        scale_coeffs_clear(c);
+        return FALSE;
+    }
+
+    for (gint i = 0; i < out_size; ++i)
+    {
+        const gdouble center = ((gdouble)i + 0.5) * scale;
+        gint first = MAX((gint)(center - support + 0.5), 0);
+        gint last = MIN((gint)(center + support + 0.5), in_size);
+        gint count = MIN(MAX(last - first, 1), c->n_taps);
+        if (first + count > in_size)
+        {
+            first = MAX(in_size - count, 0);
+        }
+
+        gdouble total = 0.0;
+        for (gint t = 0; t < count; ++t)
+        {
+            weights[t] = filter->func(((gdouble)(first + t) - center + 0.5) * inv_filter_scale);
+            total += weights[t];
+        }
+
+        gint16* k = c->coeffs + (gsize)i * (gsize)c->n_taps;
+        gint sum = 0;
+        gint peak = 0;
+        for (gint t = 0; t < count; ++t)
+        {
+            gdouble w = total != 0.0 ? weights[t] / total : (t == 0 ? 1.0 : 0.0);
+            k[t] = (gint16)lround(w * COEFF_ONE);
+            sum += k[t];
+            if (k[t] > k[peak])
+            {
+                peak = t;
+            }
+        }
+        /* Put the quantisation error on the largest tap so flat areas stay exact */
+        k[peak] = (gint16)(k[peak] + (COEFF_ONE - sum));
+
+        c->starts[i] = first;
+        c->counts[i] = count;
+    }
+
+    g_free(weights);
+    return TRUE;
+}
+
+static inline guint8 clamp_coeff_sum(gint32 acc)
+{
+    acc >>= COEFF_BITS;
+    return (guint8)CLAMP(acc, 0, 255);
+}
+
+/* One destination row of the horizontal pass */
+typedef void (*HPassRowFunc)(const guint8* src, guint8* dst, const ScaleCoeffs* c);
+
+/* One destination row of the vertical pass: rows[t] is the input row for tap t */
+typedef void (*VPassRowFunc)(const guint8* const* rows, gint count, const gint16* k, guint8* dst, gint n_bytes);
+
+static void hpass_row_scalar(const guint8* src, guint8* dst, const ScaleCoeffs* c)
+{
+    for (gint x = 0; x < c->n_out; ++x)
+    {
+        const guint8* sp = src + (gsize)c->starts[x] * 4;
+        const gint16* k = c->coeffs + (gsize)x * (gsize)c->n_taps;
+        const gint count = c->counts[x];
+        gint32 acc[4] = {COEFF_ROUND, COEFF_ROUND, COEFF_ROUND, COEFF_ROUND};
+
+        for (gint t = 0; t < count; ++t)
+        {
+            acc[0] += sp[t * 4 + 0] * k[t];
+            acc[1] += sp[t * 4 + 1] * k[t];
+            acc[2] += sp[t * 4 + 2] * k[t];
+            acc[3] += sp[t * 4 + 3] * k[t];
+        }
+
+        guint8* dp = dst + (gsize)x * 4;
+        dp[0] = clamp_coeff_sum(acc[0]);
+        dp[1] = clamp_coeff_sum(acc[1]);
+        dp[2] = clamp_coeff_sum(acc[2]);
+        dp[3] = clamp_coeff_sum(acc[3]);
+    }
+}
+
+static void vpass_bytes_scalar(const guint8* const* rows, gint count, const gint16* k, guint8* dst, gint offset,
+                               gint n_bytes)
+{
+    /* Row-major accumulation in small chunks keeps the input reads sequential */
+    gint32 acc[64];
+    for (gint i = offset; i < n_bytes; i += (gint)G_N_ELEMENTS(acc))
+    {
+        const gint len = MIN((gint)G_N_ELEMENTS(acc), n_bytes - i);
+        for (gint j = 0; j < len; ++j)
+        {
+            acc[j] = COEFF_ROUND;
+        }
+        for (gint t = 0; t < count; ++t)
+        {
+            const guint8* row = rows[t] + i;
+            const gint32 w = k[t];
+            for (gint j = 0; j < len; ++j)
+            {
+                acc[j] += row[j] * w;
+            }
+        }
+        for (gint j = 0; j < len; ++j)
+        {
+            dst[i + j] = clamp_coeff_sum(acc[j]);
+        }
+    }
+}
+
+static void vpass_row_scalar(const guint8* const* rows, gint count, const gint16* k, guint8* dst, gint n_bytes)
+{
+    vpass_bytes_scalar(rows, count, k, dst, 0, n_bytes);
+}
+
+#ifdef STATIC_IMAGE_HAVE_X86_SIMD
+
+static inline gint32 pack_coeff_pair(gint16 lo, gint16 hi)
+{
+    return (gint32)(((guint32)(guint16)hi << 16) | (guint32)(guint16)lo);
+}
+
+TARGET_SSE41 static void hpass_row_sse41(const guint8* src, guint8* dst, const ScaleCoeffs* c)
+{
+    /* Two RGBA pixels -> r0 r1 g0 g1 b0 b1 a0 a1, ready for madd against (k0, k1) pairs */
+    const __m128i shuf = _mm_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i round = _mm_set1_epi32(COEFF_ROUND);
+
+    for (gint x = 0; x < c->n_out; ++x)
+    {
+        const guint8* sp = src + (gsize)c->starts[x] * 4;
+        const gint16* k = c->coeffs + (gsize)x * (gsize)c->n_taps;
+        const gint count = c->counts[x];
+        __m128i acc = round;
+
+        gint t = 0;
+        for (; t + 2 <= count; t += 2)
+        {
+            __m128i px = _mm_cvtepu8_epi16(_mm_shuffle_epi8(_mm_loadl_epi64((const __m128i*)(sp + t * 4)), shuf));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, _mm_set1_epi32(pack_coeff_pair(k[t], k[t + 1]))));
+        }
+        if (t < count)
+        {
+            gint32 last;
+            memcpy(&last, sp + t * 4, 4);
+            __m128i px = _mm_cvtepu8_epi16(_mm_shuffle_epi8(_mm_cvtsi32_si128(last), shuf));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, _mm_set1_epi32(pack_coeff_pair(k[t], 0))));
+        }
+
+        acc = _mm_srai_epi32(acc, COEFF_BITS);
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(acc, acc), acc);
+        gint32 out = _mm_cvtsi128_si32(packed);
+        memcpy(dst + (gsize)x * 4, &out, 4);
+    }
+}
+
+TARGET_SSE41 static void vpass_row_sse41(const guint8* const* rows, gint count, const gint16* k, guint8* dst,
+                                         gint n_bytes)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(COEFF_ROUND);
+
+    gint i = 0;
+    for (; i + 16 <= n_bytes; i += 16)
+    {
+        __m128i acc0 = round, acc1 = round, acc2 = round, acc3 = round;
+
+        for (gint t = 0; t < count; t += 2)
+        {
+            const gboolean pair = (t + 1 < count);
+            __m128i a = _mm_loadu_si128((const __m128i*)(rows[t] + i));
+            __m128i b = pair ? _mm_loadu_si128((const __m128i*)(rows[t + 1] + i)) : zero;
+            __m128i kk = _mm_set1_epi32(pack_coeff_pair(k[t], pair ? k[t + 1] : 0));
+
+            __m128i a_lo = _mm_unpacklo_epi8(a, zero);
+            __m128i a_hi = _mm_unpackhi_epi8(a, zero);
+            __m128i b_lo = _mm_unpacklo_epi8(b, zero);
+            __m128i b_hi = _mm_unpackhi_epi8(b, zero);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(a_lo, b_lo), kk));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(a_lo, b_lo), kk));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(a_hi, b_hi), kk));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(a_hi, b_hi), kk));
+        }
+
+        __m128i lo = _mm_packs_epi32(_mm_srai_epi32(acc0, COEFF_BITS), _mm_srai_epi32(acc1, COEFF_BITS));
+        __m128i hi = _mm_packs_epi32(_mm_srai_epi32(acc2, COEFF_BITS), _mm_srai_epi32(acc3, COEFF_BITS));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+
+    vpass_bytes_scalar(rows, count, k, dst, i, n_bytes);
+}
+
+/* Same layout as the SSE4.1 pass; unpack and pack both work per 128-bit lane, so byte order is preserved */
+TARGET_AVX2 static void vpass_row_avx2(const guint8* const* rows, gint count, const gint16* k, guint8* dst,
+                                       gint n_bytes)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi32(COEFF_ROUND);
+
+    gint i = 0;
+    for (; i + 32 <= n_bytes; i += 32)
+    {
+        __m256i acc0 = round, acc1 = round, acc2 = round, acc3 = round;
+
+        for (gint t = 0; t < count; t += 2)
+        {
+            const gboolean pair = (t + 1 < count);
+            __m256i a = _mm256_loadu_si256((const __m256i*)(rows[t] + i));
+            __m256i b = pair ? _mm256_loadu_si256((const __m256i*)(rows[t + 1] + i)) : zero;
+            __m256i kk = _mm256_set1_epi32(pack_coeff_pair(k[t], pair ? k[t + 1] : 0));
+
+            __m256i a_lo = _mm256_unpacklo_epi8(a, zero);
+            __m256i a_hi = _mm256_unpackhi_epi8(a, zero);
+            __m256i b_lo = _mm256_unpacklo_epi8(b, zero);
+            __m256i b_hi = _mm256_unpackhi_epi8(b, zero);
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(a_lo, b_lo), kk));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(a_lo, b_lo), kk));
+            acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi16(a_hi, b_hi), kk));
+            acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi16(a_hi, b_hi), kk));
+        }
+
+        __m256i lo = _mm256_packs_epi32(_mm256_srai_epi32(acc0, COEFF_BITS), _mm256_srai_epi32(acc1, COEFF_BITS));
+        __m256i hi = _mm256_packs_epi32(_mm256_srai_epi32(acc2, COEFF_BITS), _mm256_srai_epi32(acc3, COEFF_BITS));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+
+    vpass_bytes_scalar(rows, count, k, dst, i, n_bytes);
+}
+
+#endif /* STATIC_IMAGE_HAVE_X86_SIMD */
+
+#ifdef STATIC_IMAGE_HAVE_NEON
+
+static void hpass_row_neon(const guint8* src, guint8* dst, const ScaleCoeffs* c)
+{
+    for (gint x = 0; x < c->n_out; ++x)
+    {
+        const guint8* sp = src + (gsize)c->starts[x] * 4;
+        const gint16* k = c->coeffs + (gsize)x * (gsize)c->n_taps;
+        const gint count = c->counts[x];
+        int32x4_t acc = vdupq_n_s32(COEFF_ROUND);
+
+        for (gint t = 0; t < count; ++t)
+        {
+            guint32 px;
+            memcpy(&px, sp + t * 4, 4);
+            int16x4_t p16 = vget_low_s16(vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(px)))));
+            acc = vmlal_n_s16(acc, p16, k[t]);
+        }
+
+        int16x4_t n = vqmovn_s32(vshrq_n_s32(acc, COEFF_BITS));
+        guint32 out = vget_lane_u32(vreinterpret_u32_u8(vqmovun_s16(vcombine_s16(n, n))), 0);
+        memcpy(dst + (gsize)x * 4, &out, 4);
+    }
+}
+
+static void vpass_row_neon(const guint8* const* rows, gint count, const gint16* k, guint8* dst, gint n_bytes)
+{
+    gint i = 0;
+    for (; i + 16 <= n_bytes; i += 16)
+    {
+        int32x4_t acc0 = vdupq_n_s32(COEFF_ROUND);
+        int32x4_t acc1 = acc0, acc2 = acc0, acc3 = acc0;
+
+        for (gint t = 0; t < count; ++t)
+        {
+            uint8x16_t v = vld1q_u8(rows[t] + i);
+            int16x8_t lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(v)));
+            int16x8_t hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(v)));
+            acc0 = vmlal_n_s16(acc0, vget_low_s16(lo), k[t]);
+            acc1 = vmlal_n_s16(acc1, vget_high_s16(lo), k[t]);
+            acc2 = vmlal_n_s16(acc2, vget_low_s16(hi), k[t]);
+            acc3 = vmlal_n_s16(acc3, vget_high_s16(hi), k[t]);
+        }
+
+        int16x8_t lo = vcombine_s16(vqmovn_s32(vshrq_n_s32(acc0, COEFF_BITS)), vqmovn_s32(vshrq_n_s32(acc1, COEFF_BITS)));
+        int16x8_t hi = vcombine_s16(vqmovn_s32(vshrq_n_s32(acc2, COEFF_BITS)), vqmovn_s32(vshrq_n_s32(acc3, COEFF_BITS)));
+        vst1q_u8(dst + i, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+    }
+
+    vpass_bytes_scalar(rows, count, k, dst, i, n_bytes);
+}
+
+#endif /* STATIC_IMAGE_HAVE_NEON */
+
+typedef struct
+{
+    HPassRowFunc hpass_row;
+    VPassRowFunc vpass_row;
+} ScaleImpl;
+
+static const ScaleImpl* get_impl(void)
+{
+    static gsize initialized = 0;
+    static ScaleImpl impl = {hpass_row_scalar, vpass_row_scalar};
+
+    if (g_once_init_enter(&initialized))
+    {
+        guint flags = static_image_cpu_get_flags();
+        (void)flags;
+#ifdef STATIC_IMAGE_HAVE_X86_SIMD
+        if (flags & (STATIC_IMAGE_CPU_SSE41 | STATIC_IMAGE_CPU_AVX2))
+        {
+            impl.hpass_row = hpass_row_sse41;
+            impl.vpass_row = vpass_row_sse41;
+        }
+        if (flags & STATIC_IMAGE_CPU_AVX2)
+        {
+            impl.vpass_row = vpass_row_avx2;
+        }
+#endif
+#ifdef STATIC_IMAGE_HAVE_NEON
+        if (flags & STATIC_IMAGE_CPU_NEON)
+        {
+            impl.hpass_row = hpass_row_neon;
+            impl.vpass_row = vpass_row_neon;
+        }
+#endif
+        g_once_init_leave(&initialized, 1);
+    }
+
+    return &impl;
+}
+
+typedef struct
+{
+    const guint8* src;
+    gint src_stride;
+    gint src_w;
+    gint src_h;
+    guint8* dst;
+    gint dst_stride;
+    gint dst_w;
+    gint dst_h;
+    const gsize* x_offsets;
+} NearestJob;
+
+static void nearest_band(gint start, gint end, gpointer user_data)
+{
+    const NearestJob* job = (const NearestJob*)user_data;
+
+    for (gint y = start; y < end; ++y)
+    {
+        gint sy = (gint)((gint64)y * job->src_h / job->dst_h);
+        const guint8* src_row = job->src + (gsize)sy * (gsize)job->src_stride;
+        guint8* dst_row = job->dst + (gsize)y * (gsize)job->dst_stride;
+
+        for (gint x = 0; x < job->dst_w; ++x)
+        {
+            memcpy(dst_row + (gsize)x * 4, src_row + job->x_offsets[x], 4);
+        }
+    }
+}
+
+static gboolean scale_nearest(const guint8* src, gint src_stride, gint src_w, gint src_h, guint8* dst, gint dst_stride,
+                              gint dst_w, gint dst_h, guint n_threads)
+{
+    /* One division per column instead of one per pixel */
+    gsize* x_offsets = (gsize*)g_try_malloc(sizeof(gsize) * (gsize)dst_w);
+    if (x_offsets == NULL)
+    {
+        return FALSE;
+    }
+    for (gint x = 0; x < dst_w; ++x)
+    {
+        x_offsets[x] = (gsize)((gint64)x * src_w / dst_w) * 4;
+    }
+
+    NearestJob job = {src, src_stride, src_w, src_h, dst, dst_stride, dst_w, dst_h, x_offsets};
+    static_image_parallel_for(dst_h, 1, n_threads, nearest_band, &job);
+
+    g_free(x_offsets);
+    return TRUE;
+}
+
+typedef struct
+{
+    HPassRowFunc hpass_row;
+    const guint8* src;
+    gint src_stride;
+    guint8* dst;
+    gint dst_stride;
+    gint row_offset;
+    const ScaleCoeffs* coeffs;
+} HPassJob;
+
+static void hpass_band(gint start, gint end, gpointer user_data)
+{
+    const HPassJob* job = (const HPassJob*)user_data;
+
+    for (gint y = start; y < end; ++y)
+    {
+        const guint8* src_row = job->src + (gsize)(y + job->row_offset) * (gsize)job->src_stride;
+        job->hpass_row(src_row, job->dst + (gsize)y * (gsize)job->dst_stride, job->coeffs);
+    }
+}
+
+typedef struct
+{
+    VPassRowFunc vpass_row;
+    const guint8* src;
+    gint src_stride;
+    gint row_offset;
+    guint8* dst;
+    gint dst_stride;
+    gint row_bytes;
+    const ScaleCoeffs* coeffs;
+} VPassJob;
+
+static void vpass_band(gint start, gint end, gpointer user_data)
+{
+    const VPassJob* job = (const VPassJob*)user_data;
+    const ScaleCoeffs* c = job->coeffs;
+    const guint8** rows = (const guint8**)g_alloca(sizeof(const guint8*) * (gsize)c->n_taps);
+
+    for (gint y = start; y < end; ++y)
+    {
+        const gint count = c->counts[y];
+        for (gint t = 0; t < count; ++t)
+        {
+            rows[t] = job->src + (gsize)(c->starts[y] + t - job->row_offset) * (gsize)job->src_stride;
+        }
+        job->vpass_row(rows, count, c->coeffs + (gsize)y * (gsize)c->n_taps,
+                       job->dst + (gsize)y * (gsize)job->dst_stride, job->row_bytes);
+    }
+}
+
+static const ScaleFilter* filter_for_method(StaticImageScaleMethod method)
+{
+    switch (method)
+    {
+        case STATIC_IMAGE_SCALE_BICUBIC:
+            return &bicubic_filter;
+        case STATIC_IMAGE_SCALE_LANCZOS:
+            return &lanczos_filter;
+        case STATIC_IMAGE_SCALE_BILINEAR:
+        default:
+            return &bilinear_filter;
+    }
+}
+
+gboolean static_image_scale_rgba(const guint8* src, gint src_stride, gint src_w, gint src_h, guint8* dst,
+                                 gint dst_stride, gint dst_w, gint dst_h, StaticImageScaleMethod method,
+                                 guint n_threads)
+{
+    g_return_val_if_fail(src != NULL && dst != NULL, FALSE);
+    g_return_val_if_fail(src_w > 0 && src_h > 0 && dst_w > 0 && dst_h > 0, FALSE);
+
+    if (method == STATIC_IMAGE_SCALE_NEAREST)
+    {
+        return scale_nearest(src, src_stride, src_w, src_h, dst, dst_stride, dst_w, dst_h, n_threads);
+    }
+
+    const ScaleImpl* impl = get_impl();
+    const ScaleFilter* filter = filter_for_method(method);
+    const gboolean scale_x = (dst_w != src_w);
+    const gboolean scale_y = (dst_h != src_h);
+
+    ScaleCoeffs hc;
+    ScaleCoeffs vc;
+    memset(&hc, 0, sizeof(hc));
+    memset(&vc, 0, sizeof(vc));
+    if ((scale_x && !scale_coeffs_init(&hc, src_w, dst_w, filter)) ||
+        (scale_y && !scale_coeffs_init(&vc, src_h, dst_h, filter)))
+    {
+        scale_coeffs_clear(&hc);
+        scale_coeffs_clear(&vc);
+        return FALSE;
+    }
+
+    /* Horizontal pass output: straight into dst when there is no vertical pass */
+    const guint8* vsrc = src;
+    gint vsrc_stride = src_stride;
+    gint row_offset = 0;
+    guint8* tmp = NULL;
+
+    if (scale_x)
+    {
+        gint row_first = 0;
+        gint row_last = src_h;
+        if (scale_y)
+        {
+            /* Only the source rows some vertical tap actually reads */
+            row_first = src_h;
+            row_last = 0;
+            for (gint y = 0; y < dst_h; ++y)
+            {
+                row_first = MIN(row_first, vc.starts[y]);
+                row_last = MAX(row_last, vc.starts[y] + vc.counts[y]);
+            }
+        }
+
+        HPassJob hjob = {impl->hpass_row, src, src_stride, dst, dst_stride, row_first, &hc};
+        if (scale_y)
+        {
+            gint tmp_stride = dst_w * 4;
+            tmp = (guint8*)g_try_malloc((gsize)tmp_stride * (gsize)(row_last - row_first));
+            if (tmp == NULL)
+            {
+                scale_coeffs_clear(&hc);
+                scale_coeffs_clear(&vc);
+                return FALSE;
+            }
+            hjob.dst = tmp;
+            hjob.dst_stride = tmp_stride;
+            vsrc = tmp;
+            vsrc_stride = tmp_stride;
+            row_offset = row_first;
+        }
+        static_image_parallel_for(row_last - row_first, 1, n_threads, hpass_band, &hjob);
+    }
+
+    if (scale_y)
+    {
+        VPassJob vjob = {impl->vpass_row, vsrc, vsrc_stride, row_offset, dst, dst_stride, dst_w * 4, &vc};
+        static_image_parallel_for(dst_h, 1, n_threads, vpass_band, &vjob);
+    }
+    else if (!scale_x)
+    {
+        for (gint y = 0; y < dst_h; ++y)
+        {
+            memcpy(dst + (gsize)y * (gsize)dst_stride, src + (gsize)y * (gsize)src_stride, (gsize)dst_w * 4);
+        }
+    }
+
+    g_free(tmp);
+    scale_coeffs_clear(&hc);
+    scale_coeffs_clear(&vc);
+    return TRUE;
+}
+
+struct _StaticImageRowScaler
+{
+    const ScaleImpl* impl;
+    gint src_w;
+    gint src_h;
+    gint dst_w;
+    gint dst_h;
+    StaticImageScaleRowFunc emit;
+    gpointer user_data;
+
+    gboolean nearest;
+    gsize* x_offsets; /* nearest only */
+    gboolean scale_x;
+    gboolean scale_y;
+    ScaleCoeffs hc;
+    ScaleCoeffs vc;
+
+    guint8* ring; /* scale_y: horizontally resampled source row r is in slot r % ring_rows */
+    gint ring_rows;
+    guint8* out_row;
+    const guint8** taps;
+    gint rows_in;
+    gint rows_out;
+};
+
+StaticImageRowScaler* static_image_row_scaler_new(gint src_w, gint src_h, gint dst_w, gint dst_h,
+                                                  StaticImageScaleMethod method, StaticImageScaleRowFunc emit,
+                                                  gpointer user_data)
+{
+    g_return_val_if_fail(src_w > 0 && src_h > 0 && dst_w > 0 && dst_h > 0 && emit != NULL, NULL);
+
+    StaticImageRowScaler* s = g_new0(StaticImageRowScaler, 1);
+    s->impl = get_impl();
+    s->src_w = src_w;
+    s->src_h = src_h;
+    s->dst_w = dst_w;
+    s->dst_h = dst_h;
+    s->emit = emit;
+    s->user_data = user_data;
+    s->nearest = method == STATIC_IMAGE_SCALE_NEAREST;
+    s->scale_x = dst_w != src_w;
+    s->scale_y = dst_h != src_h;
+
+    const gsize row_bytes = (gsize)dst_w * 4;
+    gboolean ok = (s->out_row = (guint8*)g_try_malloc(row_bytes)) != NULL;
+    if (ok && s->nearest)
+    {
+        ok = (s->x_offsets = (gsize*)g_try_malloc(sizeof(gsize) * (gsize)dst_w)) != NULL;
+        for (gint x = 0; ok && x < dst_w; ++x)
+        {
+            s->x_offsets[x] = (gsize)((gint64)x * src_w / dst_w) * 4;
+        }
+    }
+    else if (ok)
+    {
+        const ScaleFilter* filter = filter_for_method(method);
+        ok = (!s->scale_x || scale_coeffs_init(&s->hc, src_w, dst_w, filter)) &&
+             (!s->scale_y || scale_coeffs_init(&s->vc, src_h, dst_h, filter));
+        if (ok && s->scale_y)
+        {
+            /* Rows still needed by the next output row all lie within the last n_taps pushed */
+            s->ring_rows = s->vc.n_taps;
+            s->ring = (guint8*)g_try_malloc(row_bytes * (gsize)s->ring_rows);
+            s->taps = (const guint8**)g_try_malloc(sizeof(const guint8*) * (gsize)s->ring_rows);
+            ok = s->ring != NULL && s->taps != NULL;
+        }
+    }
+
+    if (!ok)
+    {
+        static_image_row_scaler_free(s);
+        return NULL;
+    }
+    return s;
+}
+
+void static_image_row_scaler_push(StaticImageRowScaler* s, const guint8* row)
+{
+    g_return_if_fail(s != NULL && row != NULL);
+
+    const gint r = s->rows_in;
+    if (r >= s->src_h)
+    {
+        return;
+    }
+    s->rows_in++;
+
+    if (s->nearest)
+    {
+        const guint8* out = row;
+        if (s->scale_x)
+        {
+            for (gint x = 0; x < s->dst_w; ++x)
+            {
+                memcpy(s->out_row + (gsize)x * 4, row + s->x_offsets[x], 4);
+            }
+            out = s->out_row;
+        }
+        /* Output row y shows source row y * src_h / dst_h: none, one or several per source row */
+        while (s->rows_out < s->dst_h && (gint)((gint64)s->rows_out * s->src_h / s->dst_h) == r)
+        {
+            s->emit(out, s->user_data);
+            s->rows_out++;
+        }
+        return;
+    }
+
+    const gsize row_bytes = (gsize)s->dst_w * 4;
+    if (!s->scale_y)
+    {
+        if (s->scale_x)
+        {
+            s->impl->hpass_row(row, s->out_row, &s->hc);
+            row = s->out_row;
+        }
+        s->emit(row, s->user_data);
+        s->rows_out++;
+        return;
+    }
+
+    guint8* slot = s->ring + (gsize)(r % s->ring_rows) * row_bytes;
+    if (s->scale_x)
+    {
+        s->impl->hpass_row(row, slot, &s->hc);
+    }
+    else
+    {
+        memcpy(slot, row, row_bytes);
+    }
+
+    const ScaleCoeffs* c = &s->vc;
+    while (s->rows_out < s->dst_h && c->starts[s->rows_out] + c->counts[s->rows_out] <= r + 1)
+    {
+        const gint y = s->rows_out;
+        for (gint t = 0; t < c->counts[y]; ++t)
+        {
+            s->taps[t] = s->ring + (gsize)((c->starts[y] + t) % s->ring_rows) * row_bytes;
+        }
+        s->impl->vpass_row(s->taps, c->counts[y], c->coeffs + (gsize)y * (gsize)c->n_taps, s->out_row,
+                           (gint)row_bytes);
+        s->emit(s->out_row, s->user_data);
+        s->rows_out++;
+    }
+}
+
+gint static_image_row_scaler_get_rows_out(const StaticImageRowScaler* scaler)
+{
+    g_return_val_if_fail(scaler != NULL, 0);
+    return scaler->rows_out;
+}
+
+void static_image_row_scaler_free(StaticImageRowScaler* scaler)
+{
+    if (scaler == NULL)
+    {
+        return;
+    }
+    scale_coeffs_clear(&scaler->hc);
+    scale_coeffs_clear(&scaler->vc);
+    g_free(scaler->x_offsets);
+    g_free(scaler->ring);
+    g_free(scaler->taps);
+    g_free(scaler->out_row);
+    g_free(scaler);
+}
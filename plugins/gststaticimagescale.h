@@ -0,0 +1,60 @@
+/*
+ * Static Image Source - separable RGBA resampling
+ */
+
+#ifndef __GST_STATIC_IMAGE_SCALE_H__
+#define __GST_STATIC_IMAGE_SCALE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    STATIC_IMAGE_SCALE_NEAREST,
+    STATIC_IMAGE_SCALE_BILINEAR,
+    STATIC_IMAGE_SCALE_BICUBIC,
+    STATIC_IMAGE_SCALE_LANCZOS
+} StaticImageScaleMethod;
+
+/*
+ * Resamples RGBA src into dst. Nearest picks src pixel x * src_w / dst_w; the
+ * other methods run a horizontal then a vertical pass with precomputed 14-bit
+ * fixed-point coefficient tables (widened by the scale factor on downscale, so
+ * they also low-pass filter). Rows are spread over n_threads (0 = one per CPU).
+ * Returns FALSE if the intermediate buffer could not be allocated.
+ */
+gboolean static_image_scale_rgba(const guint8* src, gint src_stride, gint src_w, gint src_h, guint8* dst,
+                                 gint dst_stride, gint dst_w, gint dst_h, StaticImageScaleMethod method,
+                                 guint n_threads);
+
+/*
+ * Streaming form of static_image_scale_rgba() for images that are never
+ * whole in memory. Source rows are pushed top to bottom. Each is resampled
+ * horizontally into a ring of as many rows as the vertical filter has taps.
+ * Every output row is handed to emit, in order, as soon as the last source
+ * row it reads has arrived. The result is identical to
+ * static_image_scale_rgba() with the same method. The scaler runs single
+ * threaded.
+ */
+typedef struct _StaticImageRowScaler StaticImageRowScaler;
+
+/* Receives one output row of packed RGBA, valid only during the call */
+typedef void (*StaticImageScaleRowFunc)(const guint8* row, gpointer user_data);
+
+/* NULL if the tables or the ring could not be allocated */
+StaticImageRowScaler* static_image_row_scaler_new(gint src_w, gint src_h, gint dst_w, gint dst_h,
+                                                  StaticImageScaleMethod method, StaticImageScaleRowFunc emit,
+                                                  gpointer user_data);
+
+/* Pushes the next src_w pixels of packed RGBA; extra rows past src_h are ignored */
+void static_image_row_scaler_push(StaticImageRowScaler* scaler, const guint8* row);
+
+/* Number of output rows emitted so far; dst_h once every source row was pushed */
+gint static_image_row_scaler_get_rows_out(const StaticImageRowScaler* scaler);
+
+void static_image_row_scaler_free(StaticImageRowScaler* scaler);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_SCALE_H__ */
@@ -1,5 +1,7 @@
 /*
- * Static PNG Source - outputs a constant RGBA frame at a fixed framerate
+ * Static PNG Source - outputs a PNG or JPEG image (or a playlist of them, APNG
+ * animation included) as raw RGB, YUV or gray video at a fixed framerate, or
+ * passes the encoded image through as image/jpeg or image/png
  */
 
 #ifdef HAVE_CONFIG_H
@@ -8,6 +10,22 @@
 
 #include "gststaticimagesrc.h"
 
+#include "gststaticimageallocator.h"
+#include "gststaticimageapng.h"
+#include "gststaticimagecache.h"
+#include "gststaticimageconvert.h"
+#include "gststaticimagedecode.h"
+#include "gststaticimagediskcache.h"
+#include "gststaticimageencode.h"
+#include "gststaticimageexport.h"
+#include "gststaticimageoverlay.h"
+#include "gststaticimageplaylist.h"
+#include "gststaticimagepool.h"
+#include "gststaticimageprefetch.h"
+#include "gststaticimagescale.h"
+#include "gststaticimagestats.h"
+#include "gststaticimagewatch.h"
+
 #include <gst/base/gstbasesrc.h>
 #include <gst/base/gstpushsrc.h>
 #include <gst/gst.h>
@@ -16,8 +34,6 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <jpeglib.h>
-#include <png.h>
 
 GST_DEBUG_CATEGORY_STATIC(gst_static_png_src_debug_category);
 #define GST_CAT_DEFAULT gst_static_png_src_debug_category
@@ -30,46 +46,387 @@ enum
     PROP_FPS,
     PROP_WIDTH,
     PROP_HEIGHT,
-    PROP_NUM_BUFFERS
+    PROP_NUM_BUFFERS,
+    PROP_N_THREADS,
+    PROP_SCALE_METHOD,
+    PROP_SHARED_CACHE,
+    PROP_CACHE_DIR,
+    PROP_IS_LIVE,
+    PROP_MEMORY_EXPORT,
+    PROP_WATCH,
+    PROP_DATA,
+    PROP_PLAYLIST,
+    PROP_SLIDE_DURATION,
+    PROP_PREFETCH,
+    PROP_MATRIX,
+    PROP_RANGE,
+    PROP_OVERLAY,
+    PROP_OVERLAY_TEXT,
+    PROP_OVERLAY_X,
+    PROP_OVERLAY_Y,
+    PROP_OVERLAY_SCALE,
+    PROP_OVERLAY_COLOR,
+    PROP_OVERLAY_BACKGROUND,
+    PROP_STRIDE_ALIGN,
+    PROP_STATS,
+    PROP_STATS_INTERVAL,
+    PROP_ASYNC_START,
+    PROP_PLACEHOLDER,
+    PROP_FILL_COLOR,
+    PROP_FRAME_MEMORY,
+    PROP_LOCK_MEMORY,
+    PROP_JPEG_QUALITY,
+    PROP_LOW_MEMORY
 };
 
-/* Src pad template: allows negotiation while enabling fixed RGBA output */
-static GstStaticPadTemplate gst_static_png_src_template =
-    GST_STATIC_PAD_TEMPLATE("src", GST_PAD_SRC, GST_PAD_ALWAYS,
-                            GST_STATIC_CAPS("video/x-raw, "
-                                            "format=(string){ RGBA, BGRA, ARGB, ABGR, NV12, I420 }, "
-                                            "width=(int)[1,8192], "
-                                            "height=(int)[1,8192], "
-                                            "framerate=(fraction)[1/1,60/1]"));
+/* Sample range of YUV output */
+typedef enum
+{
+    STATIC_IMAGE_RANGE_LIMITED,
+    STATIC_IMAGE_RANGE_FULL
+} StaticImageRange;
+
+/* What the text overlay shows */
+typedef enum
+{
+    STATIC_IMAGE_OVERLAY_NONE,
+    STATIC_IMAGE_OVERLAY_TEXT,
+    STATIC_IMAGE_OVERLAY_CLOCK,
+    STATIC_IMAGE_OVERLAY_FRAME_COUNT
+} StaticImageOverlayMode;
+
+#define DEFAULT_SCALE_METHOD STATIC_IMAGE_SCALE_BILINEAR
+#define DEFAULT_SHARED_CACHE TRUE
+#define DEFAULT_IS_LIVE FALSE
+#define DEFAULT_MEMORY_EXPORT STATIC_IMAGE_EXPORT_NONE
+#define DEFAULT_WATCH FALSE
+#define DEFAULT_SLIDE_DURATION 5000
+#define DEFAULT_PREFETCH 2
+#define DEFAULT_MATRIX STATIC_IMAGE_MATRIX_BT601
+#define DEFAULT_RANGE STATIC_IMAGE_RANGE_LIMITED
+#define DEFAULT_OVERLAY STATIC_IMAGE_OVERLAY_NONE
+#define DEFAULT_OVERLAY_X 16
+#define DEFAULT_OVERLAY_Y 16
+#define DEFAULT_OVERLAY_SCALE 2
+#define DEFAULT_OVERLAY_COLOR 0xFFFFFF
+#define DEFAULT_OVERLAY_BACKGROUND 0x000000
+#define DEFAULT_OVERLAY_CLOCK_FORMAT "%H:%M:%S"
+#define N_OVERLAY_GLYPHS 95 /* printable ASCII */
+#define DEFAULT_STRIDE_ALIGN 1
+#define DEFAULT_STATS_INTERVAL 0
+#define DEFAULT_ASYNC_START FALSE
+#define DEFAULT_PLACEHOLDER FALSE
+#define DEFAULT_FILL_COLOR 0x000000
+#define DEFAULT_FRAME_MEMORY STATIC_IMAGE_FRAME_MEMORY_SYSTEM
+#define DEFAULT_LOCK_MEMORY FALSE
+#define DEFAULT_JPEG_QUALITY 90
+#define DEFAULT_LOW_MEMORY FALSE
+
+#define GST_TYPE_STATIC_IMAGE_SCALE_METHOD (gst_static_image_scale_method_get_type())
+static GType gst_static_image_scale_method_get_type(void)
+{
+    static gsize scale_method_type = 0;
+    static const GEnumValue scale_methods[] = {
+        {STATIC_IMAGE_SCALE_NEAREST, "Nearest neighbour", "nearest"},
+        {STATIC_IMAGE_SCALE_BILINEAR, "Bilinear", "bilinear"},
+        {STATIC_IMAGE_SCALE_BICUBIC, "Bicubic (Catmull-Rom)", "bicubic"},
+        {STATIC_IMAGE_SCALE_LANCZOS, "Lanczos (3 lobes)", "lanczos"},
+        {0, NULL, NULL}};
+
+    if (g_once_init_enter(&scale_method_type))
+    {
+        GType type = g_enum_register_static("GstStaticImageScaleMethod", scale_methods);
+        g_once_init_leave(&scale_method_type, type);
+    }
+
+    return (GType)scale_method_type;
+}
+
+#define GST_TYPE_STATIC_IMAGE_MEMORY_EXPORT (gst_static_image_memory_export_get_type())
+static GType gst_static_image_memory_export_get_type(void)
+{
+    static gsize memory_export_type = 0;
+    static const GEnumValue memory_exports[] = {
+        {STATIC_IMAGE_EXPORT_NONE, "System memory", "none"},
+        {STATIC_IMAGE_EXPORT_MEMFD, "Sealed memfd (fd memory)", "memfd"},
+        {STATIC_IMAGE_EXPORT_DMABUF, "dmabuf via /dev/udmabuf, memfd if unavailable", "dmabuf"},
+        {0, NULL, NULL}};
+
+    if (g_once_init_enter(&memory_export_type))
+    {
+        GType type = g_enum_register_static("GstStaticImageMemoryExport", memory_exports);
+        g_once_init_leave(&memory_export_type, type);
+    }
+
+    return (GType)memory_export_type;
+}
+
+#define GST_TYPE_STATIC_IMAGE_FRAME_MEMORY (gst_static_image_frame_memory_get_type())
+static GType gst_static_image_frame_memory_get_type(void)
+{
+    static gsize frame_memory_type = 0;
+    static const GEnumValue frame_memories[] = {
+        {STATIC_IMAGE_FRAME_MEMORY_SYSTEM, "System memory", "system"},
+        {STATIC_IMAGE_FRAME_MEMORY_ALIGNED, "64-byte aligned", "aligned"},
+        {STATIC_IMAGE_FRAME_MEMORY_HUGEPAGES, "Aligned, transparent huge pages for large frames", "hugepages"},
+        {STATIC_IMAGE_FRAME_MEMORY_HUGETLB, "Aligned, hugetlb pages for large frames, else transparent", "hugetlb"},
+        {0, NULL, NULL}};
+
+    if (g_once_init_enter(&frame_memory_type))
+    {
+        GType type = g_enum_register_static("GstStaticImageFrameMemory", frame_memories);
+        g_once_init_leave(&frame_memory_type, type);
+    }
+
+    return (GType)frame_memory_type;
+}
+
+#define GST_TYPE_STATIC_IMAGE_MATRIX (gst_static_image_matrix_get_type())
+static GType gst_static_image_matrix_get_type(void)
+{
+    static gsize matrix_type = 0;
+    static const GEnumValue matrices[] = {{STATIC_IMAGE_MATRIX_BT601, "ITU-R BT.601", "bt601"},
+                                          {STATIC_IMAGE_MATRIX_BT709, "ITU-R BT.709", "bt709"},
+                                          {STATIC_IMAGE_MATRIX_BT2020, "ITU-R BT.2020", "bt2020"},
+                                          {0, NULL, NULL}};
+
+    if (g_once_init_enter(&matrix_type))
+    {
+        GType type = g_enum_register_static("GstStaticImageMatrix", matrices);
+        g_once_init_leave(&matrix_type, type);
+    }
+
+    return (GType)matrix_type;
+}
+
+#define GST_TYPE_STATIC_IMAGE_RANGE (gst_static_image_range_get_type())
+static GType gst_static_image_range_get_type(void)
+{
+    static gsize range_type = 0;
+    static const GEnumValue ranges[] = {{STATIC_IMAGE_RANGE_LIMITED, "Limited (16-235 luma, 16-240 chroma)", "limited"},
+                                        {STATIC_IMAGE_RANGE_FULL, "Full (0-255)", "full"},
+                                        {0, NULL, NULL}};
+
+    if (g_once_init_enter(&range_type))
+    {
+        GType type = g_enum_register_static("GstStaticImageRange", ranges);
+        g_once_init_leave(&range_type, type);
+    }
+
+    return (GType)range_type;
+}
+
+#define GST_TYPE_STATIC_IMAGE_OVERLAY (gst_static_image_overlay_get_type())
+static GType gst_static_image_overlay_get_type(void)
+{
+    static gsize overlay_type = 0;
+    static const GEnumValue overlays[] = {
+        {STATIC_IMAGE_OVERLAY_NONE, "No overlay", "none"},
+        {STATIC_IMAGE_OVERLAY_TEXT, "overlay-text as is", "text"},
+        {STATIC_IMAGE_OVERLAY_CLOCK, "Wall clock, formatted by overlay-text", "clock"},
+        {STATIC_IMAGE_OVERLAY_FRAME_COUNT, "Frame counter, after overlay-text", "frame-count"},
+        {0, NULL, NULL}};
+
+    if (g_once_init_enter(&overlay_type))
+    {
+        GType type = g_enum_register_static("GstStaticImageOverlay", overlays);
+        g_once_init_leave(&overlay_type, type);
+    }
+
+    return (GType)overlay_type;
+}
+
+/*
+ * Src pad template: allows negotiation while enabling fixed RGBA output. RGB,
+ * YUV and grey are separate structures so get_caps() can pin colorimetry on
+ * the ones it applies to. image/jpeg and image/png come last, so raw video
+ * stays the default, and carry the encoded file itself where possible.
+ */
+#define OUTPUT_CAPS_SIZES "width=(int)[1,8192], height=(int)[1,8192], framerate=(fraction)[1/1,60/1]"
+static GstStaticPadTemplate gst_static_png_src_template = GST_STATIC_PAD_TEMPLATE(
+    "src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS("video/x-raw, format=(string){ RGBA, BGRA, ARGB, ABGR }, " OUTPUT_CAPS_SIZES "; "
+                    "video/x-raw, format=(string){ NV12, I420, NV21, YUY2, UYVY, NV16, Y42B, Y444 }, " OUTPUT_CAPS_SIZES
+                    "; "
+                    "video/x-raw, format=(string)GRAY8, " OUTPUT_CAPS_SIZES "; "
+                    "image/jpeg, " OUTPUT_CAPS_SIZES "; "
+                    "image/png, " OUTPUT_CAPS_SIZES));
+
+/* Formats from the template, each with one slot in the per-format frame cache; JPEG and PNG stand for image/* */
+#define N_OUTPUT_FORMATS 15
+static const gchar* const output_formats[N_OUTPUT_FORMATS] = {"RGBA", "BGRA", "ARGB",  "ABGR", "NV12",
+                                                              "I420", "NV21", "YUY2",  "UYVY", "NV16",
+                                                              "Y42B", "Y444", "GRAY8", "JPEG", "PNG"};
+
+/* A converted frame kept while the image and output size stay the same */
+typedef struct
+{
+    GstMemory* memory;
+    gchar* key; /* shared cache key, NULL if not shared */
+} FormatFrame;
+
+typedef enum
+{
+    IMAGE_TYPE_UNKNOWN,
+    IMAGE_TYPE_PNG,
+    IMAGE_TYPE_JPEG
+} ImageType;
+
+/* Converted APNG frames in playback order, each with the time it ends at within one loop */
+typedef struct
+{
+    GstMemory** frames;
+    GstClockTime* ends;
+    guint n_frames;
+    guint plays; /* 0 = loop forever */
+} FrameRing;
+
+/* A private copy of the output frame with the overlay drawn in; only cells whose character changed are rewritten */
+typedef struct
+{
+    GstBufferPool* pool; /* its own, so switching frames never drops pooled buffers */
+    GstMemory* memory;   /* held by pool */
+    guint generation;    /* overlay_generation the background was copied at */
+    gchar* text;      /* characters drawn, one per cell */
+} OverlayFrame;
+
+/* The overlay properties one frame is drawn with, read together under the object lock */
+typedef struct
+{
+    gint x;
+    gint y;
+    guint scale;
+    guint color;
+    guint background;
+    gint cell; /* glyph size in pixels at scale */
+} OverlayStyle;
+
+/* A frame rebuilt from a changed file, waiting for create() to swap it in */
+typedef struct
+{
+    GstMemory* memory;
+    FrameRing* animation; /* set instead of memory when the new file is an APNG */
+    gint width;
+    gint height;
+    gchar format[5];
+    gint image_width;
+    gint image_height;
+} ReloadedFrame;
 
 struct _GstStaticPngSrc
 {
     GstPushSrc parent;
 
     gchar* location;
+    GBytes* data; /* encoded image from the data property; takes precedence over location */
+    ImageType image_type;
+    gint image_width;
+    gint image_height;
     gchar selected_format[5];
     gint target_width;
     gint target_height;
     gint fps_n;
     gint fps_d;
 
-    /* Original decoded RGBA (scaled), used as conversion source */
-    guint8* rgba_data;
+    /* Original decoded RGBA (scaled), used as conversion source; rgba_data is mapped from rgba_mem */
+    GstMemory* rgba_mem;
+    GstMapInfo rgba_map;
+    gchar* rgba_key;
+    const guint8* rgba_data;
     gsize rgba_size;
     gint rgba_stride;
 
-    /* Output buffer (may be YUV or RGBA variant) */
-    guint8* frame_data;
-    gsize frame_size;
-    gint frame_stride;
+    /* Output buffer (may be YUV or RGBA variant); shared_mem is one of format_frames */
+    FormatFrame format_frames[N_OUTPUT_FORMATS];
+    StaticImageFrameLayout frame_layout;
     gint actual_width;
     gint actual_height;
-    gint num_planes;
 
     GstMemory* shared_mem;
+    GstBufferPool* pool; /* recycles buffers carrying shared_mem and its video meta */
     guint64 frame_count;
     guint num_buffers;
     GstClockTime frame_duration;
+
+    /* Timestamping: frame_index runs ahead of frame_count when QoS drops frames */
+    gboolean is_live;
+    guint64 frame_index;
+    GstClockTime running_time_offset;
+    GstClockTime qos_earliest_time; /* protected by the object lock */
+    guint64 qos_dropped;
+
+    guint n_threads;
+    StaticImageScaleMethod scale_method;
+    gboolean shared_cache;
+    gchar* cache_dir;
+    StaticImageExportMode memory_export;
+    StaticImageFrameMemory frame_memory; /* output frames when memory_export is NONE */
+    gboolean lock_memory;
+    gint jpeg_quality; /* image/jpeg output that had to be re-encoded */
+    gboolean low_memory; /* stream decode -> scale -> convert into the frame, keeping no RGBA image */
+    StaticImageMatrix matrix; /* YUV output only */
+    StaticImageRange range;
+    guint stride_align; /* power of two; 1 keeps GStreamer's default strides */
+
+    /* watch: the watch thread rebuilds the frame for reload_* and create() swaps it in */
+    gboolean watch;
+    StaticImageWatch* watcher;
+    GMutex reload_lock;
+    gint reload_width;
+    gint reload_height;
+    gchar reload_format[5];
+    ReloadedFrame reloaded;
+    gint reload_ready; /* atomic; reloaded.memory or reloaded.animation is set */
+
+    /*
+     * async-start: a worker builds the output frame after negotiation and
+     * create() takes it over, pushing the placeholder meanwhile or waiting
+     */
+    gboolean async_start;
+    gboolean placeholder;
+    guint fill_color;
+    gboolean async_pending;  /* streaming thread only; a build was started and not taken yet */
+    GThread* async_thread;   /* the worker, NULL once joined */
+    GCond async_cond;        /* with reload_lock: the worker finished or unlock() was called */
+    gboolean async_done;     /* protected by reload_lock, like the two below */
+    GstMemory* async_memory; /* built frame (owned by format_frames or animation), NULL on failure */
+    gboolean async_flushing; /* between unlock() and unlock_stop() */
+
+    /* APNG: every frame is converted up front and create() only switches between them */
+    gboolean animated;
+    FrameRing* animation;
+    guint animation_index; /* frame on screen */
+
+    /* playlist: the prefetch thread builds upcoming items for the reload_* target; create() switches to them */
+    gchar* playlist;
+    guint slide_duration; /* ms */
+    guint prefetch;
+    GPtrArray* playlist_items; /* StaticImagePlaylistItem; NULL unless playing a playlist */
+    guint playlist_index;      /* item on screen */
+    guint playlist_next;       /* item that replaces it at slide_end_frame */
+    guint64 slide_end_frame;
+    StaticImagePrefetch* prefetcher;
+
+    /* overlay: text drawn into a few copies of shared_mem, which the pool hands out instead of it */
+    StaticImageOverlayMode overlay;
+    gchar* overlay_text; /* protected by the object lock */
+    gint overlay_x;
+    gint overlay_y;
+    guint overlay_scale;
+    guint overlay_color;
+    guint overlay_background;
+    gint overlay_changed;                    /* atomic; an overlay property changed since the last frame */
+    guint overlay_generation;                /* bumped whenever shared_mem or the overlay look changes */
+    GPtrArray* overlay_frames;               /* OverlayFrame */
+    OverlayFrame* overlay_shown;             /* frame whose pool create() uses, NULL for pool and shared_mem */
+    guint8* overlay_glyphs[N_OVERLAY_GLYPHS]; /* one output-format cell per character, converted on first use */
+    gchar overlay_format[5];                 /* format the overlay frames and glyphs are in */
+
+    /* stats: reset by start(), readable while stopped */
+    StaticImageStats stats;
+    GstClockTime stats_start;     /* gst_util_get_timestamp() at start() */
+    guint stats_interval;         /* ms between stats messages, 0 = none */
+    GstClockTime stats_last_post; /* streaming thread only */
 };
 
 G_DEFINE_TYPE_WITH_CODE(GstStaticPngSrc, gst_static_png_src, GST_TYPE_PUSH_SRC,
@@ -80,33 +437,124 @@ G_DEFINE_TYPE_WITH_CODE(GstStaticPngSrc, gst_static_png_src, GST_TYPE_PUSH_SRC,
 static void gst_static_png_src_set_property(GObject* object, guint prop_id, const GValue* value, GParamSpec* pspec);
 static void gst_static_png_src_get_property(GObject* object, guint prop_id, GValue* value, GParamSpec* pspec);
 static void gst_static_png_src_dispose(GObject* object);
+static void gst_static_png_src_finalize(GObject* object);
 static gboolean gst_static_png_src_start(GstBaseSrc* src);
 static gboolean gst_static_png_src_stop(GstBaseSrc* src);
+static gboolean gst_static_png_src_unlock(GstBaseSrc* src);
+static gboolean gst_static_png_src_unlock_stop(GstBaseSrc* src);
 static GstFlowReturn gst_static_png_src_create(GstPushSrc* src, GstBuffer** buf);
+static void gst_static_png_src_get_times(GstBaseSrc* src, GstBuffer* buffer, GstClockTime* start, GstClockTime* end);
+static gboolean gst_static_png_src_query(GstBaseSrc* src, GstQuery* query);
+static gboolean gst_static_png_src_event(GstBaseSrc* src, GstEvent* event);
+static GstCaps* gst_static_png_src_get_caps(GstBaseSrc* src, GstCaps* filter);
+static GstCaps* gst_static_png_src_fixate(GstBaseSrc* src, GstCaps* caps);
+static gboolean gst_static_png_src_set_caps(GstBaseSrc* src, GstCaps* caps);
+
+/* Context for building the decoded RGBA image or a converted frame */
+typedef struct
+{
+    GstStaticPngSrc* self;
+    const gchar* format;
+    gboolean decode_failed;
+} FrameBuild;
 
-static gboolean decode_png_to_rgba(const gchar* path, guint8** out_pixels, gint* out_w, gint* out_h);
-static gboolean decode_jpeg_to_rgba(const gchar* path, guint8** out_pixels, gint* out_w, gint* out_h);
-static guint8* scale_rgba_nearest(const guint8* src, gint src_w, gint src_h, gint dst_w, gint dst_h);
-static void swizzle_from_rgba_inplace(guint8* pixels, gint width, gint height, const gchar* fmt);
-static guint8* convert_rgba_to_nv12(const guint8* src, gint width, gint height);
-static guint8* convert_rgba_to_i420(const guint8* src, gint width, gint height);
+/* A frame looked up in the shared cache, then cache-dir, then built */
+typedef struct
+{
+    GstStaticPngSrc* self;
+    const gchar* format;
+    const gchar* key;
+    gboolean is_output;
+    StaticImageCacheBuildFunc build_func;
+    gpointer user_data;
+} FrameRequest;
+
+static ImageType image_type_from_location(const gchar* path);
+static const gchar* source_path(GstStaticPngSrc* self);
+static GBytes* load_source(GstStaticPngSrc* self);
+static GBytes* load_source_copy(GstStaticPngSrc* self);
+static const gchar* source_name(GstStaticPngSrc* self);
+static GstMemory* build_rgba_memory(gpointer user_data);
+static GstMemory* build_frame_memory(gpointer user_data);
+static GstMemory* build_via_disk_cache(gpointer user_data);
+static GstMemory* acquire_shared_memory(GstStaticPngSrc* self, const gchar* format, gboolean is_output,
+                                        StaticImageCacheBuildFunc build_func, gpointer user_data, gchar** out_key);
+static gboolean ensure_rgba(GstStaticPngSrc* self, gboolean is_output);
+static GstMemory* ensure_animation(GstStaticPngSrc* self, const gchar* fmt);
+static gboolean select_output_format(GstStaticPngSrc* self, const gchar* fmt);
+static GstMemory* build_output_frame(GstStaticPngSrc* self, const gchar* fmt, const StaticImageFrameLayout* layout);
+static GstMemory* build_placeholder(GstStaticPngSrc* self, const gchar* fmt, const StaticImageFrameLayout* layout);
+static void start_async_build(GstStaticPngSrc* self);
+static GstFlowReturn take_async_frame(GstStaticPngSrc* self);
+static void join_async_build(GstStaticPngSrc* self);
+static void release_frames(GstStaticPngSrc* self);
+static void skip_late_frames(GstStaticPngSrc* self, GstClockTime offset);
+static void record_frame(GstStaticPngSrc* self, GstBuffer* buffer, GstClockTime create_start);
+static guint8* decode_scaled_rgba(GstStaticPngSrc* self, GBytes* source, ImageType type, gint width, gint height,
+                                  gint* out_img_w, gint* out_img_h, gboolean* decode_failed);
+static gboolean output_layout(GstStaticPngSrc* self, const gchar* fmt, gint width, gint height,
+                              StaticImageFrameLayout* layout);
+static guint8* convert_from_rgba(GstStaticPngSrc* self, const guint8* rgba, const gchar* fmt,
+                                 const StaticImageFrameLayout* layout, gsize* out_size);
+static guint8* decode_jpeg_direct(GstStaticPngSrc* self, GBytes* source, ImageType type, const gchar* fmt,
+                                  const StaticImageFrameLayout* layout, gsize* out_size, gint* out_img_w,
+                                  gint* out_img_h);
+static GstMemory* passthrough_source(GstStaticPngSrc* self, GBytes* source, ImageType type, const gchar* fmt,
+                                     gint width, gint height, gint* out_img_w, gint* out_img_h);
+static guint8* decode_streamed(GstStaticPngSrc* self, GBytes* source, ImageType type, const gchar* fmt,
+                               const StaticImageFrameLayout* layout, gsize* out_size, gint* out_img_w,
+                               gint* out_img_h);
+static GstMemory* build_standalone_frame(GstStaticPngSrc* self, GBytes* source, ImageType type, gint width,
+                                         gint height, const gchar* format, gint* out_img_w, gint* out_img_h);
+static GstMemory* export_output_frame(GstStaticPngSrc* self, GstMemory* memory, const gchar* format);
+static void reload_image(gpointer user_data);
+static void swap_in_reloaded_frame(GstStaticPngSrc* self);
+static void clear_reloaded_frame(GstStaticPngSrc* self);
+static guint64 slide_frames(GstStaticPngSrc* self, guint index);
+static GstMemory* build_playlist_frame(guint index, gpointer user_data);
+static void advance_playlist(GstStaticPngSrc* self);
+static void stop_playlist(GstStaticPngSrc* self);
+static FrameRing* build_frame_ring(GstStaticPngSrc* self, GBytes* source, gint width, gint height,
+                                   const gchar* format);
+static void frame_ring_free(FrameRing* ring);
+static guint frame_ring_index_at(const FrameRing* ring, GstClockTime time);
+static void advance_animation(GstStaticPngSrc* self);
+static void show_shared_frame(GstStaticPngSrc* self);
+static void update_overlay(GstStaticPngSrc* self);
+static void release_overlay(GstStaticPngSrc* self);
+static guint8* scale_rgba(GstStaticPngSrc* self, const guint8* src, gint src_w, gint src_h, gint dst_w, gint dst_h);
+static void swizzle_from_rgba_inplace(guint8* pixels, gint stride, gint width, gint height, const gchar* fmt,
+                                      guint n_threads);
+
+/* TRUE if an RGBA frame in layout is the tightly packed RGBA image itself */
+static inline gboolean layout_is_packed_rgba(const gchar* fmt, const StaticImageFrameLayout* layout)
+{
+    return g_strcmp0(fmt, "RGBA") == 0 && layout->strides[0] == layout->width * 4;
+}
 
-/* Local safe memdup to avoid runtime dependency on g_memdup2/g_memdup */
-static inline gpointer memdup_fallback(const void* src, gsize size)
+/* TRUE for the image/jpeg and image/png outputs, which hold the encoded image instead of pixels */
+static inline gboolean format_is_compressed(const gchar* fmt)
 {
-    if (src == NULL || size == 0)
-    {
-        return NULL;
-    }
+    return g_strcmp0(fmt, "JPEG") == 0 || g_strcmp0(fmt, "PNG") == 0;
+}
 
-    gpointer dst = g_malloc(size);
-    if (dst == NULL)
+/* For the pool's video meta; compressed frames get none */
+static inline GstVideoFormat output_video_format(const gchar* fmt)
+{
+    return format_is_compressed(fmt) ? GST_VIDEO_FORMAT_ENCODED : gst_video_format_from_string(fmt);
+}
+
+/* Index of fmt in output_formats and format_frames, -1 if it is not an output format */
+static gint output_format_slot(const gchar* fmt)
+{
+    for (gint i = 0; i < N_OUTPUT_FORMATS; ++i)
     {
-        return NULL;
+        if (g_strcmp0(output_formats[i], fmt) == 0)
+        {
+            return i;
+        }
     }
-
-    memcpy(dst, src, size);
-    return dst;
+    return -1;
 }
 
 /* GObject methods */
@@ -119,12 +567,15 @@ static void gst_static_png_src_class_init(GstStaticPngSrcClass* klass)
 
     gst_element_class_add_static_pad_template(element_class, &gst_static_png_src_template);
     gst_element_class_set_static_metadata(element_class, "Static Image Source", "Source/Video",
-                                          "Outputs a static RGBA image from a PNG or JPEG at a fixed framerate",
+                                          "Outputs a PNG/JPEG image, playlist or APNG animation at a fixed framerate "
+                                          "as raw video in one of 13 RGB/YUV/gray formats, or as image/jpeg or "
+                                          "image/png passthrough",
                                           "MTData");
 
     gobject_class->set_property = gst_static_png_src_set_property;
     gobject_class->get_property = gst_static_png_src_get_property;
     gobject_class->dispose = gst_static_png_src_dispose;
+    gobject_class->finalize = gst_static_png_src_finalize;
 
     g_object_class_install_property(gobject_class, PROP_LOCATION,
                                     g_param_spec_string("location", "location",
@@ -151,45 +602,328 @@ static void gst_static_png_src_class_init(GstStaticPngSrcClass* klass)
         g_param_spec_uint("num-buffers", "num-buffers", "Number of buffers to output before sending EOS (0 = unlimited)", 0, G_MAXUINT, 0,
                           (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+    g_object_class_install_property(
+        gobject_class, PROP_N_THREADS,
+        g_param_spec_uint("n-threads", "n-threads",
+                          "Threads used for scaling and colour conversion at startup (0 = one per CPU)", 0, 256, 0,
+                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_SCALE_METHOD,
+        g_param_spec_enum("scale-method", "scale-method", "Resampling filter used for the one-time scale",
+                          GST_TYPE_STATIC_IMAGE_SCALE_METHOD, DEFAULT_SCALE_METHOD,
+                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_SHARED_CACHE,
+        g_param_spec_boolean("shared-cache", "shared-cache",
+                             "Share decoded and converted frames with other instances in the process that load the "
+                             "same file with the same settings",
+                             DEFAULT_SHARED_CACHE, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_CACHE_DIR,
+        g_param_spec_string("cache-dir", "cache-dir",
+                            "Directory for converted frames kept across restarts; hits are mmapped instead of decoded "
+                            "(NULL = disabled)",
+                            NULL, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_IS_LIVE,
+        g_param_spec_boolean("is-live", "is-live",
+                             "Act as a live source: timestamp from the running time, sync to the clock and drop "
+                             "frames on QoS",
+                             DEFAULT_IS_LIVE, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_MEMORY_EXPORT,
+        g_param_spec_enum("memory-export", "memory-export",
+                          "Memory the output frame is placed in, so fd-passing consumers can import it without copies",
+                          GST_TYPE_STATIC_IMAGE_MEMORY_EXPORT, DEFAULT_MEMORY_EXPORT,
+                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_FRAME_MEMORY,
+        g_param_spec_enum("frame-memory", "frame-memory",
+                          "Placement of output frames in system memory (without memory-export): aligned, and in huge "
+                          "pages when large, so downstream reads take fewer TLB misses",
+                          GST_TYPE_STATIC_IMAGE_FRAME_MEMORY, DEFAULT_FRAME_MEMORY,
+                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_LOCK_MEMORY,
+        g_param_spec_boolean("lock-memory", "lock-memory",
+                             "mlock() output frames (without memory-export) so they are never paged out; needs "
+                             "RLIMIT_MEMLOCK headroom",
+                             DEFAULT_LOCK_MEMORY,
+                             (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_JPEG_QUALITY,
+        g_param_spec_int("jpeg-quality", "jpeg-quality",
+                         "Quality of image/jpeg output when it cannot pass the file through (other size or a PNG "
+                         "source) and is encoded once",
+                         1, 100, DEFAULT_JPEG_QUALITY,
+                         (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_LOW_MEMORY,
+        g_param_spec_boolean("low-memory", "low-memory",
+                             "Build output frames by streaming decoded rows through the scaler into the converter, "
+                             "without a decoded or scaled RGBA image: peak memory is about one output frame, at "
+                             "the cost of single-threaded scaling and conversion",
+                             DEFAULT_LOW_MEMORY,
+                             (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_WATCH,
+        g_param_spec_boolean("watch", "watch",
+                             "Reload the image when the file at location is rewritten or replaced; the new frame is "
+                             "built in the background and swapped in between two buffers",
+                             DEFAULT_WATCH, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_DATA,
+        g_param_spec_boxed("data", "data",
+                           "Encoded PNG or JPEG image held in memory, used instead of location (type detected from "
+                           "the data); read when the element starts",
+                           G_TYPE_BYTES, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_PLAYLIST,
+        g_param_spec_string("playlist", "playlist",
+                            "Playlist file (one image per line, optionally followed by a duration in seconds) or "
+                            "directory of images, shown in order and looped; used instead of location",
+                            NULL, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_SLIDE_DURATION,
+        g_param_spec_uint("slide-duration", "slide-duration",
+                          "How long each playlist image is shown, in milliseconds, unless the playlist says otherwise",
+                          1, G_MAXUINT, DEFAULT_SLIDE_DURATION,
+                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_PREFETCH,
+        g_param_spec_uint("prefetch", "prefetch",
+                          "Number of upcoming playlist images kept decoded and converted in the background", 1, 16,
+                          DEFAULT_PREFETCH, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_MATRIX,
+        g_param_spec_enum("matrix", "matrix", "RGB to YCbCr matrix for YUV output, advertised as caps colorimetry",
+                          GST_TYPE_STATIC_IMAGE_MATRIX, DEFAULT_MATRIX,
+                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_RANGE,
+        g_param_spec_enum("range", "range", "Sample range of YUV and GRAY8 output, advertised as caps colorimetry",
+                          GST_TYPE_STATIC_IMAGE_RANGE, DEFAULT_RANGE,
+                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_OVERLAY,
+        g_param_spec_enum("overlay", "overlay",
+                          "Text drawn into the frame; only the character cells that change are redrawn",
+                          GST_TYPE_STATIC_IMAGE_OVERLAY, DEFAULT_OVERLAY,
+                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_OVERLAY_TEXT,
+        g_param_spec_string("overlay-text", "overlay-text",
+                            "Overlay text, strftime-style format for the clock (default " DEFAULT_OVERLAY_CLOCK_FORMAT
+                            ") or prefix for the frame counter",
+                            NULL, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_OVERLAY_X,
+        g_param_spec_int("overlay-x", "overlay-x", "Left edge of the overlay in output pixels (rounded down to even)",
+                         0, 8192, DEFAULT_OVERLAY_X, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_OVERLAY_Y,
+        g_param_spec_int("overlay-y", "overlay-y", "Top edge of the overlay in output pixels (rounded down to even)",
+                         0, 8192, DEFAULT_OVERLAY_Y, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_OVERLAY_SCALE,
+        g_param_spec_uint("overlay-scale", "overlay-scale", "Size of an overlay font pixel; characters are 8x this",
+                          1, 16, DEFAULT_OVERLAY_SCALE, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_OVERLAY_COLOR,
+        g_param_spec_uint("overlay-color", "overlay-color", "Overlay text colour as 0xRRGGBB", 0, 0xFFFFFF,
+                          DEFAULT_OVERLAY_COLOR, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_OVERLAY_BACKGROUND,
+        g_param_spec_uint("overlay-background", "overlay-background",
+                          "Colour of the opaque box behind the overlay text as 0xRRGGBB", 0, 0xFFFFFF,
+                          DEFAULT_OVERLAY_BACKGROUND, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_STATS,
+        g_param_spec_boxed("stats", "stats",
+                           "Timings of decode, scale, convert and the first buffer, frames and bytes pushed and a "
+                           "create() latency histogram (times in ns)",
+                           GST_TYPE_STRUCTURE, (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_STATS_INTERVAL,
+        g_param_spec_uint("stats-interval", "stats-interval",
+                          "Post the stats as a staticimagesrc-stats element message every this many milliseconds "
+                          "while streaming (0 = never)",
+                          0, G_MAXUINT, DEFAULT_STATS_INTERVAL,
+                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_ASYNC_START,
+        g_param_spec_boolean("async-start", "async-start",
+                             "Decode, scale and convert on a worker thread after negotiation instead of in the "
+                             "streaming thread; the first buffer follows as soon as the frame is ready",
+                             DEFAULT_ASYNC_START, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_PLACEHOLDER,
+        g_param_spec_boolean("placeholder", "placeholder",
+                             "With async-start, push fill-color frames until the image is ready instead of waiting "
+                             "for it, so the pipeline prerolls at once",
+                             DEFAULT_PLACEHOLDER, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_FILL_COLOR,
+        g_param_spec_uint("fill-color", "fill-color", "Colour of the placeholder frames as 0xRRGGBB", 0, 0xFFFFFF,
+                          DEFAULT_FILL_COLOR, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(
+        gobject_class, PROP_STRIDE_ALIGN,
+        g_param_spec_uint("stride-align", "stride-align",
+                          "Align every plane's rows to this many bytes (power of two, e.g. 16/32/64) for SIMD and "
+                          "encoders; the padded strides are in the video meta. Applies from the next negotiation",
+                          1, 4096, DEFAULT_STRIDE_ALIGN,
+                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
     base_src_class->start = gst_static_png_src_start;
     base_src_class->stop = gst_static_png_src_stop;
+    base_src_class->unlock = gst_static_png_src_unlock;
+    base_src_class->unlock_stop = gst_static_png_src_unlock_stop;
+    base_src_class->get_times = gst_static_png_src_get_times;
+    base_src_class->query = gst_static_png_src_query;
+    base_src_class->event = gst_static_png_src_event;
+    base_src_class->get_caps = gst_static_png_src_get_caps;
+    base_src_class->fixate = gst_static_png_src_fixate;
+    base_src_class->set_caps = gst_static_png_src_set_caps;
     pushsrc_class->create = gst_static_png_src_create;
 }
 
 static void gst_static_png_src_init(GstStaticPngSrc* self)
 {
     self->location = NULL;
+    self->data = NULL;
+    self->image_type = IMAGE_TYPE_UNKNOWN;
+    self->image_width = 0;
+    self->image_height = 0;
     g_strlcpy(self->selected_format, "RGBA", sizeof(self->selected_format));
     self->target_width = 0;
     self->target_height = 0;
     self->fps_n = 25;
     self->fps_d = 1;
+    self->rgba_mem = NULL;
+    self->rgba_key = NULL;
     self->rgba_data = NULL;
     self->rgba_size = 0;
     self->rgba_stride = 0;
-    self->frame_data = NULL;
-    self->frame_size = 0;
-    self->frame_stride = 0;
+    memset(self->format_frames, 0, sizeof(self->format_frames));
+    memset(&self->frame_layout, 0, sizeof(self->frame_layout));
     self->actual_width = 0;
     self->actual_height = 0;
-    self->num_planes = 1;
     self->shared_mem = NULL;
+    self->pool = NULL;
     self->frame_count = 0;
     self->num_buffers = 0;
+    self->n_threads = 0;
+    self->scale_method = DEFAULT_SCALE_METHOD;
+    self->shared_cache = DEFAULT_SHARED_CACHE;
+    self->cache_dir = NULL;
+    self->memory_export = DEFAULT_MEMORY_EXPORT;
+    self->frame_memory = DEFAULT_FRAME_MEMORY;
+    self->lock_memory = DEFAULT_LOCK_MEMORY;
+    self->jpeg_quality = DEFAULT_JPEG_QUALITY;
+    self->low_memory = DEFAULT_LOW_MEMORY;
+    self->matrix = DEFAULT_MATRIX;
+    self->range = DEFAULT_RANGE;
+    self->stride_align = DEFAULT_STRIDE_ALIGN;
     self->frame_duration = gst_util_uint64_scale_int(GST_SECOND, self->fps_d, self->fps_n);
+    self->is_live = DEFAULT_IS_LIVE;
+    self->frame_index = 0;
+    self->running_time_offset = GST_CLOCK_TIME_NONE;
+    self->qos_earliest_time = GST_CLOCK_TIME_NONE;
+    self->qos_dropped = 0;
+    self->watch = DEFAULT_WATCH;
+    self->watcher = NULL;
+    g_mutex_init(&self->reload_lock);
+    self->reload_width = 0;
+    self->reload_height = 0;
+    self->reload_format[0] = '\0';
+    memset(&self->reloaded, 0, sizeof(self->reloaded));
+    self->reload_ready = FALSE;
+    self->async_start = DEFAULT_ASYNC_START;
+    self->placeholder = DEFAULT_PLACEHOLDER;
+    self->fill_color = DEFAULT_FILL_COLOR;
+    self->async_pending = FALSE;
+    self->async_thread = NULL;
+    g_cond_init(&self->async_cond);
+    self->async_done = FALSE;
+    self->async_memory = NULL;
+    self->async_flushing = FALSE;
+    self->playlist = NULL;
+    self->slide_duration = DEFAULT_SLIDE_DURATION;
+    self->prefetch = DEFAULT_PREFETCH;
+    self->playlist_items = NULL;
+    self->playlist_index = 0;
+    self->playlist_next = 0;
+    self->slide_end_frame = 0;
+    self->prefetcher = NULL;
+    self->animated = FALSE;
+    self->animation = NULL;
+    self->animation_index = 0;
+    self->overlay = DEFAULT_OVERLAY;
+    self->overlay_text = NULL;
+    self->overlay_x = DEFAULT_OVERLAY_X;
+    self->overlay_y = DEFAULT_OVERLAY_Y;
+    self->overlay_scale = DEFAULT_OVERLAY_SCALE;
+    self->overlay_color = DEFAULT_OVERLAY_COLOR;
+    self->overlay_background = DEFAULT_OVERLAY_BACKGROUND;
+    self->overlay_changed = FALSE;
+    self->overlay_generation = 0;
+    self->overlay_frames = NULL;
+    self->overlay_shown = NULL;
+    memset(self->overlay_glyphs, 0, sizeof(self->overlay_glyphs));
+    self->overlay_format[0] = '\0';
+    static_image_stats_init(&self->stats);
+    self->stats_start = GST_CLOCK_TIME_NONE;
+    self->stats_interval = DEFAULT_STATS_INTERVAL;
+    self->stats_last_post = GST_CLOCK_TIME_NONE;
 
     gst_base_src_set_format(GST_BASE_SRC(self), GST_FORMAT_TIME);
-    gst_base_src_set_live(GST_BASE_SRC(self), FALSE);
+    gst_base_src_set_live(GST_BASE_SRC(self), self->is_live);
 }
 
 static void gst_static_png_src_dispose(GObject* object)
 {
     GstStaticPngSrc* self = GST_STATICPNG_SRC(object);
 
-    if (self->shared_mem != NULL)
+    static_image_watch_free(self->watcher);
+    self->watcher = NULL;
+    clear_reloaded_frame(self);
+    stop_playlist(self);
+    release_frames(self);
+
+    if (self->pool != NULL)
     {
-        gst_memory_unref(self->shared_mem);
-        self->shared_mem = NULL;
+        gst_buffer_pool_set_active(self->pool, FALSE);
+        gst_object_unref(self->pool);
+        self->pool = NULL;
     }
 
     if (self->location != NULL)
@@ -198,9 +932,33 @@ static void gst_static_png_src_dispose(GObject* object)
         self->location = NULL;
     }
 
+    if (self->data != NULL)
+    {
+        g_bytes_unref(self->data);
+        self->data = NULL;
+    }
+
+    g_free(self->cache_dir);
+    self->cache_dir = NULL;
+    g_free(self->playlist);
+    self->playlist = NULL;
+    g_free(self->overlay_text);
+    self->overlay_text = NULL;
+
     G_OBJECT_CLASS(gst_static_png_src_parent_class)->dispose(object);
 }
 
+static void gst_static_png_src_finalize(GObject* object)
+{
+    GstStaticPngSrc* self = GST_STATICPNG_SRC(object);
+
+    g_mutex_clear(&self->reload_lock);
+    g_cond_clear(&self->async_cond);
+    static_image_stats_clear(&self->stats);
+
+    G_OBJECT_CLASS(gst_static_png_src_parent_class)->finalize(object);
+}
+
 static void gst_static_png_src_set_property(GObject* object, guint prop_id, const GValue* value, GParamSpec* pspec)
 {
     GstStaticPngSrc* self = GST_STATICPNG_SRC(object);
@@ -241,6 +999,181 @@ static void gst_static_png_src_set_property(GObject* object, guint prop_id, cons
             self->num_buffers = g_value_get_uint(value);
             break;
         }
+        case PROP_N_THREADS:
+        {
+            self->n_threads = g_value_get_uint(value);
+            break;
+        }
+        case PROP_SCALE_METHOD:
+        {
+            self->scale_method = (StaticImageScaleMethod)g_value_get_enum(value);
+            break;
+        }
+        case PROP_SHARED_CACHE:
+        {
+            self->shared_cache = g_value_get_boolean(value);
+            break;
+        }
+        case PROP_CACHE_DIR:
+        {
+            g_free(self->cache_dir);
+            self->cache_dir = g_value_dup_string(value);
+            break;
+        }
+        case PROP_IS_LIVE:
+        {
+            self->is_live = g_value_get_boolean(value);
+            gst_base_src_set_live(GST_BASE_SRC(self), self->is_live);
+            break;
+        }
+        case PROP_MEMORY_EXPORT:
+        {
+            self->memory_export = (StaticImageExportMode)g_value_get_enum(value);
+            break;
+        }
+        case PROP_FRAME_MEMORY:
+        {
+            self->frame_memory = (StaticImageFrameMemory)g_value_get_enum(value);
+            break;
+        }
+        case PROP_LOCK_MEMORY:
+        {
+            self->lock_memory = g_value_get_boolean(value);
+            break;
+        }
+        case PROP_JPEG_QUALITY:
+        {
+            self->jpeg_quality = g_value_get_int(value);
+            break;
+        }
+        case PROP_LOW_MEMORY:
+        {
+            self->low_memory = g_value_get_boolean(value);
+            break;
+        }
+        case PROP_WATCH:
+        {
+            self->watch = g_value_get_boolean(value);
+            break;
+        }
+        case PROP_DATA:
+        {
+            if (self->data != NULL)
+            {
+                g_bytes_unref(self->data);
+            }
+            self->data = (GBytes*)g_value_dup_boxed(value);
+            break;
+        }
+        case PROP_PLAYLIST:
+        {
+            g_free(self->playlist);
+            self->playlist = g_value_dup_string(value);
+            break;
+        }
+        case PROP_SLIDE_DURATION:
+        {
+            self->slide_duration = g_value_get_uint(value);
+            break;
+        }
+        case PROP_PREFETCH:
+        {
+            self->prefetch = g_value_get_uint(value);
+            break;
+        }
+        case PROP_MATRIX:
+        {
+            self->matrix = (StaticImageMatrix)g_value_get_enum(value);
+            break;
+        }
+        case PROP_RANGE:
+        {
+            self->range = (StaticImageRange)g_value_get_enum(value);
+            break;
+        }
+        case PROP_OVERLAY:
+        {
+            self->overlay = (StaticImageOverlayMode)g_value_get_enum(value);
+            break;
+        }
+        case PROP_OVERLAY_TEXT:
+        {
+            GST_OBJECT_LOCK(self);
+            g_free(self->overlay_text);
+            self->overlay_text = g_value_dup_string(value);
+            GST_OBJECT_UNLOCK(self);
+            break;
+        }
+        case PROP_OVERLAY_X:
+        {
+            GST_OBJECT_LOCK(self);
+            self->overlay_x = g_value_get_int(value);
+            g_atomic_int_set(&self->overlay_changed, TRUE);
+            GST_OBJECT_UNLOCK(self);
+            break;
+        }
+        case PROP_OVERLAY_Y:
+        {
+            GST_OBJECT_LOCK(self);
+            self->overlay_y = g_value_get_int(value);
+            g_atomic_int_set(&self->overlay_changed, TRUE);
+            GST_OBJECT_UNLOCK(self);
+            break;
+        }
+        case PROP_OVERLAY_SCALE:
+        {
+            GST_OBJECT_LOCK(self);
+            self->overlay_scale = g_value_get_uint(value);
+            g_atomic_int_set(&self->overlay_changed, TRUE);
+            GST_OBJECT_UNLOCK(self);
+            break;
+        }
+        case PROP_OVERLAY_COLOR:
+        {
+            GST_OBJECT_LOCK(self);
+            self->overlay_color = g_value_get_uint(value);
+            g_atomic_int_set(&self->overlay_changed, TRUE);
+            GST_OBJECT_UNLOCK(self);
+            break;
+        }
+        case PROP_OVERLAY_BACKGROUND:
+        {
+            GST_OBJECT_LOCK(self);
+            self->overlay_background = g_value_get_uint(value);
+            g_atomic_int_set(&self->overlay_changed, TRUE);
+            GST_OBJECT_UNLOCK(self);
+            break;
+        }
+        case PROP_STRIDE_ALIGN:
+        {
+            const guint align = g_value_get_uint(value);
+            self->stride_align = (align & (align - 1)) == 0 ? align : 1u << g_bit_storage(align);
+            if (self->stride_align != align)
+            {
+                GST_WARNING_OBJECT(self, "stride-align %u is not a power of two, using %u", align, self->stride_align);
+            }
+            break;
+        }
+        case PROP_STATS_INTERVAL:
+        {
+            self->stats_interval = g_value_get_uint(value);
+            break;
+        }
+        case PROP_ASYNC_START:
+        {
+            self->async_start = g_value_get_boolean(value);
+            break;
+        }
+        case PROP_PLACEHOLDER:
+        {
+            self->placeholder = g_value_get_boolean(value);
+            break;
+        }
+        case PROP_FILL_COLOR:
+        {
+            self->fill_color = g_value_get_uint(value);
+            break;
+        }
         default:
         {
             G_OBJECT_CLASS(gst_static_png_src_parent_class)->set_property(object, prop_id, value, pspec);
@@ -280,857 +1213,2642 @@ static void gst_static_png_src_get_property(GObject* object, guint prop_id, GVal
             g_value_set_uint(value, self->num_buffers);
             break;
         }
-        default:
+        case PROP_N_THREADS:
         {
-            G_OBJECT_CLASS(gst_static_png_src_parent_class)->get_property(object, prop_id, value, pspec);
+            g_value_set_uint(value, self->n_threads);
             break;
         }
-    }
-}
-
-static gboolean gst_static_png_src_start(GstBaseSrc* src)
-{
-    GstStaticPngSrc* self = GST_STATICPNG_SRC(src);
-
-    if (self->location == NULL || self->location[0] == '\0')
-    {
-        GST_ELEMENT_ERROR(self, RESOURCE, NOT_FOUND, ("'location' property not set"), (NULL));
-        return FALSE;
-    }
+        case PROP_SCALE_METHOD:
+        {
+            g_value_set_enum(value, self->scale_method);
+            break;
+        }
+        case PROP_SHARED_CACHE:
+        {
+            g_value_set_boolean(value, self->shared_cache);
+            break;
+        }
+        case PROP_CACHE_DIR:
+        {
+            g_value_set_string(value, self->cache_dir);
+            break;
+        }
+        case PROP_IS_LIVE:
+        {
+            g_value_set_boolean(value, self->is_live);
+            break;
+        }
+        case PROP_MEMORY_EXPORT:
+        {
+            g_value_set_enum(value, self->memory_export);
+            break;
+        }
+        case PROP_FRAME_MEMORY:
+        {
+            g_value_set_enum(value, self->frame_memory);
+            break;
+        }
+        case PROP_LOCK_MEMORY:
+        {
+            g_value_set_boolean(value, self->lock_memory);
+            break;
+        }
+        case PROP_JPEG_QUALITY:
+        {
+            g_value_set_int(value, self->jpeg_quality);
+            break;
+        }
+        case PROP_LOW_MEMORY:
+        {
+            g_value_set_boolean(value, self->low_memory);
+            break;
+        }
+        case PROP_WATCH:
+        {
+            g_value_set_boolean(value, self->watch);
+            break;
+        }
+        case PROP_DATA:
+        {
+            g_value_set_boxed(value, self->data);
+            break;
+        }
+        case PROP_PLAYLIST:
+        {
+            g_value_set_string(value, self->playlist);
+            break;
+        }
+        case PROP_SLIDE_DURATION:
+        {
+            g_value_set_uint(value, self->slide_duration);
+            break;
+        }
+        case PROP_PREFETCH:
+        {
+            g_value_set_uint(value, self->prefetch);
+            break;
+        }
+        case PROP_MATRIX:
+        {
+            g_value_set_enum(value, self->matrix);
+            break;
+        }
+        case PROP_RANGE:
+        {
+            g_value_set_enum(value, self->range);
+            break;
+        }
+        case PROP_OVERLAY:
+        {
+            g_value_set_enum(value, self->overlay);
+            break;
+        }
+        case PROP_OVERLAY_TEXT:
+        {
+            GST_OBJECT_LOCK(self);
+            g_value_set_string(value, self->overlay_text);
+            GST_OBJECT_UNLOCK(self);
+            break;
+        }
+        case PROP_OVERLAY_X:
+        {
+            GST_OBJECT_LOCK(self);
+            g_value_set_int(value, self->overlay_x);
+            GST_OBJECT_UNLOCK(self);
+            break;
+        }
+        case PROP_OVERLAY_Y:
+        {
+            GST_OBJECT_LOCK(self);
+            g_value_set_int(value, self->overlay_y);
+            GST_OBJECT_UNLOCK(self);
+            break;
+        }
+        case PROP_OVERLAY_SCALE:
+        {
+            GST_OBJECT_LOCK(self);
+            g_value_set_uint(value, self->overlay_scale);
+            GST_OBJECT_UNLOCK(self);
+            break;
+        }
+        case PROP_OVERLAY_COLOR:
+        {
+            GST_OBJECT_LOCK(self);
+            g_value_set_uint(value, self->overlay_color);
+            GST_OBJECT_UNLOCK(self);
+            break;
+        }
+        case PROP_OVERLAY_BACKGROUND:
+        {
+            GST_OBJECT_LOCK(self);
+            g_value_set_uint(value, self->overlay_background);
+            GST_OBJECT_UNLOCK(self);
+            break;
+        }
+        case PROP_STRIDE_ALIGN:
+        {
+            g_value_set_uint(value, self->stride_align);
+            break;
+        }
+        case PROP_STATS:
+        {
+            g_value_take_boxed(value, static_image_stats_to_structure(&self->stats));
+            break;
+        }
+        case PROP_STATS_INTERVAL:
+        {
+            g_value_set_uint(value, self->stats_interval);
+            break;
+        }
+        case PROP_ASYNC_START:
+        {
+            g_value_set_boolean(value, self->async_start);
+            break;
+        }
+        case PROP_PLACEHOLDER:
+        {
+            g_value_set_boolean(value, self->placeholder);
+            break;
+        }
+        case PROP_FILL_COLOR:
+        {
+            g_value_set_uint(value, self->fill_color);
+            break;
+        }
+        default:
+        {
+            G_OBJECT_CLASS(gst_static_png_src_parent_class)->get_property(object, prop_id, value, pspec);
+            break;
+        }
+    }
+}
 
-    /* Decode image (by file extension) to RGBA */
-    guint8* decoded = NULL;
+static gboolean gst_static_png_src_start(GstBaseSrc* src)
+{
+    GstStaticPngSrc* self = GST_STATICPNG_SRC(src);
+
+    /* First-buffer latency counts from here, so it covers the header probe, negotiation and the one-time build */
+    static_image_stats_reset(&self->stats);
+    self->stats_start = gst_util_get_timestamp();
+    self->stats_last_post = self->stats_start;
+
+    const gboolean use_playlist = self->data == NULL && self->playlist != NULL && self->playlist[0] != '\0';
+    if (self->data == NULL && !use_playlist && (self->location == NULL || self->location[0] == '\0'))
+    {
+        GST_ELEMENT_ERROR(self, RESOURCE, NOT_FOUND, ("None of 'location', 'playlist' or 'data' set"), (NULL));
+        return FALSE;
+    }
+
+    stop_playlist(self);
+    if (use_playlist)
+    {
+        self->playlist_items = static_image_playlist_load(self->playlist, self->slide_duration);
+        if (self->playlist_items == NULL)
+        {
+            GST_ELEMENT_ERROR(self, RESOURCE, NOT_FOUND, ("Playlist '%s' lists no images", self->playlist), (NULL));
+            return FALSE;
+        }
+        self->playlist_index = 0;
+        self->playlist_next = 1 % self->playlist_items->len;
+        self->slide_end_frame = slide_frames(self, 0);
+        GST_DEBUG_OBJECT(self, "playlist with %u images", self->playlist_items->len);
+    }
+
+    /*
+     * Read only the image header (type by file extension, or by signature for
+     * data); decoding is deferred until a frame is needed
+     */
+    GBytes* source = load_source(self);
+    ImageType type = IMAGE_TYPE_UNKNOWN;
+    if (self->data != NULL)
+    {
+        type = static_image_decode_is_png(self->data)    ? IMAGE_TYPE_PNG
+               : static_image_decode_is_jpeg(self->data) ? IMAGE_TYPE_JPEG
+                                                         : IMAGE_TYPE_UNKNOWN;
+    }
+    else
+    {
+        type = image_type_from_location(source_path(self));
+    }
     gint img_w = 0;
     gint img_h = 0;
 
-    gboolean decoded_ok = FALSE;
-    if (self->location != NULL)
+    gboolean probed_ok = FALSE;
+    self->animated = FALSE;
+    if (source != NULL && type == IMAGE_TYPE_PNG)
+    {
+        probed_ok = static_image_decode_png_size(source, &img_w, &img_h);
+        /* Playlist items always show their default image */
+        self->animated = self->playlist_items == NULL && static_image_apng_is_animated(source);
+    }
+    else if (source != NULL && type == IMAGE_TYPE_JPEG)
+    {
+        probed_ok = static_image_decode_jpeg_size(source, &img_w, &img_h);
+    }
+    if (source != NULL)
+    {
+        g_bytes_unref(source);
+    }
+    if (!probed_ok)
+    {
+        GST_ELEMENT_ERROR(self, RESOURCE, READ,
+                          ("Failed to decode image at '%s' (supported: png, jpg/jpeg/jpp)", source_name(self)), (NULL));
+        return FALSE;
+    }
+
+    GST_DEBUG_OBJECT(self, "%dx%d %simage, colour conversion kernel: %s", img_w, img_h,
+                     self->animated ? "animated " : "", static_image_convert_get_impl_name());
+
+    self->image_type = type;
+    self->image_width = img_w;
+    self->image_height = img_h;
+
+    /* Output size and format are chosen in set_caps() */
+    memset(&self->frame_layout, 0, sizeof(self->frame_layout));
+    self->shared_mem = NULL;
+
+    if (self->pool == NULL)
+    {
+        self->pool = static_image_buffer_pool_new();
+        if (self->pool == NULL)
+        {
+            GST_ELEMENT_ERROR(self, RESOURCE, FAILED, ("Failed to activate buffer pool"), (NULL));
+            return FALSE;
+        }
+    }
+
+    g_mutex_lock(&self->reload_lock);
+    self->reload_width = 0;
+    self->reload_height = 0;
+    g_mutex_unlock(&self->reload_lock);
+    /* In-memory data never changes; a playlist switches images anyway */
+    if (self->watch && self->data == NULL && self->playlist_items == NULL && self->watcher == NULL)
+    {
+        self->watcher = static_image_watch_new(self->location, reload_image, self);
+        if (self->watcher == NULL)
+        {
+            GST_ELEMENT_WARNING(self, RESOURCE, SETTINGS, ("Cannot watch '%s' for changes", self->location), (NULL));
+        }
+    }
+
+    self->frame_count = 0;
+    self->frame_index = 0;
+    self->running_time_offset = GST_CLOCK_TIME_NONE;
+    self->qos_dropped = 0;
+    GST_OBJECT_LOCK(self);
+    self->qos_earliest_time = GST_CLOCK_TIME_NONE;
+    GST_OBJECT_UNLOCK(self);
+    return TRUE;
+}
+
+static gboolean gst_static_png_src_stop(GstBaseSrc* src)
+{
+    GstStaticPngSrc* self = GST_STATICPNG_SRC(src);
+
+    /* Waits for a reload or async build in progress; its frame is dropped with the rest */
+    join_async_build(self);
+    static_image_watch_free(self->watcher);
+    self->watcher = NULL;
+    clear_reloaded_frame(self);
+    stop_playlist(self);
+
+    /* Buffers still downstream keep their own memory refs (and the pool alive until they return) */
+    release_frames(self);
+    if (self->pool != NULL)
+    {
+        gst_buffer_pool_set_active(self->pool, FALSE);
+        gst_object_unref(self->pool);
+        self->pool = NULL;
+    }
+
+    memset(&self->frame_layout, 0, sizeof(self->frame_layout));
+    self->image_width = 0;
+    self->image_height = 0;
+    self->actual_width = 0;
+    self->actual_height = 0;
+    self->frame_count = 0;
+
+    return TRUE;
+}
+
+/* Wakes a create() waiting for the async-start frame, for flushing seeks and state changes */
+static gboolean gst_static_png_src_unlock(GstBaseSrc* src)
+{
+    GstStaticPngSrc* self = GST_STATICPNG_SRC(src);
+
+    g_mutex_lock(&self->reload_lock);
+    self->async_flushing = TRUE;
+    g_cond_broadcast(&self->async_cond);
+    g_mutex_unlock(&self->reload_lock);
+    return TRUE;
+}
+
+static gboolean gst_static_png_src_unlock_stop(GstBaseSrc* src)
+{
+    GstStaticPngSrc* self = GST_STATICPNG_SRC(src);
+
+    g_mutex_lock(&self->reload_lock);
+    self->async_flushing = FALSE;
+    g_mutex_unlock(&self->reload_lock);
+    return TRUE;
+}
+
+static GstFlowReturn gst_static_png_src_create(GstPushSrc* src, GstBuffer** buf)
+{
+    GstStaticPngSrc* self = GST_STATICPNG_SRC(src);
+    const GstClockTime create_start = gst_util_get_timestamp();
+
+    if (self->async_pending)
+    {
+        GstFlowReturn ret = take_async_frame(self);
+        if (ret != GST_FLOW_OK)
+        {
+            return ret;
+        }
+    }
+    if (self->shared_mem == NULL)
+    {
+        GST_ELEMENT_ERROR(self, CORE, NEGOTIATION, ("No output format negotiated"), (NULL));
+        return GST_FLOW_NOT_NEGOTIATED;
+    }
+
+    /* While the placeholder is up the worker owns the frames; reloads, slides and animation wait for it */
+    const gboolean building = self->async_pending;
+    if (!building && g_atomic_int_get(&self->reload_ready))
+    {
+        swap_in_reloaded_frame(self);
+    }
+    if (!building && self->playlist_items != NULL && self->frame_index >= self->slide_end_frame)
     {
-        const gchar* dot = strrchr(self->location, '.');
-        if (dot != NULL && *(dot + 1) != '\0')
+        advance_playlist(self);
+    }
+
+    /* Live output starts at the running time of the first frame; base class syncs each buffer to the clock */
+    if (self->is_live && !GST_CLOCK_TIME_IS_VALID(self->running_time_offset))
+    {
+        self->running_time_offset = 0;
+        GstClock* clock = gst_element_get_clock(GST_ELEMENT(self));
+        if (clock != NULL)
         {
-            gchar* ext = g_ascii_strdown(dot + 1, -1);
-            if (ext != NULL)
+            GstClockTime now = gst_clock_get_time(clock);
+            GstClockTime base_time = gst_element_get_base_time(GST_ELEMENT(self));
+            if (now > base_time)
             {
-                if (g_strcmp0(ext, "png") == 0)
-                {
-                    decoded_ok = decode_png_to_rgba(self->location, &decoded, &img_w, &img_h);
-                }
-                else if (g_strcmp0(ext, "jpg") == 0 || g_strcmp0(ext, "jpeg") == 0 || g_strcmp0(ext, "jpp") == 0)
-                {
-                    decoded_ok = decode_jpeg_to_rgba(self->location, &decoded, &img_w, &img_h);
-                }
-                g_free(ext);
+                self->running_time_offset = now - base_time;
             }
+            gst_object_unref(clock);
         }
+        GST_DEBUG_OBJECT(self, "live output starts at running time %" GST_TIME_FORMAT,
+                         GST_TIME_ARGS(self->running_time_offset));
     }
-    if (!decoded_ok)
+    GstClockTime offset = self->is_live ? self->running_time_offset : 0;
+
+    skip_late_frames(self, offset);
+    if (!building && self->animation != NULL)
     {
-        GST_ELEMENT_ERROR(self, RESOURCE, READ,
-                          ("Failed to decode image at '%s' (supported: png, jpg/jpeg/jpp)", self->location), (NULL));
-        return FALSE;
+        advance_animation(self);
+    }
+    if ((self->overlay != STATIC_IMAGE_OVERLAY_NONE || self->overlay_shown != NULL) &&
+        !format_is_compressed(self->selected_format))
+    {
+        update_overlay(self);
+    }
+
+    /* Pooled buffers already carry the frame and its video meta; only timestamps change per frame */
+    GstBuffer* buffer = NULL;
+    GstBufferPool* pool = self->overlay_shown != NULL ? self->overlay_shown->pool : self->pool;
+    GstFlowReturn ret = gst_buffer_pool_acquire_buffer(pool, &buffer, NULL);
+    if (ret != GST_FLOW_OK)
+    {
+        return ret;
+    }
+
+    GstClockTime pts = offset + self->frame_index * self->frame_duration;
+    GST_BUFFER_PTS(buffer) = pts;
+    GST_BUFFER_DTS(buffer) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_DURATION(buffer) = self->frame_duration;
+
+    self->frame_index++;
+    self->frame_count++;
+    record_frame(self, buffer, create_start);
+
+    /* Check if we've reached the num-buffers limit */
+    if (self->num_buffers > 0 && self->frame_count >= self->num_buffers)
+    {
+        *buf = buffer;
+        return GST_FLOW_EOS;
     }
 
-    /* Determine output dimensions */
-    gint out_w = img_w;
-    gint out_h = img_h;
+    *buf = buffer;
+
+    return GST_FLOW_OK;
+}
 
-    /* Prefer downstream fixed caps if any (be safe on older GStreamer when not linked) */
-    GstCaps* peer_caps = NULL;
-    GstPad* srcpad = gst_element_get_static_pad(GST_ELEMENT(self), "src");
-    if (srcpad != NULL)
+static void gst_static_png_src_get_times(GstBaseSrc* src, GstBuffer* buffer, GstClockTime* start, GstClockTime* end)
+{
+    /* Only live sources sync; a non-live one runs as fast as downstream allows */
+    if (gst_base_src_is_live(src))
     {
-        if (gst_pad_is_linked(srcpad))
+        GstClockTime timestamp = GST_BUFFER_PTS(buffer);
+        if (GST_CLOCK_TIME_IS_VALID(timestamp))
         {
-            GstPad* peer = gst_pad_get_peer(srcpad);
-            if (peer != NULL)
+            *start = timestamp;
+            if (GST_BUFFER_DURATION_IS_VALID(buffer))
             {
-                peer_caps = gst_pad_query_caps(peer, NULL);
-                gst_object_unref(peer);
+                *end = timestamp + GST_BUFFER_DURATION(buffer);
             }
         }
-        if (peer_caps == NULL)
+    }
+    else
+    {
+        *start = GST_CLOCK_TIME_NONE;
+        *end = GST_CLOCK_TIME_NONE;
+    }
+}
+
+static gboolean gst_static_png_src_query(GstBaseSrc* src, GstQuery* query)
+{
+    GstStaticPngSrc* self = GST_STATICPNG_SRC(src);
+
+    if (GST_QUERY_TYPE(query) == GST_QUERY_LATENCY && self->is_live)
+    {
+        /* A frame is pushed at the running time it starts, so it is complete one frame duration later */
+        gst_query_set_latency(query, TRUE, self->frame_duration, self->frame_duration);
+        GST_DEBUG_OBJECT(self, "reporting latency %" GST_TIME_FORMAT, GST_TIME_ARGS(self->frame_duration));
+        return TRUE;
+    }
+
+    return GST_BASE_SRC_CLASS(gst_static_png_src_parent_class)->query(src, query);
+}
+
+static gboolean gst_static_png_src_event(GstBaseSrc* src, GstEvent* event)
+{
+    GstStaticPngSrc* self = GST_STATICPNG_SRC(src);
+
+    if (GST_EVENT_TYPE(event) == GST_EVENT_QOS)
+    {
+        GstQOSType type;
+        gdouble proportion;
+        GstClockTimeDiff diff;
+        GstClockTime timestamp;
+        gst_event_parse_qos(event, &type, &proportion, &diff, &timestamp);
+
+        GST_OBJECT_LOCK(self);
+        if (diff > 0 && GST_CLOCK_TIME_IS_VALID(timestamp))
+        {
+            self->qos_earliest_time = timestamp + (GstClockTime)diff;
+        }
+        else
         {
-            /* Fallback to our own template caps */
-            peer_caps = gst_pad_query_caps(srcpad, NULL);
+            self->qos_earliest_time = GST_CLOCK_TIME_NONE;
         }
-        gst_object_unref(srcpad);
+        GST_OBJECT_UNLOCK(self);
     }
-    if (peer_caps != NULL)
+
+    return GST_BASE_SRC_CLASS(gst_static_png_src_parent_class)->event(src, event);
+}
+
+/* Colorimetry the YUV (or, with with_matrix FALSE, the grey) output is converted with */
+static gchar* output_colorimetry(GstStaticPngSrc* self, gboolean with_matrix)
+{
+    GstVideoColorimetry cinfo;
+    cinfo.range = self->range == STATIC_IMAGE_RANGE_FULL ? GST_VIDEO_COLOR_RANGE_0_255 : GST_VIDEO_COLOR_RANGE_16_235;
+    cinfo.matrix = GST_VIDEO_COLOR_MATRIX_UNKNOWN;
+    cinfo.transfer = GST_VIDEO_TRANSFER_UNKNOWN;
+    cinfo.primaries = GST_VIDEO_COLOR_PRIMARIES_UNKNOWN;
+    if (with_matrix)
     {
-        for (guint i = 0; i < gst_caps_get_size(peer_caps); ++i)
+        switch (self->matrix)
         {
-            const GstStructure* s = gst_caps_get_structure(peer_caps, i);
-            gint w = 0;
-            gint h = 0;
-            const gchar* fmt = gst_structure_get_string(s, "format");
-            if (gst_structure_get_int(s, "width", &w) && gst_structure_get_int(s, "height", &h))
+            case STATIC_IMAGE_MATRIX_BT709:
+            {
+                cinfo.matrix = GST_VIDEO_COLOR_MATRIX_BT709;
+                cinfo.transfer = GST_VIDEO_TRANSFER_BT709;
+                cinfo.primaries = GST_VIDEO_COLOR_PRIMARIES_BT709;
+                break;
+            }
+            case STATIC_IMAGE_MATRIX_BT2020:
             {
-                if (w > 0 && h > 0)
-                {
-                    out_w = w;
-                    out_h = h;
-                }
+                cinfo.matrix = GST_VIDEO_COLOR_MATRIX_BT2020;
+                cinfo.transfer = GST_VIDEO_TRANSFER_BT2020_12;
+                cinfo.primaries = GST_VIDEO_COLOR_PRIMARIES_BT2020;
+                break;
             }
-            if (fmt != NULL)
+            default:
             {
-                if (g_strcmp0(fmt, "RGBA") == 0 || g_strcmp0(fmt, "BGRA") == 0 || g_strcmp0(fmt, "ARGB") == 0 ||
-                    g_strcmp0(fmt, "ABGR") == 0)
-                {
-                    g_strlcpy(self->selected_format, fmt, sizeof(self->selected_format));
-                }
+                cinfo.matrix = GST_VIDEO_COLOR_MATRIX_BT601;
+                cinfo.transfer = GST_VIDEO_TRANSFER_BT709;
+                cinfo.primaries = GST_VIDEO_COLOR_PRIMARIES_SMPTE170M;
+                break;
             }
         }
-        gst_caps_unref(peer_caps);
     }
+    return gst_video_colorimetry_to_string(&cinfo);
+}
+
+static GstCaps* gst_static_png_src_get_caps(GstBaseSrc* src, GstCaps* filter)
+{
+    GstStaticPngSrc* self = GST_STATICPNG_SRC(src);
 
-    /* Otherwise properties if provided */
+    /* Any size can be produced by scaling once; width/height properties pin it */
+    GstCaps* caps = gst_caps_make_writable(gst_pad_get_pad_template_caps(GST_BASE_SRC_PAD(src)));
     if (self->target_width > 0 && self->target_height > 0)
     {
-        out_w = self->target_width;
-        out_h = self->target_height;
+        gst_caps_set_simple(caps, "width", G_TYPE_INT, self->target_width, "height", G_TYPE_INT, self->target_height,
+                            NULL);
+    }
+    gst_caps_set_simple(caps, "framerate", GST_TYPE_FRACTION, self->fps_n, self->fps_d, NULL);
+
+    /* Structures 1 and 2 of the template are YUV and GRAY8; tell downstream how they were converted */
+    for (guint i = 1; i <= 2; ++i)
+    {
+        gchar* colorimetry = output_colorimetry(self, i == 1);
+        if (colorimetry != NULL)
+        {
+            gst_structure_set(gst_caps_get_structure(caps, i), "colorimetry", G_TYPE_STRING, colorimetry, NULL);
+        }
+        g_free(colorimetry);
+    }
+
+    /* The compressed caps the file can pass through as go first: image/png for a PNG */
+    if (self->image_type == IMAGE_TYPE_PNG)
+    {
+        gst_caps_append_structure(caps, gst_caps_steal_structure(caps, 3));
+    }
+
+    if (filter != NULL)
+    {
+        GstCaps* filtered = gst_caps_intersect_full(filter, caps, GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref(caps);
+        caps = filtered;
+    }
+
+    return caps;
+}
+
+static GstCaps* gst_static_png_src_fixate(GstBaseSrc* src, GstCaps* caps)
+{
+    GstStaticPngSrc* self = GST_STATICPNG_SRC(src);
+
+    /* Prefer RGBA at the image's own size, i.e. no conversion and no scaling */
+    caps = gst_caps_truncate(gst_caps_make_writable(caps));
+    GstStructure* s = gst_caps_get_structure(caps, 0);
+    gst_structure_fixate_field_string(s, "format", "RGBA");
+    if (self->image_width > 0 && self->image_height > 0)
+    {
+        gst_structure_fixate_field_nearest_int(s, "width", self->image_width);
+        gst_structure_fixate_field_nearest_int(s, "height", self->image_height);
+    }
+    gst_structure_fixate_field_nearest_fraction(s, "framerate", self->fps_n, self->fps_d);
+
+    return GST_BASE_SRC_CLASS(gst_static_png_src_parent_class)->fixate(src, caps);
+}
+
+static gboolean gst_static_png_src_set_caps(GstBaseSrc* src, GstCaps* caps)
+{
+    GstStaticPngSrc* self = GST_STATICPNG_SRC(src);
+
+    /* image/jpeg and image/png have no GstVideoInfo; they carry only the size */
+    const GstStructure* s = gst_caps_get_structure(caps, 0);
+    const gchar* fmt = gst_structure_has_name(s, "image/jpeg")  ? "JPEG"
+                       : gst_structure_has_name(s, "image/png") ? "PNG"
+                                                                 : NULL;
+    gint width = 0;
+    gint height = 0;
+    GstVideoInfo info;
+    if (fmt == NULL && gst_video_info_from_caps(&info, caps))
+    {
+        fmt = gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(&info));
+        width = GST_VIDEO_INFO_WIDTH(&info);
+        height = GST_VIDEO_INFO_HEIGHT(&info);
+    }
+    else if (fmt != NULL)
+    {
+        gst_structure_get_int(s, "width", &width);
+        gst_structure_get_int(s, "height", &height);
+    }
+    if (self->image_width <= 0 || fmt == NULL || width <= 0 || height <= 0)
+    {
+        GST_WARNING_OBJECT(self, "cannot handle caps %" GST_PTR_FORMAT, caps);
+        return FALSE;
+    }
+
+    /* A build still running for the previous caps has the frames; what it built stays cached */
+    join_async_build(self);
+
+    /* Every cached frame depends on the output size */
+    if (width != self->actual_width || height != self->actual_height)
+    {
+        release_frames(self);
+        self->actual_width = width;
+        self->actual_height = height;
+    }
+
+    GST_DEBUG_OBJECT(self, "negotiated %" GST_PTR_FORMAT, caps);
+    return select_output_format(self, fmt);
+}
+
+/* Helpers */
+
+/* Counts a buffer leaving create() and posts the stats once stats-interval has passed */
+static void record_frame(GstStaticPngSrc* self, GstBuffer* buffer, GstClockTime create_start)
+{
+    const GstClockTime now = gst_util_get_timestamp();
+    static_image_stats_add_frame(&self->stats, now - create_start, gst_buffer_get_size(buffer));
+    if (self->frame_count == 1)
+    {
+        static_image_stats_set_first_buffer(&self->stats, now - self->stats_start);
+    }
+
+    const guint interval = self->stats_interval;
+    if (interval > 0 && now - self->stats_last_post >= (GstClockTime)interval * GST_MSECOND)
+    {
+        self->stats_last_post = now;
+        GstStructure* stats = static_image_stats_to_structure(&self->stats);
+        gst_element_post_message(GST_ELEMENT(self), gst_message_new_element(GST_OBJECT(self), stats));
+    }
+}
+
+/* Advances frame_index past frames that would end before the QoS earliest time instead of pushing them late */
+static void skip_late_frames(GstStaticPngSrc* self, GstClockTime offset)
+{
+    GST_OBJECT_LOCK(self);
+    GstClockTime earliest = self->qos_earliest_time;
+    GST_OBJECT_UNLOCK(self);
+
+    GstClockTime pts = offset + self->frame_index * self->frame_duration;
+    if (!GST_CLOCK_TIME_IS_VALID(earliest) || self->frame_duration == 0 || pts + self->frame_duration > earliest)
+    {
+        return;
+    }
+
+    /* First slot whose frame ends after earliest */
+    guint64 skip = (earliest - offset) / self->frame_duration - self->frame_index;
+    self->frame_index += skip;
+    self->qos_dropped += skip;
+
+    GST_DEBUG_OBJECT(self, "dropping %" G_GUINT64_FORMAT " late frames at %" GST_TIME_FORMAT, skip,
+                     GST_TIME_ARGS(pts));
+
+    GstMessage* msg = gst_message_new_qos(GST_OBJECT(self), self->is_live, pts, pts, pts, skip * self->frame_duration);
+    gst_message_set_qos_stats(msg, GST_FORMAT_BUFFERS, self->frame_count, self->qos_dropped);
+    gst_element_post_message(GST_ELEMENT(self), msg);
+}
+
+static ImageType image_type_from_location(const gchar* path)
+{
+    ImageType type = IMAGE_TYPE_UNKNOWN;
+    const gchar* dot = path != NULL ? strrchr(path, '.') : NULL;
+    if (dot != NULL && *(dot + 1) != '\0')
+    {
+        gchar* ext = g_ascii_strdown(dot + 1, -1);
+        if (g_strcmp0(ext, "png") == 0)
+        {
+            type = IMAGE_TYPE_PNG;
+        }
+        else if (g_strcmp0(ext, "jpg") == 0 || g_strcmp0(ext, "jpeg") == 0 || g_strcmp0(ext, "jpp") == 0)
+        {
+            type = IMAGE_TYPE_JPEG;
+        }
+        g_free(ext);
+    }
+    return type;
+}
+
+/* File the current image comes from: the playlist item on screen, or location */
+static const gchar* source_path(GstStaticPngSrc* self)
+{
+    if (self->playlist_items != NULL)
+    {
+        return ((StaticImagePlaylistItem*)g_ptr_array_index(self->playlist_items, self->playlist_index))->path;
+    }
+    return self->location;
+}
+
+/*
+ * Encoded image to decode: the data property, or the file loaded freshly so a
+ * replaced file is seen. Mapped, unless watch expects it to be rewritten.
+ */
+static GBytes* load_source(GstStaticPngSrc* self)
+{
+    if (self->data != NULL)
+    {
+        return g_bytes_ref(self->data);
+    }
+    if (self->watch)
+    {
+        return static_image_decode_read_file(source_path(self));
+    }
+    return static_image_decode_map_file(source_path(self));
+}
+
+/* As load_source(), but never a mapping, for bytes a frame keeps beyond the build */
+static GBytes* load_source_copy(GstStaticPngSrc* self)
+{
+    if (self->data != NULL)
+    {
+        return g_bytes_ref(self->data);
+    }
+    return static_image_decode_read_file(source_path(self));
+}
+
+/* For messages */
+static const gchar* source_name(GstStaticPngSrc* self)
+{
+    return self->data != NULL ? "<data>" : source_path(self);
+}
+
+static gboolean has_cache_dir(GstStaticPngSrc* self)
+{
+    return self->cache_dir != NULL && self->cache_dir[0] != '\0';
+}
+
+/* Output frames use the negotiated layout; the RGBA conversion source is always packed */
+static gboolean frame_layout_for(GstStaticPngSrc* self, const gchar* format, gboolean is_output,
+                                 StaticImageFrameLayout* layout)
+{
+    return is_output ? output_layout(self, format, self->actual_width, self->actual_height, layout)
+                     : static_image_frame_layout_init(layout, format, self->actual_width, self->actual_height);
+}
+
+/* Tries cache-dir before building. Output frames are written back on a miss and exported per memory-export. */
+static GstMemory* build_via_disk_cache(gpointer user_data)
+{
+    FrameRequest* request = (FrameRequest*)user_data;
+    GstStaticPngSrc* self = request->self;
+
+    /* Compressed frames have no size until encoded, so the cache file could not be checked against the layout */
+    StaticImageFrameLayout layout;
+    const gboolean use_disk =
+        request->key != NULL && has_cache_dir(self) && !format_is_compressed(request->format) &&
+        frame_layout_for(self, request->format, request->is_output, &layout);
+
+    GstMemory* memory = NULL;
+    if (use_disk)
+    {
+        memory = static_image_disk_cache_load(self->cache_dir, request->key, request->format, &layout);
+        if (memory != NULL)
+        {
+            GST_DEBUG_OBJECT(self, "mapped %s frame from %s", request->format, self->cache_dir);
+        }
+    }
+    if (memory == NULL)
+    {
+        memory = request->build_func(request->user_data);
+        if (memory != NULL && use_disk && request->is_output &&
+            !static_image_disk_cache_store(self->cache_dir, request->key, request->format, &layout, memory))
+        {
+            GST_WARNING_OBJECT(self, "failed to write %s frame to %s", request->format, self->cache_dir);
+        }
+    }
+
+    if (memory != NULL && request->is_output)
+    {
+        memory = export_output_frame(self, memory, request->format);
+    }
+    return memory;
+}
+
+/* The allocator for frame-memory and lock-memory, NULL for plain system memory */
+static GstAllocator* frame_allocator(GstStaticPngSrc* self)
+{
+    if (self->frame_memory == STATIC_IMAGE_FRAME_MEMORY_SYSTEM && !self->lock_memory)
+    {
+        return NULL;
+    }
+    return static_image_allocator_get(self->frame_memory, self->lock_memory);
+}
+
+/* Copies memory once into frame_allocator() memory; keeps it as-is if that is disabled or fails */
+static GstMemory* place_output_frame(GstStaticPngSrc* self, GstMemory* memory, const gchar* format)
+{
+    GstAllocator* allocator = frame_allocator(self);
+    if (allocator == NULL)
+    {
+        return memory;
+    }
+
+    GstMemory* placed = static_image_allocator_copy(allocator, memory);
+    if (placed == NULL)
+    {
+        GST_WARNING_OBJECT(self, "cannot allocate %s frame from %s, using system memory", format,
+                           allocator->mem_type);
+        return memory;
+    }
+    if (self->lock_memory && !static_image_allocator_is_locked(placed))
+    {
+        GST_WARNING_OBJECT(self, "cannot mlock %s frame (RLIMIT_MEMLOCK too low?), using it unlocked", format);
+    }
+
+    GST_DEBUG_OBJECT(self, "placed %s frame in %s memory%s", format,
+                     static_image_allocator_is_huge(placed) ? "huge-page" : "aligned",
+                     static_image_allocator_is_locked(placed) ? ", locked" : "");
+    gst_memory_unref(memory);
+    return placed;
+}
+
+/* Moves memory into fd memory per memory-export, or placed per frame-memory if that is disabled */
+static GstMemory* export_output_frame(GstStaticPngSrc* self, GstMemory* memory, const gchar* format)
+{
+    if (self->memory_export == STATIC_IMAGE_EXPORT_NONE)
+    {
+        return place_output_frame(self, memory, format);
+    }
+
+    GstMemory* exported = static_image_export_memory(memory, self->memory_export);
+    if (exported == NULL)
+    {
+        GST_WARNING_OBJECT(self, "fd export of %s frame failed, using system memory", format);
+        return memory;
+    }
+
+    GST_DEBUG_OBJECT(self, "exported %s frame as %s memory", format, exported->allocator->mem_type);
+    gst_memory_unref(memory);
+    return exported;
+}
+
+/* On success *out_key is the shared cache key to release with the memory (NULL if not shared) */
+static GstMemory* acquire_shared_memory(GstStaticPngSrc* self, const gchar* format, gboolean is_output,
+                                        StaticImageCacheBuildFunc build_func, gpointer user_data, gchar** out_key)
+{
+    *out_key = NULL;
+    gchar* key = NULL;
+    if (self->shared_cache || has_cache_dir(self))
+    {
+        /*
+         * YUV frames also depend on how they were converted, re-encoded JPEG
+         * on its quality, and every frame on its plane layout
+         */
+        StaticImageFrameLayout layout;
+        if (!frame_layout_for(self, format, is_output, &layout))
+        {
+            return NULL;
+        }
+        gchar* strides = g_strdup_printf("%d/%d/%d/%d", layout.strides[0], layout.strides[1], layout.strides[2],
+                                         layout.strides[3]);
+        gchar* variant = static_image_convert_is_yuv(format)
+                             ? g_strdup_printf("scale=%d,matrix=%d,range=%d,strides=%s", (gint)self->scale_method,
+                                               (gint)self->matrix, (gint)self->range, strides)
+                         : g_strcmp0(format, "JPEG") == 0
+                             ? g_strdup_printf("scale=%d,quality=%d", (gint)self->scale_method, self->jpeg_quality)
+                             : g_strdup_printf("scale=%d,strides=%s", (gint)self->scale_method, strides);
+        g_free(strides);
+        key = self->data != NULL ? static_image_cache_make_data_key(self->data, self->actual_width,
+                                                                    self->actual_height, format, variant)
+                                 : static_image_cache_make_key(source_path(self), self->actual_width,
+                                                               self->actual_height, format, variant);
+        g_free(variant);
+    }
+
+    FrameRequest request = {self, format, key, is_output, build_func, user_data};
+    GstMemory* memory = NULL;
+    if (key != NULL && self->shared_cache)
+    {
+        /* Exported or placed output frames are a different kind of memory than the same pixels in system memory */
+        gchar* shared_key = !is_output ? g_strdup(key)
+                            : self->memory_export != STATIC_IMAGE_EXPORT_NONE
+                                ? g_strdup_printf("%s|export=%d", key, (gint)self->memory_export)
+                            : frame_allocator(self) != NULL
+                                ? g_strdup_printf("%s|memory=%d,lock=%d", key, (gint)self->frame_memory,
+                                                  (gint)self->lock_memory)
+                                : g_strdup(key);
+        memory = static_image_cache_acquire(shared_key, build_via_disk_cache, &request);
+        if (memory != NULL)
+        {
+            *out_key = shared_key;
+        }
+        else
+        {
+            g_free(shared_key);
+        }
+    }
+    else
+    {
+        memory = build_via_disk_cache(&request);
+    }
+
+    g_free(key);
+    return memory;
+}
+
+/*
+ * The output frame for fmt at the output size, from format_frames or built
+ * now (decode, scale, convert). NULL with the error posted if it cannot be
+ * built. Runs on the async-start worker too, which has the frames to itself
+ * until it is joined.
+ */
+static GstMemory* build_output_frame(GstStaticPngSrc* self, const gchar* fmt, const StaticImageFrameLayout* layout)
+{
+    GstMemory* memory = self->animated ? ensure_animation(self, fmt) : NULL;
+    FormatFrame* frame = &self->format_frames[output_format_slot(fmt)];
+    if (memory != NULL)
+    {
+        GST_DEBUG_OBJECT(self, "%u-frame animation as %s", self->animation->n_frames, fmt);
+        return memory;
+    }
+    if (frame->memory != NULL)
+    {
+        GST_DEBUG_OBJECT(self, "reusing %s frame", fmt);
+        return frame->memory;
+    }
+
+    /* Unpadded RGBA output is the decoded image itself, unless low-memory is to avoid keeping that */
+    if (layout_is_packed_rgba(fmt, layout) && !self->low_memory)
+    {
+        if (!ensure_rgba(self, TRUE))
+        {
+            return NULL;
+        }
+        frame->memory = gst_memory_ref(self->rgba_mem);
+        return frame->memory;
+    }
+
+    FrameBuild build = {self, fmt, FALSE};
+    frame->memory = acquire_shared_memory(self, fmt, TRUE, build_frame_memory, &build, &frame->key);
+    if (frame->memory == NULL)
+    {
+        /* Without rgba_data, ensure_rgba() has already posted the decode error */
+        if (self->rgba_data != NULL)
+        {
+            GST_ELEMENT_ERROR(self, STREAM, FORMAT, ("RGBA->%s conversion failed", fmt), (NULL));
+        }
+    }
+    return frame->memory;
+}
+
+static gboolean select_output_format(GstStaticPngSrc* self, const gchar* fmt)
+{
+    const gint slot = output_format_slot(fmt);
+    StaticImageFrameLayout layout;
+    if (slot < 0 || !output_layout(self, fmt, self->actual_width, self->actual_height, &layout))
+    {
+        GST_ELEMENT_ERROR(self, CORE, NEGOTIATION, ("Unsupported output format %s", fmt), (NULL));
+        return FALSE;
+    }
+
+    if (self->shared_mem != NULL)
+    {
+        gst_memory_unref(self->shared_mem);
+        self->shared_mem = NULL;
+    }
+    self->frame_layout = layout;
+    g_strlcpy(self->selected_format, fmt, sizeof(self->selected_format));
+    if (format_is_compressed(fmt) && self->overlay != STATIC_IMAGE_OVERLAY_NONE)
+    {
+        GST_WARNING_OBJECT(self, "overlay is not drawn on %s output", fmt);
+    }
+
+    const gboolean cached = !self->animated && self->format_frames[slot].memory != NULL;
+    if (self->async_start && !cached)
+    {
+        /* create() pushes the placeholder, or waits, until the worker is done */
+        self->shared_mem = self->placeholder ? build_placeholder(self, fmt, &layout) : NULL;
+        start_async_build(self);
+    }
+    else
+    {
+        GstMemory* memory = build_output_frame(self, fmt, &layout);
+        if (memory == NULL)
+        {
+            return FALSE;
+        }
+        self->shared_mem = gst_memory_ref(memory);
+    }
+    if (self->shared_mem != NULL)
+    {
+        show_shared_frame(self);
+    }
+
+    g_mutex_lock(&self->reload_lock);
+    self->reload_width = self->actual_width;
+    self->reload_height = self->actual_height;
+    g_strlcpy(self->reload_format, fmt, sizeof(self->reload_format));
+    g_mutex_unlock(&self->reload_lock);
+
+    /* Upcoming playlist items are built for the new output */
+    if (self->playlist_items != NULL && self->playlist_items->len > 1)
+    {
+        if (self->prefetcher != NULL)
+        {
+            static_image_prefetch_reset(self->prefetcher);
+        }
+        else
+        {
+            self->prefetcher = static_image_prefetch_new(self->playlist_items->len, self->prefetch,
+                                                         build_playlist_frame, self);
+            if (self->prefetcher == NULL)
+            {
+                GST_ELEMENT_WARNING(self, RESOURCE, FAILED, ("Cannot start playlist prefetch, showing one image"),
+                                    (NULL));
+            }
+        }
+    }
+    return TRUE;
+}
+
+/* A fill-color frame in fmt, pushed while the async-start worker builds the real one */
+static GstMemory* build_placeholder(GstStaticPngSrc* self, const gchar* fmt, const StaticImageFrameLayout* layout)
+{
+    const gsize n_pixels = (gsize)layout->width * (gsize)layout->height;
+    const guint8 pixel[4] = {(guint8)(self->fill_color >> 16), (guint8)(self->fill_color >> 8),
+                             (guint8)self->fill_color, 255};
+    guint8* rgba = (guint8*)g_malloc(n_pixels * 4);
+    for (gsize i = 0; i < n_pixels; ++i)
+    {
+        memcpy(rgba + i * 4, pixel, 4);
+    }
+
+    gsize size = n_pixels * 4;
+    guint8* data = rgba;
+    if (!layout_is_packed_rgba(fmt, layout))
+    {
+        data = convert_from_rgba(self, rgba, fmt, layout, &size);
+        g_free(rgba);
+        if (data == NULL)
+        {
+            return NULL;
+        }
+    }
+    return gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY, data, size, 0, size, data, (GDestroyNotify)g_free);
+}
+
+static gpointer async_build_thread(gpointer user_data)
+{
+    GstStaticPngSrc* self = (GstStaticPngSrc*)user_data;
+
+    /* selected_format and frame_layout stay put until the streaming thread joins this thread */
+    GstMemory* memory = build_output_frame(self, self->selected_format, &self->frame_layout);
+
+    g_mutex_lock(&self->reload_lock);
+    self->async_memory = memory;
+    self->async_done = TRUE;
+    g_cond_broadcast(&self->async_cond);
+    g_mutex_unlock(&self->reload_lock);
+    return NULL;
+}
+
+/* Builds the negotiated frame on a worker; falls back to building it here if no thread can be started */
+static void start_async_build(GstStaticPngSrc* self)
+{
+    g_mutex_lock(&self->reload_lock);
+    self->async_done = FALSE;
+    self->async_memory = NULL;
+    g_mutex_unlock(&self->reload_lock);
+
+    GST_DEBUG_OBJECT(self, "building the %dx%d %s frame asynchronously", self->actual_width, self->actual_height,
+                     self->selected_format);
+    self->async_pending = TRUE;
+    self->async_thread = g_thread_try_new("staticimagesrc-build", async_build_thread, self, NULL);
+    if (self->async_thread == NULL)
+    {
+        GST_WARNING_OBJECT(self, "cannot start the build thread, building in the streaming thread");
+        async_build_thread(self);
+    }
+}
+
+/*
+ * Installs the async-start frame once the worker is done. Without a
+ * placeholder to push meanwhile, waits for it or for unlock().
+ */
+static GstFlowReturn take_async_frame(GstStaticPngSrc* self)
+{
+    g_mutex_lock(&self->reload_lock);
+    while (!self->async_done && self->shared_mem == NULL && !self->async_flushing)
+    {
+        g_cond_wait(&self->async_cond, &self->reload_lock);
+    }
+    const gboolean done = self->async_done;
+    GstMemory* memory = self->async_memory;
+    g_mutex_unlock(&self->reload_lock);
+    if (!done)
+    {
+        return self->shared_mem != NULL ? GST_FLOW_OK : GST_FLOW_FLUSHING;
+    }
+
+    join_async_build(self);
+    if (memory == NULL)
+    {
+        /* The worker has posted the error */
+        return GST_FLOW_ERROR;
+    }
+    if (self->shared_mem != NULL)
+    {
+        gst_memory_unref(self->shared_mem);
+    }
+    self->shared_mem = gst_memory_ref(memory);
+    show_shared_frame(self);
+    GST_DEBUG_OBJECT(self, "async-built %s frame is up", self->selected_format);
+    return GST_FLOW_OK;
+}
+
+/* Waits for the worker; what it built stays in format_frames or animation */
+static void join_async_build(GstStaticPngSrc* self)
+{
+    if (self->async_thread != NULL)
+    {
+        g_thread_join(self->async_thread);
+        self->async_thread = NULL;
+    }
+    self->async_pending = FALSE;
+    self->async_done = FALSE;
+    self->async_memory = NULL;
+}
+
+/* Makes the scaled RGBA image available in rgba_data, decoding it on first use */
+static gboolean ensure_rgba(GstStaticPngSrc* self, gboolean is_output)
+{
+    if (self->rgba_data != NULL)
+    {
+        return TRUE;
+    }
+
+    FrameBuild build = {self, "RGBA", FALSE};
+    self->rgba_mem = acquire_shared_memory(self, "RGBA", is_output, build_rgba_memory, &build, &self->rgba_key);
+    if (self->rgba_mem == NULL)
+    {
+        if (build.decode_failed)
+        {
+            GST_ELEMENT_ERROR(self, RESOURCE, READ,
+                              ("Failed to decode image at '%s' (supported: png, jpg/jpeg/jpp)", source_name(self)),
+                              (NULL));
+        }
+        else
+        {
+            GST_ELEMENT_ERROR(self, STREAM, FORMAT, ("Failed to scale image"), (NULL));
+        }
+        return FALSE;
+    }
+    if (!gst_memory_map(self->rgba_mem, &self->rgba_map, GST_MAP_READ))
+    {
+        release_frames(self);
+        GST_ELEMENT_ERROR(self, RESOURCE, FAILED, ("Failed to map decoded image"), (NULL));
+        return FALSE;
+    }
+
+    self->rgba_stride = self->actual_width * 4;
+    self->rgba_size = (gsize)self->rgba_stride * (gsize)self->actual_height;
+    self->rgba_data = self->rgba_map.data;
+    return TRUE;
+}
+
+/*
+ * Builds the APNG frame ring for the negotiated output and returns the frame
+ * for the current position. The ring bypasses the shared and disk caches. If
+ * the animation cannot be decoded, the default image is shown instead.
+ */
+static GstMemory* ensure_animation(GstStaticPngSrc* self, const gchar* fmt)
+{
+    frame_ring_free(self->animation);
+    self->animation = NULL;
+
+    GBytes* source = load_source(self);
+    if (source != NULL)
+    {
+        self->animation = build_frame_ring(self, source, self->actual_width, self->actual_height, fmt);
+        g_bytes_unref(source);
+    }
+    if (self->animation == NULL)
+    {
+        GST_ELEMENT_WARNING(self, STREAM, DECODE,
+                            ("Cannot decode the animation in '%s', showing its default image", source_name(self)),
+                            (NULL));
+        self->animated = FALSE;
+        return NULL;
+    }
+
+    self->animation_index = frame_ring_index_at(self->animation, self->frame_index * self->frame_duration);
+    return self->animation->frames[self->animation_index];
+}
+
+static void release_frames(GstStaticPngSrc* self)
+{
+    if (self->shared_mem != NULL)
+    {
+        gst_memory_unref(self->shared_mem);
+        self->shared_mem = NULL;
+    }
+    for (gint i = 0; i < N_OUTPUT_FORMATS; ++i)
+    {
+        FormatFrame* frame = &self->format_frames[i];
+        if (frame->memory != NULL)
+        {
+            gst_memory_unref(frame->memory);
+            frame->memory = NULL;
+        }
+        if (frame->key != NULL)
+        {
+            static_image_cache_release(frame->key);
+            g_free(frame->key);
+            frame->key = NULL;
+        }
+    }
+
+    if (self->rgba_mem != NULL)
+    {
+        if (self->rgba_data != NULL)
+        {
+            gst_memory_unmap(self->rgba_mem, &self->rgba_map);
+        }
+        gst_memory_unref(self->rgba_mem);
+        self->rgba_mem = NULL;
+    }
+    if (self->rgba_key != NULL)
+    {
+        static_image_cache_release(self->rgba_key);
+        g_free(self->rgba_key);
+        self->rgba_key = NULL;
+    }
+    self->rgba_data = NULL;
+    self->rgba_size = 0;
+    self->rgba_stride = 0;
+
+    frame_ring_free(self->animation);
+    self->animation = NULL;
+
+    release_overlay(self);
+}
+
+/*
+ * Decodes the JPEG to RGBA, shrunk in the DCT domain as far as it can go
+ * while staying at least width x height, so the resampler only has to cover
+ * the remaining factor below 2x. Also reports the image's own dimensions.
+ */
+static gboolean decode_jpeg_at_least(GBytes* source, gint width, gint height, guint8** out_pixels, gint* out_w,
+                                     gint* out_h, gint* out_img_w, gint* out_img_h)
+{
+    return static_image_decode_jpeg_size(source, out_img_w, out_img_h) &&
+           static_image_decode_jpeg(source, width, height, out_pixels, out_w, out_h);
+}
+
+/* Decodes source and scales it to width x height; *decode_failed tells a bad file from a failed scale */
+static guint8* decode_scaled_rgba(GstStaticPngSrc* self, GBytes* source, ImageType type, gint width, gint height,
+                                  gint* out_img_w, gint* out_img_h, gboolean* decode_failed)
+{
+    guint8* decoded = NULL;
+    gint img_w = 0;
+    gint img_h = 0;
+    gint dec_w = 0;
+    gint dec_h = 0;
+    gboolean decoded_ok = FALSE;
+    const GstClockTime start = gst_util_get_timestamp();
+    if (type == IMAGE_TYPE_PNG)
+    {
+        decoded_ok = static_image_decode_png(source, &decoded, &img_w, &img_h);
+        dec_w = img_w;
+        dec_h = img_h;
+    }
+    else if (type == IMAGE_TYPE_JPEG)
+    {
+        decoded_ok = decode_jpeg_at_least(source, width, height, &decoded, &dec_w, &dec_h, &img_w, &img_h);
+    }
+    if (!decoded_ok)
+    {
+        *decode_failed = TRUE;
+        return NULL;
+    }
+    static_image_stats_add_stage(&self->stats, STATIC_IMAGE_STAGE_DECODE, gst_util_get_timestamp() - start);
+
+    GST_DEBUG_OBJECT(self, "decoded %dx%d image at %dx%d", img_w, img_h, dec_w, dec_h);
+    *out_img_w = img_w;
+    *out_img_h = img_h;
+
+    guint8* pixels = decoded;
+    if (width != dec_w || height != dec_h)
+    {
+        pixels = scale_rgba(self, decoded, dec_w, dec_h, width, height);
+        g_free(decoded);
+    }
+    return pixels;
+}
+
+/*
+ * Layout of an output frame of fmt: GStreamer's default plane layout (what
+ * downstream without video meta support assumes), with every plane's rows
+ * padded to stride-align bytes.
+ */
+static gboolean output_layout(GstStaticPngSrc* self, const gchar* fmt, gint width, gint height,
+                              StaticImageFrameLayout* layout)
+{
+    /* Compressed frames have no planes, and their size is only known once encoded */
+    if (format_is_compressed(fmt))
+    {
+        memset(layout, 0, sizeof(*layout));
+        layout->width = width;
+        layout->height = height;
+        return TRUE;
+    }
+
+    GstVideoInfo info;
+    gst_video_info_init(&info);
+    if (!gst_video_info_set_format(&info, gst_video_format_from_string(fmt), (guint)width, (guint)height))
+    {
+        return FALSE;
+    }
+    if (self->stride_align > 1)
+    {
+        GstVideoAlignment align;
+        gst_video_alignment_reset(&align);
+        for (guint i = 0; i < GST_VIDEO_MAX_PLANES; ++i)
+        {
+            align.stride_align[i] = self->stride_align - 1;
+        }
+        if (!gst_video_info_align(&info, &align))
+        {
+            return FALSE;
+        }
+    }
+
+    memset(layout, 0, sizeof(*layout));
+    layout->width = width;
+    layout->height = height;
+    layout->n_planes = GST_VIDEO_INFO_N_PLANES(&info);
+    for (guint p = 0; p < layout->n_planes; ++p)
+    {
+        layout->strides[p] = GST_VIDEO_INFO_PLANE_STRIDE(&info, p);
+        layout->offsets[p] = GST_VIDEO_INFO_PLANE_OFFSET(&info, p);
+    }
+    layout->size = GST_VIDEO_INFO_SIZE(&info);
+    return TRUE;
+}
+
+/* Encodes the RGBA image once for JPEG or PNG output; timed as a conversion */
+static guint8* encode_from_rgba(GstStaticPngSrc* self, const guint8* rgba, const gchar* fmt, gint width, gint height,
+                                gsize* out_size)
+{
+    guint8* data = NULL;
+    const GstClockTime start = gst_util_get_timestamp();
+    const gboolean ok = g_strcmp0(fmt, "JPEG") == 0
+                            ? static_image_encode_jpeg(rgba, width, height, self->jpeg_quality, &data, out_size)
+                            : static_image_encode_png(rgba, width, height, &data, out_size);
+    if (!ok)
+    {
+        return NULL;
+    }
+    static_image_stats_add_stage(&self->stats, STATIC_IMAGE_STAGE_CONVERT, gst_util_get_timestamp() - start);
+    return data;
+}
+
+/* Writes the packed RGBA image into dst as raw fmt in layout; untimed, for callers that are not a frame build */
+static void convert_rgba_into(GstStaticPngSrc* self, const guint8* rgba, const gchar* fmt,
+                              const StaticImageFrameLayout* layout, guint8* dst)
+{
+    const gint width = layout->width;
+    const gint height = layout->height;
+    if (static_image_convert_is_yuv(fmt))
+    {
+        static_image_convert_rgba_to_yuv(rgba, width * 4, fmt, layout, dst, self->matrix,
+                                         self->range == STATIC_IMAGE_RANGE_FULL, self->n_threads);
+    }
+    else
+    {
+        for (gint y = 0; y < height; ++y)
+        {
+            memcpy(dst + layout->offsets[0] + (gsize)y * layout->strides[0], rgba + (gsize)y * width * 4,
+                   (gsize)width * 4);
+        }
+        swizzle_from_rgba_inplace(dst + layout->offsets[0], layout->strides[0], width, height, fmt, self->n_threads);
+    }
+}
+
+/*
+ * Returns a new frame of fmt (any output format, RGBA included) in layout,
+ * holding *out_size bytes. JPEG and PNG are encoded instead.
+ */
+static guint8* convert_from_rgba(GstStaticPngSrc* self, const guint8* rgba, const gchar* fmt,
+                                 const StaticImageFrameLayout* layout, gsize* out_size)
+{
+    if (rgba == NULL)
+    {
+        return NULL;
+    }
+    if (format_is_compressed(fmt))
+    {
+        return encode_from_rgba(self, rgba, fmt, layout->width, layout->height, out_size);
+    }
+
+    /* Row padding is zeroed rather than left as heap garbage; this runs once per frame built */
+    guint8* dst = (guint8*)g_malloc0(layout->size);
+    if (dst == NULL)
+    {
+        return NULL;
+    }
+    const GstClockTime start = gst_util_get_timestamp();
+    convert_rgba_into(self, rgba, fmt, layout, dst);
+    static_image_stats_add_stage(&self->stats, STATIC_IMAGE_STAGE_CONVERT, gst_util_get_timestamp() - start);
+
+    *out_size = layout->size;
+    return dst;
+}
+
+/*
+ * A JPEG that decodes to exactly the output size, natively or with DCT
+ * scaling (1/2, 1/4, ...), goes straight into fmt, skipping the RGBA
+ * intermediate and the conversion pass. NULL if that does not apply (other
+ * scale factors, PNG, or a layout the decoder cannot produce directly).
+ */
+static guint8* decode_jpeg_direct(GstStaticPngSrc* self, GBytes* source, ImageType type, const gchar* fmt,
+                                  const StaticImageFrameLayout* layout, gsize* out_size, gint* out_img_w,
+                                  gint* out_img_h)
+{
+    const gint width = layout->width;
+    const gint height = layout->height;
+    gint img_w = 0;
+    gint img_h = 0;
+    if (type != IMAGE_TYPE_JPEG || format_is_compressed(fmt) || !static_image_decode_jpeg_size(source, &img_w, &img_h))
+    {
+        return NULL;
+    }
+    /* libjpeg's own YCbCr is BT.601; other matrices go through RGBA */
+    if (static_image_convert_is_yuv(fmt) && self->matrix != STATIC_IMAGE_MATRIX_BT601)
+    {
+        return NULL;
+    }
+    gint scaled_w = 0;
+    gint scaled_h = 0;
+    static_image_decode_jpeg_scaled_size(img_w, img_h, width, height, &scaled_w, &scaled_h);
+    if (scaled_w != width || scaled_h != height)
+    {
+        return NULL;
+    }
+
+    guint8* data = NULL;
+    gint dec_w = 0;
+    gint dec_h = 0;
+    const GstClockTime start = gst_util_get_timestamp();
+    if (!static_image_decode_jpeg_to_format(source, fmt, self->range == STATIC_IMAGE_RANGE_FULL, layout, width,
+                                            height, &data, out_size, &dec_w, &dec_h))
+    {
+        return NULL;
+    }
+    static_image_stats_add_stage(&self->stats, STATIC_IMAGE_STAGE_DECODE, gst_util_get_timestamp() - start);
+
+    GST_DEBUG_OBJECT(self, "decoded %dx%d JPEG directly to %dx%d %s", img_w, img_h, dec_w, dec_h, fmt);
+    *out_img_w = img_w;
+    *out_img_h = img_h;
+    return data;
+}
+
+/*
+ * Compressed output of the source's own type at the image's own size is the
+ * encoded image itself: the frame is a ref on source, with no decode at all.
+ * source must not be a file mapping, which would fault under any consumer if
+ * the file were rewritten while the frame is in use (load_source_copy()).
+ * NULL if fmt is raw or the frame needs re-encoding.
+ */
+static GstMemory* passthrough_source(GstStaticPngSrc* self, GBytes* source, ImageType type, const gchar* fmt,
+                                     gint width, gint height, gint* out_img_w, gint* out_img_h)
+{
+    gint img_w = 0;
+    gint img_h = 0;
+    const gboolean sized = (type == IMAGE_TYPE_JPEG && g_strcmp0(fmt, "JPEG") == 0 &&
+                            static_image_decode_jpeg_size(source, &img_w, &img_h)) ||
+                           (type == IMAGE_TYPE_PNG && g_strcmp0(fmt, "PNG") == 0 &&
+                            static_image_decode_png_size(source, &img_w, &img_h));
+    if (!sized || img_w != width || img_h != height)
+    {
+        return NULL;
+    }
+    *out_img_w = img_w;
+    *out_img_h = img_h;
+
+    gsize size = 0;
+    gconstpointer data = g_bytes_get_data(source, &size);
+    return gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY, (gpointer)data, size, 0, size, g_bytes_ref(source),
+                                  (GDestroyNotify)g_bytes_unref);
+}
+
+/* low-memory: output rows of packed RGBA, converted into the frame a band at a time */
+#define STREAM_BAND_ROWS 16
+
+typedef struct
+{
+    GstStaticPngSrc* self;
+    const gchar* fmt;
+    const StaticImageFrameLayout* layout;
+    guint8* dst;
+    guint8* band; /* STREAM_BAND_ROWS rows; even, as 4:2:0 chroma needs row pairs */
+    gint band_rows;
+    gint first_row; /* of the band in the frame */
+} RowSink;
+
+static void row_sink_flush(RowSink* sink)
+{
+    const StaticImageFrameLayout* layout = sink->layout;
+    if (sink->band_rows == 0)
+    {
+        return;
+    }
+
+    if (static_image_convert_is_yuv(sink->fmt))
+    {
+        static_image_convert_rgba_to_yuv_rows(sink->band, layout->width * 4, sink->fmt, layout, sink->first_row,
+                                              sink->band_rows, sink->dst, sink->self->matrix,
+                                              sink->self->range == STATIC_IMAGE_RANGE_FULL);
+    }
+    else
+    {
+        guint8* rows = sink->dst + layout->offsets[0] + (gsize)sink->first_row * layout->strides[0];
+        for (gint i = 0; i < sink->band_rows; ++i)
+        {
+            memcpy(rows + (gsize)i * layout->strides[0], sink->band + (gsize)i * layout->width * 4,
+                   (gsize)layout->width * 4);
+        }
+        swizzle_from_rgba_inplace(rows, layout->strides[0], layout->width, sink->band_rows, sink->fmt, 1);
+    }
+    sink->first_row += sink->band_rows;
+    sink->band_rows = 0;
+}
+
+static void row_sink_push(const guint8* row, gpointer user_data)
+{
+    RowSink* sink = (RowSink*)user_data;
+    const gint width = sink->layout->width;
+
+    /* More rows than the header promised must not run past the frame */
+    if (sink->first_row + sink->band_rows >= sink->layout->height)
+    {
+        return;
+    }
+    memcpy(sink->band + (gsize)sink->band_rows * width * 4, row, (gsize)width * 4);
+    if (++sink->band_rows == STREAM_BAND_ROWS)
+    {
+        row_sink_flush(sink);
+    }
+}
+
+static void scale_decoded_row(const guint8* row, gpointer user_data)
+{
+    static_image_row_scaler_push((StaticImageRowScaler*)user_data, row);
+}
+
+/*
+ * low-memory: decodes source a row at a time through the row scaler into the
+ * converter, which writes fmt straight into the frame. Besides the frame only
+ * a few rows are held (plus libjpeg's own state), where the regular path
+ * keeps the decoded image, its scaled copy and the RGBA source for later
+ * conversions. Counted as one decode stage. NULL for compressed output or if
+ * the decode fails.
+ */
+static guint8* decode_streamed(GstStaticPngSrc* self, GBytes* source, ImageType type, const gchar* fmt,
+                               const StaticImageFrameLayout* layout, gsize* out_size, gint* out_img_w,
+                               gint* out_img_h)
+{
+    const gint width = layout->width;
+    const gint height = layout->height;
+    gint img_w = 0;
+    gint img_h = 0;
+    gint dec_w = 0;
+    gint dec_h = 0;
+    if (format_is_compressed(fmt))
+    {
+        return NULL;
+    }
+    if (type == IMAGE_TYPE_PNG && static_image_decode_png_size(source, &img_w, &img_h))
+    {
+        dec_w = img_w;
+        dec_h = img_h;
+    }
+    else if (type == IMAGE_TYPE_JPEG && static_image_decode_jpeg_size(source, &img_w, &img_h))
+    {
+        static_image_decode_jpeg_scaled_size(img_w, img_h, width, height, &dec_w, &dec_h);
+    }
+    if (dec_w <= 0 || dec_h <= 0)
+    {
+        return NULL;
+    }
+
+    /* Row padding is zeroed, as in convert_from_rgba() */
+    RowSink sink = {self, fmt, layout, (guint8*)g_try_malloc0(layout->size),
+                    (guint8*)g_try_malloc((gsize)width * 4 * STREAM_BAND_ROWS), 0, 0};
+    const gboolean resize = dec_w != width || dec_h != height;
+    StaticImageRowScaler* scaler =
+        resize ? static_image_row_scaler_new(dec_w, dec_h, width, height, self->scale_method, row_sink_push, &sink)
+               : NULL;
+    StaticImageDecodeRowFunc func = resize ? scale_decoded_row : row_sink_push;
+    gpointer func_data = resize ? (gpointer)scaler : (gpointer)&sink;
+
+    const GstClockTime start = gst_util_get_timestamp();
+    gboolean ok = sink.dst != NULL && sink.band != NULL && (scaler != NULL || !resize);
+    if (ok)
+    {
+        ok = type == IMAGE_TYPE_PNG ? static_image_decode_png_rows(source, func, func_data)
+                                    : static_image_decode_jpeg_rows(source, width, height, func, func_data);
+    }
+    if (ok)
+    {
+        row_sink_flush(&sink);
+        ok = sink.first_row == height;
+    }
+    static_image_row_scaler_free(scaler);
+    g_free(sink.band);
+    if (!ok)
+    {
+        g_free(sink.dst);
+        return NULL;
+    }
+    static_image_stats_add_stage(&self->stats, STATIC_IMAGE_STAGE_DECODE, gst_util_get_timestamp() - start);
+
+    GST_DEBUG_OBJECT(self, "streamed %dx%d %s into %dx%d %s", img_w, img_h,
+                     type == IMAGE_TYPE_PNG ? "PNG" : "JPEG", width, height, fmt);
+    *out_size = layout->size;
+    *out_img_w = img_w;
+    *out_img_h = img_h;
+    return sink.dst;
+}
+
+/* The image decoded at its own size, whatever output size it is then scaled to */
+typedef struct
+{
+    GstStaticPngSrc* self;
+    GBytes* source;
+    ImageType type;
+} DecodeBuild;
+
+static GstMemory* build_decoded_memory(gpointer user_data)
+{
+    DecodeBuild* build = (DecodeBuild*)user_data;
+
+    guint8* decoded = NULL;
+    gint dec_w = 0;
+    gint dec_h = 0;
+    const GstClockTime start = gst_util_get_timestamp();
+    const gboolean ok = build->type == IMAGE_TYPE_PNG
+                            ? static_image_decode_png(build->source, &decoded, &dec_w, &dec_h)
+                            : static_image_decode_jpeg(build->source, 0, 0, &decoded, &dec_w, &dec_h);
+    if (!ok)
+    {
+        return NULL;
+    }
+    static_image_stats_add_stage(&build->self->stats, STATIC_IMAGE_STAGE_DECODE, gst_util_get_timestamp() - start);
+
+    gsize size = (gsize)dec_w * (gsize)dec_h * 4;
+    return gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY, decoded, size, 0, size, decoded, (GDestroyNotify)g_free);
+}
+
+/*
+ * decode_scaled_rgba() with the decode itself taken from the shared cache,
+ * keyed by the image's own size, so instances started together at other sizes
+ * of the same image (an ABR ladder of 1080p/720p/360p sources) decode it once
+ * and each only scales. A JPEG is decoded whole here, the only size every rung
+ * can scale from. The entry is released as soon as this instance has scaled,
+ * so no full-size decode outlives the build. NULL without *decode_failed if
+ * sharing does not pay (no scaling needed, or low-memory) or is not possible;
+ * the caller then decodes on its own.
+ */
+static guint8* decode_scaled_rgba_shared(GstStaticPngSrc* self, GBytes* source, gboolean* decode_failed)
+{
+    const gint width = self->actual_width;
+    const gint height = self->actual_height;
+    DecodeBuild build = {self, source, self->image_type};
+
+    gint img_w = 0;
+    gint img_h = 0;
+    gint own_w = 0; /* what decoding alone gives: a JPEG is DCT-scaled towards the output */
+    gint own_h = 0;
+    if (self->image_type == IMAGE_TYPE_PNG && static_image_decode_png_size(source, &img_w, &img_h))
+    {
+        own_w = img_w;
+        own_h = img_h;
+    }
+    else if (self->image_type == IMAGE_TYPE_JPEG && static_image_decode_jpeg_size(source, &img_w, &img_h))
+    {
+        static_image_decode_jpeg_scaled_size(img_w, img_h, width, height, &own_w, &own_h);
+    }
+    if (self->low_memory || img_w <= 0 || img_h <= 0 || (own_w == width && own_h == height))
+    {
+        return NULL;
+    }
+
+    gchar* key = self->data != NULL ? static_image_cache_make_data_key(self->data, img_w, img_h, "RGBA", "decoded")
+                                    : static_image_cache_make_key(source_path(self), img_w, img_h, "RGBA", "decoded");
+    if (key == NULL)
+    {
+        return NULL;
+    }
+
+    GstMemory* decoded = static_image_cache_acquire(key, build_decoded_memory, &build);
+    if (decoded == NULL)
+    {
+        g_free(key);
+        *decode_failed = TRUE;
+        return NULL;
+    }
+
+    GstMapInfo map;
+    guint8* pixels = NULL;
+    if (gst_memory_map(decoded, &map, GST_MAP_READ))
+    {
+        pixels = scale_rgba(self, map.data, img_w, img_h, width, height);
+        gst_memory_unmap(decoded, &map);
+    }
+    gst_memory_unref(decoded);
+    static_image_cache_release(key);
+    g_free(key);
+    GST_DEBUG_OBJECT(self, "scaled shared %dx%d decode to %dx%d", img_w, img_h, width, height);
+    return pixels;
+}
+
+/* Decodes and scales the image to the output size; runs once per cache entry */
+static GstMemory* build_rgba_memory(gpointer user_data)
+{
+    FrameBuild* build = (FrameBuild*)user_data;
+    GstStaticPngSrc* self = build->self;
+
+    GBytes* source = load_source(self);
+    if (source == NULL)
+    {
+        build->decode_failed = TRUE;
+        return NULL;
+    }
+
+    gint img_w = 0;
+    gint img_h = 0;
+    guint8* pixels = self->shared_cache ? decode_scaled_rgba_shared(self, source, &build->decode_failed) : NULL;
+    if (pixels == NULL && !build->decode_failed)
+    {
+        pixels = decode_scaled_rgba(self, source, self->image_type, self->actual_width, self->actual_height, &img_w,
+                                    &img_h, &build->decode_failed);
+    }
+    g_bytes_unref(source);
+    if (pixels == NULL)
+    {
+        return NULL;
+    }
+
+    gsize size = (gsize)self->actual_width * (gsize)self->actual_height * 4;
+    return gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY, pixels, size, 0, size, pixels, (GDestroyNotify)g_free);
+}
+
+/*
+ * Builds build->format (anything but packed RGBA, unless low-memory) from the
+ * RGBA source, or straight from a JPEG or by streaming if there is none yet.
+ * Compressed output passes the file through when it can.
+ */
+static GstMemory* build_frame_memory(gpointer user_data)
+{
+    FrameBuild* build = (FrameBuild*)user_data;
+    GstStaticPngSrc* self = build->self;
+    const gchar* fmt = build->format;
+
+    /* Converting an already decoded RGBA image is cheaper than decoding the JPEG again */
+    gsize size = 0;
+    gint img_w = 0;
+    gint img_h = 0;
+    guint8* data = NULL;
+    StaticImageFrameLayout layout;
+    if (!output_layout(self, fmt, self->actual_width, self->actual_height, &layout))
+    {
+        return NULL;
+    }
+    if (format_is_compressed(fmt))
+    {
+        GBytes* source = load_source_copy(self);
+        GstMemory* memory = source != NULL ? passthrough_source(self, source, self->image_type, fmt,
+                                                                self->actual_width, self->actual_height, &img_w,
+                                                                &img_h)
+                                           : NULL;
+        if (source != NULL)
+        {
+            g_bytes_unref(source);
+        }
+        if (memory != NULL)
+        {
+            GST_DEBUG_OBJECT(self, "passing %s through as %s (%" G_GSIZE_FORMAT " bytes)", source_name(self), fmt,
+                             gst_memory_get_sizes(memory, NULL, NULL));
+            return memory;
+        }
+    }
+    if (self->rgba_data == NULL && (self->image_type == IMAGE_TYPE_JPEG || self->low_memory))
+    {
+        GBytes* source = load_source(self);
+        if (source != NULL)
+        {
+            data = decode_jpeg_direct(self, source, self->image_type, fmt, &layout, &size, &img_w, &img_h);
+            if (data == NULL && self->low_memory)
+            {
+                data = decode_streamed(self, source, self->image_type, fmt, &layout, &size, &img_w, &img_h);
+            }
+            g_bytes_unref(source);
+        }
+    }
+    if (data == NULL)
+    {
+        if (!ensure_rgba(self, FALSE))
+        {
+            return NULL;
+        }
+        data = convert_from_rgba(self, self->rgba_data, fmt, &layout, &size);
+    }
+    if (data == NULL)
+    {
+        return NULL;
+    }
+
+    GST_DEBUG_OBJECT(self, "built %s frame (%" G_GSIZE_FORMAT " bytes)", fmt, size);
+    return gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY, data, size, 0, size, data, (GDestroyNotify)g_free);
+}
+
+/*
+ * Decodes, scales and converts (or passes through) source into an exported
+ * output frame outside the caches. For the watch and prefetch threads, so it touches no streaming
+ * state.
+ */
+static GstMemory* build_standalone_frame(GstStaticPngSrc* self, GBytes* source, ImageType type, gint width,
+                                         gint height, const gchar* format, gint* out_img_w, gint* out_img_h)
+{
+    StaticImageFrameLayout layout;
+    if (!output_layout(self, format, width, height, &layout))
+    {
+        return NULL;
+    }
+
+    GstMemory* passthrough = passthrough_source(self, source, type, format, width, height, out_img_w, out_img_h);
+    if (passthrough != NULL)
+    {
+        return export_output_frame(self, passthrough, format);
+    }
+
+    gsize size = 0;
+    guint8* data = decode_jpeg_direct(self, source, type, format, &layout, &size, out_img_w, out_img_h);
+    if (data == NULL && self->low_memory)
+    {
+        data = decode_streamed(self, source, type, format, &layout, &size, out_img_w, out_img_h);
+    }
+    if (data == NULL)
+    {
+        gboolean decode_failed = FALSE;
+        data = decode_scaled_rgba(self, source, type, width, height, out_img_w, out_img_h, &decode_failed);
+        size = (gsize)width * (gsize)height * 4;
+        if (data != NULL && !layout_is_packed_rgba(format, &layout))
+        {
+            guint8* rgba = data;
+            data = convert_from_rgba(self, rgba, format, &layout, &size);
+            g_free(rgba);
+        }
+    }
+    if (data == NULL)
+    {
+        return NULL;
+    }
+
+    GstMemory* memory =
+        gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY, data, size, 0, size, data, (GDestroyNotify)g_free);
+    return export_output_frame(self, memory, format);
+}
+
+/* Watch thread: rebuilds the current output frame from the changed file without touching streaming state */
+static void reload_image(gpointer user_data)
+{
+    GstStaticPngSrc* self = (GstStaticPngSrc*)user_data;
+
+    g_mutex_lock(&self->reload_lock);
+    const gint width = self->reload_width;
+    const gint height = self->reload_height;
+    gchar format[sizeof(self->reload_format)];
+    g_strlcpy(format, self->reload_format, sizeof(format));
+    g_mutex_unlock(&self->reload_lock);
+
+    /* Not negotiated yet: set_caps() reads the new file anyway */
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    gint img_w = 0;
+    gint img_h = 0;
+    GBytes* source = load_source(self);
+    GstMemory* memory = NULL;
+    FrameRing* animation = NULL;
+    if (source != NULL)
+    {
+        if (self->image_type == IMAGE_TYPE_PNG && static_image_apng_is_animated(source) &&
+            static_image_decode_png_size(source, &img_w, &img_h))
+        {
+            animation = build_frame_ring(self, source, width, height, format);
+        }
+        if (animation == NULL)
+        {
+            memory =
+                build_standalone_frame(self, source, self->image_type, width, height, format, &img_w, &img_h);
+        }
+        g_bytes_unref(source);
+    }
+    if (memory == NULL && animation == NULL)
+    {
+        /* Possibly caught mid-write; the next change event retries */
+        GST_WARNING_OBJECT(self, "reloading '%s' failed, keeping the current frame", self->location);
+        return;
+    }
+
+    g_mutex_lock(&self->reload_lock);
+    if (self->reloaded.memory != NULL)
+    {
+        gst_memory_unref(self->reloaded.memory);
+    }
+    frame_ring_free(self->reloaded.animation);
+    self->reloaded.memory = memory;
+    self->reloaded.animation = animation;
+    self->reloaded.width = width;
+    self->reloaded.height = height;
+    g_strlcpy(self->reloaded.format, format, sizeof(self->reloaded.format));
+    self->reloaded.image_width = img_w;
+    self->reloaded.image_height = img_h;
+    g_atomic_int_set(&self->reload_ready, TRUE);
+    g_mutex_unlock(&self->reload_lock);
+
+    GST_INFO_OBJECT(self, "reloaded '%s' (%dx%d image) as %dx%d %s", self->location, img_w, img_h, width, height,
+                    format);
+}
+
+/* Streaming thread: drops every frame built from the old file and outputs the reloaded one from the next buffer */
+static void swap_in_reloaded_frame(GstStaticPngSrc* self)
+{
+    g_mutex_lock(&self->reload_lock);
+    ReloadedFrame reloaded = self->reloaded;
+    memset(&self->reloaded, 0, sizeof(self->reloaded));
+    g_atomic_int_set(&self->reload_ready, FALSE);
+    g_mutex_unlock(&self->reload_lock);
+
+    if (reloaded.memory == NULL && reloaded.animation == NULL)
+    {
+        return;
     }
 
-    guint8* final_pixels = NULL;
-    if (out_w != img_w || out_h != img_h)
+    const gint slot = output_format_slot(reloaded.format);
+    if (slot < 0 || reloaded.width != self->actual_width || reloaded.height != self->actual_height ||
+        g_strcmp0(reloaded.format, self->selected_format) != 0)
     {
-        final_pixels = scale_rgba_nearest(decoded, img_w, img_h, out_w, out_h);
-        g_free(decoded);
-        if (final_pixels == NULL)
+        /* Renegotiated while the reload ran; build again for the new output */
+        if (reloaded.memory != NULL)
         {
-            GST_ELEMENT_ERROR(self, STREAM, FORMAT, ("Failed to scale image"), (NULL));
-            return FALSE;
+            gst_memory_unref(reloaded.memory);
         }
+        frame_ring_free(reloaded.animation);
+        static_image_watch_trigger(self->watcher);
+        return;
     }
-    else
+
+    /* Other formats (and the RGBA source) are rebuilt from the new file if caps change */
+    release_frames(self);
+    self->animated = reloaded.animation != NULL;
+    if (self->animated)
     {
-        final_pixels = decoded;
+        self->animation = reloaded.animation;
+        self->animation_index = frame_ring_index_at(self->animation, self->frame_index * self->frame_duration);
+        self->shared_mem = gst_memory_ref(self->animation->frames[self->animation_index]);
     }
-
-    self->actual_width = out_w;
-    self->actual_height = out_h;
-    self->rgba_stride = self->actual_width * 4;
-    self->rgba_size = (gsize)self->rgba_stride * (gsize)self->actual_height;
-    self->rgba_data = final_pixels;
-
-    /* Proactively set default caps (RGBA) to ensure early negotiation on older stacks */
+    else
     {
-        GstCaps* default_caps = gst_caps_new_simple("video/x-raw", "format", G_TYPE_STRING, "RGBA", "width", G_TYPE_INT,
-                                                    self->actual_width, "height", G_TYPE_INT, self->actual_height,
-                                                    "framerate", GST_TYPE_FRACTION, self->fps_n, self->fps_d, NULL);
-        if (default_caps != NULL)
-        {
-            if (!gst_base_src_set_caps(GST_BASE_SRC(self), default_caps))
-            {
-                gst_caps_unref(default_caps);
-                GST_ELEMENT_ERROR(self, CORE, NEGOTIATION, ("Failed to set initial caps"), (NULL));
-                return FALSE;
-            }
-            gst_caps_unref(default_caps);
-        }
+        self->format_frames[slot].memory = gst_memory_ref(reloaded.memory);
+        self->shared_mem = reloaded.memory;
     }
+    self->image_width = reloaded.image_width;
+    self->image_height = reloaded.image_height;
+    show_shared_frame(self);
 
-    /* Defer building output format until first buffer (after negotiation) */
-    self->frame_data = NULL;
-    self->frame_size = 0;
-    self->frame_stride = 0;
-    self->num_planes = 1;
-    self->shared_mem = NULL;
-
-    self->frame_count = 0;
-    return TRUE;
+    GST_INFO_OBJECT(self, "swapped in reloaded %s frame", self->selected_format);
 }
 
-static gboolean gst_static_png_src_stop(GstBaseSrc* src)
+/* Frames a playlist item stays on screen for; at least one */
+static guint64 slide_frames(GstStaticPngSrc* self, guint index)
 {
-    GstStaticPngSrc* self = GST_STATICPNG_SRC(src);
+    const StaticImagePlaylistItem* item =
+        (const StaticImagePlaylistItem*)g_ptr_array_index(self->playlist_items, index);
+    const guint64 frames = gst_util_uint64_scale_round(item->duration_ms, (guint64)self->fps_n,
+                                                       (guint64)self->fps_d * 1000);
+    return MAX(frames, (guint64)1);
+}
 
-    if (self->shared_mem != NULL)
+/* Prefetch thread: builds playlist item index for the current output size and format */
+static GstMemory* build_playlist_frame(guint index, gpointer user_data)
+{
+    GstStaticPngSrc* self = (GstStaticPngSrc*)user_data;
+
+    g_mutex_lock(&self->reload_lock);
+    const gint width = self->reload_width;
+    const gint height = self->reload_height;
+    gchar format[sizeof(self->reload_format)];
+    g_strlcpy(format, self->reload_format, sizeof(format));
+    g_mutex_unlock(&self->reload_lock);
+
+    const StaticImagePlaylistItem* item =
+        (const StaticImagePlaylistItem*)g_ptr_array_index(self->playlist_items, index);
+    /* A passthrough frame keeps the encoded bytes; a decode only reads them */
+    GBytes* source = format_is_compressed(format) ? static_image_decode_read_file(item->path)
+                                                  : static_image_decode_map_file(item->path);
+    if (source == NULL || width <= 0 || height <= 0)
     {
-        gst_memory_unref(self->shared_mem);
-        self->shared_mem = NULL;
+        if (source != NULL)
+        {
+            g_bytes_unref(source);
+        }
+        return NULL;
     }
 
-    /* frame_data will be freed by shared_mem notify; ensure pointer not reused */
-    self->frame_data = NULL;
-    self->frame_size = 0;
-    self->frame_stride = 0;
-    self->actual_width = 0;
-    self->actual_height = 0;
-    if (self->rgba_data != NULL)
+    gint img_w = 0;
+    gint img_h = 0;
+    GstMemory* memory = build_standalone_frame(self, source, image_type_from_location(item->path), width, height,
+                                               format, &img_w, &img_h);
+    g_bytes_unref(source);
+    if (memory != NULL)
     {
-        g_free(self->rgba_data);
-        self->rgba_data = NULL;
-        self->rgba_size = 0;
-        self->rgba_stride = 0;
+        GST_DEBUG_OBJECT(self, "prefetched '%s' (%dx%d image) as %dx%d %s", item->path, img_w, img_h, width, height,
+                         format);
     }
-    self->frame_count = 0;
-
-    return TRUE;
+    return memory;
 }
 
-static GstFlowReturn gst_static_png_src_create(GstPushSrc* src, GstBuffer** buf)
+/*
+ * Streaming thread, at a slide boundary: switches to the next item if the
+ * prefetch thread has it ready. Otherwise the current frame simply repeats
+ * and the switch is retried on the next frame, so output never waits.
+ */
+static void advance_playlist(GstStaticPngSrc* self)
 {
-    GstStaticPngSrc* self = GST_STATICPNG_SRC(src);
-
-    /* Build output memory on first call after negotiation */
-    if (self->shared_mem == NULL)
+    const guint n_items = self->playlist_items->len;
+    if (n_items < 2 || self->prefetcher == NULL)
     {
-        if (self->rgba_data == NULL)
-        {
-            GST_ELEMENT_ERROR(self, RESOURCE, FAILED, ("No image loaded"), (NULL));
-            return GST_FLOW_ERROR;
-        }
+        self->slide_end_frame = G_MAXUINT64;
+        return;
+    }
 
-        /* Ensure negotiation happened; get the chosen caps */
-        GstPad* srcpad = gst_element_get_static_pad(GST_ELEMENT(self), "src");
-        GstCaps* current = NULL;
-        if (srcpad != NULL)
+    const guint next = self->playlist_next;
+    gboolean failed = FALSE;
+    GstMemory* memory = static_image_prefetch_take(self->prefetcher, next, &failed);
+    if (memory == NULL)
+    {
+        if (!failed)
         {
-            current = gst_pad_get_current_caps(srcpad);
-            gst_object_unref(srcpad);
+            GST_DEBUG_OBJECT(self, "playlist item %u not ready, repeating the current one", next);
+            return;
         }
-        if (current == NULL)
-        {
-            /* Create default RGBA caps if none negotiated yet */
-            GstCaps* default_caps = gst_caps_new_simple(
-                "video/x-raw", "format", G_TYPE_STRING, "RGBA", "width", G_TYPE_INT, self->actual_width, "height",
-                G_TYPE_INT, self->actual_height, "framerate", GST_TYPE_FRACTION, self->fps_n, self->fps_d, NULL);
-            if (default_caps == NULL)
-            {
-                GST_ELEMENT_ERROR(self, CORE, NEGOTIATION, ("Failed to create default caps"), (NULL));
-                return GST_FLOW_ERROR;
-            }
 
-            if (!gst_base_src_set_caps(GST_BASE_SRC(self), default_caps))
-            {
-                gst_caps_unref(default_caps);
-                GST_ELEMENT_ERROR(self, CORE, NEGOTIATION, ("Failed to set default caps"), (NULL));
-                return GST_FLOW_ERROR;
-            }
-            gst_caps_unref(default_caps);
-
-            srcpad = gst_element_get_static_pad(GST_ELEMENT(self), "src");
-            if (srcpad != NULL)
-            {
-                current = gst_pad_get_current_caps(srcpad);
-                gst_object_unref(srcpad);
-            }
-        }
-        const gchar* fmt = "RGBA";
-        if (current != NULL && gst_caps_get_size(current) > 0)
+        const StaticImagePlaylistItem* item =
+            (const StaticImagePlaylistItem*)g_ptr_array_index(self->playlist_items, next);
+        GST_WARNING_OBJECT(self, "skipping '%s', it cannot be decoded", item->path);
+        self->playlist_next = (next + 1) % n_items;
+        if (self->playlist_next == self->playlist_index)
         {
-            const GstStructure* s = gst_caps_get_structure(current, 0);
-            const gchar* f = gst_structure_get_string(s, "format");
-            if (f != NULL)
-            {
-                fmt = f;
-            }
-            gst_caps_unref(current);
+            /* Nothing else in the playlist decodes */
+            self->slide_end_frame = G_MAXUINT64;
         }
-        g_strlcpy(self->selected_format, fmt, sizeof(self->selected_format));
+        return;
+    }
 
-        if (g_strcmp0(fmt, "NV12") == 0)
-        {
-            self->frame_data = convert_rgba_to_nv12(self->rgba_data, self->actual_width, self->actual_height);
-            if (self->frame_data == NULL)
-            {
-                GST_ELEMENT_ERROR(self, STREAM, FORMAT, ("RGBA->NV12 conversion failed"), (NULL));
-                return GST_FLOW_ERROR;
-            }
-            self->frame_stride = self->actual_width;
-            self->frame_size = (gsize)self->actual_width * (gsize)self->actual_height * 3 / 2;
-            self->num_planes = 2;
-        }
-        else if (g_strcmp0(fmt, "I420") == 0)
-        {
-            self->frame_data = convert_rgba_to_i420(self->rgba_data, self->actual_width, self->actual_height);
-            if (self->frame_data == NULL)
-            {
-                GST_ELEMENT_ERROR(self, STREAM, FORMAT, ("RGBA->I420 conversion failed"), (NULL));
-                return GST_FLOW_ERROR;
-            }
-            self->frame_stride = self->actual_width;
-            self->frame_size = (gsize)self->actual_width * (gsize)self->actual_height * 3 / 2;
-            self->num_planes = 3;
-        }
-        else
-        {
-            self->frame_size = self->rgba_size;
-            self->frame_stride = self->rgba_stride;
-            self->frame_data = (guint8*)memdup_fallback(self->rgba_data, self->rgba_size);
-            if (self->frame_data == NULL)
-            {
-                GST_ELEMENT_ERROR(self, RESOURCE, NO_SPACE_LEFT, ("Failed to allocate output frame"), (NULL));
-                return GST_FLOW_ERROR;
-            }
-            if (g_strcmp0(fmt, "RGBA") != 0)
-            {
-                swizzle_from_rgba_inplace(self->frame_data, self->actual_width, self->actual_height, fmt);
-            }
-            self->num_planes = 1;
-        }
+    /* Other formats (and the RGBA source) are rebuilt from the new item if caps change */
+    const gint slot = output_format_slot(self->selected_format);
+    release_frames(self);
+    self->format_frames[slot].memory = gst_memory_ref(memory);
+    self->shared_mem = memory;
+    show_shared_frame(self);
+
+    self->playlist_index = next;
+    self->playlist_next = (next + 1) % n_items;
+    self->image_type = image_type_from_location(source_path(self));
+    /* A late switch still gets the full duration */
+    self->slide_end_frame = MAX(self->slide_end_frame, self->frame_index) + slide_frames(self, next);
+    GST_INFO_OBJECT(self, "showing playlist item %u '%s'", next, source_path(self));
+}
 
-        self->shared_mem = gst_memory_new_wrapped((GstMemoryFlags)0, self->frame_data, self->frame_size, 0,
-                                                  self->frame_size, self->frame_data, (GDestroyNotify)g_free);
-        if (self->shared_mem == NULL)
-        {
-            g_free(self->frame_data);
-            self->frame_data = NULL;
-            GST_ELEMENT_ERROR(self, RESOURCE, NO_SPACE_LEFT, ("Failed to wrap image memory"), (NULL));
-            return GST_FLOW_ERROR;
-        }
+static void stop_playlist(GstStaticPngSrc* self)
+{
+    static_image_prefetch_free(self->prefetcher);
+    self->prefetcher = NULL;
+    if (self->playlist_items != NULL)
+    {
+        g_ptr_array_unref(self->playlist_items);
+        self->playlist_items = NULL;
     }
+}
 
-    GstBuffer* buffer = gst_buffer_new();
-    if (buffer == NULL)
+/* An APNG being turned into a FrameRing one composited canvas at a time */
+typedef struct
+{
+    GstStaticPngSrc* self;
+    const gchar* format;
+    const StaticImageFrameLayout* layout;
+    GPtrArray* frames;  /* GstMemory, output frames so far */
+    GArray* ends;       /* GstClockTime */
+    GstClockTime end;   /* animation time at the end of the last frame */
+    GstClockTime spent; /* in add_ring_frame(), taken out of the decode stage */
+} RingBuild;
+
+/* Scales and converts a canvas into the next ring frame as soon as it is composited, so canvases never pile up */
+static gboolean add_ring_frame(const guint8* canvas, gint canvas_w, gint canvas_h, guint delay_num, guint delay_den,
+                               gpointer user_data)
+{
+    RingBuild* build = (RingBuild*)user_data;
+    GstStaticPngSrc* self = build->self;
+    const gint width = build->layout->width;
+    const gint height = build->layout->height;
+    const GstClockTime start = gst_util_get_timestamp();
+
+    guint8* scaled = NULL;
+    const guint8* rgba = canvas;
+    if (canvas_w != width || canvas_h != height)
     {
-        return GST_FLOW_ERROR;
+        scaled = scale_rgba(self, canvas, canvas_w, canvas_h, width, height);
+        rgba = scaled;
     }
 
-    gst_buffer_append_memory(buffer, gst_memory_ref(self->shared_mem));
-
-    /* Attach precise video meta (format, stride, offsets) so downstream interprets correctly */
-    GstVideoFormat vfmt = gst_video_format_from_string(self->selected_format);
-    if (vfmt == GST_VIDEO_FORMAT_UNKNOWN)
+    /* The canvas is redrawn for the next frame, so even packed RGBA output gets its own copy */
+    gsize size = (gsize)width * (gsize)height * 4;
+    guint8* data = NULL;
+    if (rgba == NULL)
     {
-        vfmt = GST_VIDEO_FORMAT_RGBA;
+        data = NULL;
     }
-    gsize offsets[GST_VIDEO_MAX_PLANES] = {0, 0, 0, 0};
-    gint strides[GST_VIDEO_MAX_PLANES] = {0, 0, 0, 0};
-    if (vfmt == GST_VIDEO_FORMAT_NV12)
+    else if (!layout_is_packed_rgba(build->format, build->layout))
     {
-        offsets[0] = 0;
-        offsets[1] = (gsize)self->actual_width * (gsize)self->actual_height;
-        strides[0] = self->actual_width;
-        strides[1] = self->actual_width;
-        gst_buffer_add_video_meta_full(buffer, (GstVideoFrameFlags)0, vfmt, (gint)self->actual_width,
-                                       (gint)self->actual_height, 2, offsets, strides);
+        data = convert_from_rgba(self, rgba, build->format, build->layout, &size);
     }
-    else if (vfmt == GST_VIDEO_FORMAT_I420)
+    else if (scaled != NULL)
     {
-        gsize y_size = (gsize)self->actual_width * (gsize)self->actual_height;
-        gsize uv_size = ((gsize)self->actual_width / 2) * ((gsize)self->actual_height / 2);
-        offsets[0] = 0;
-        offsets[1] = y_size;
-        offsets[2] = y_size + uv_size;
-        strides[0] = self->actual_width;
-        strides[1] = self->actual_width / 2;
-        strides[2] = self->actual_width / 2;
-        gst_buffer_add_video_meta_full(buffer, (GstVideoFrameFlags)0, vfmt, (gint)self->actual_width,
-                                       (gint)self->actual_height, 3, offsets, strides);
+        data = scaled;
+        scaled = NULL;
     }
     else
     {
-        strides[0] = self->frame_stride;
-        gst_buffer_add_video_meta_full(buffer, (GstVideoFrameFlags)0, vfmt, (gint)self->actual_width,
-                                       (gint)self->actual_height, 1, offsets, strides);
+        data = (guint8*)g_malloc(size);
+        memcpy(data, canvas, size);
     }
-
-    GstClockTime pts = self->frame_count * self->frame_duration;
-    GST_BUFFER_PTS(buffer) = pts;
-    GST_BUFFER_DTS(buffer) = GST_CLOCK_TIME_NONE;
-    GST_BUFFER_DURATION(buffer) = self->frame_duration;
-
-    self->frame_count++;
-
-    /* Check if we've reached the num-buffers limit */
-    if (self->num_buffers > 0 && self->frame_count >= self->num_buffers)
+    g_free(scaled);
+    if (data == NULL)
     {
-        *buf = buffer;
-        return GST_FLOW_EOS;
+        return FALSE;
     }
 
-    *buf = buffer;
-
-    return GST_FLOW_OK;
+    GstMemory* memory =
+        gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY, data, size, 0, size, data, (GDestroyNotify)g_free);
+    g_ptr_array_add(build->frames, export_output_frame(self, memory, build->format));
+    build->end += gst_util_uint64_scale(GST_SECOND, delay_num, delay_den);
+    g_array_append_val(build->ends, build->end);
+    build->spent += gst_util_get_timestamp() - start;
+    return TRUE;
 }
 
-/* Helpers */
-
-static gboolean decode_png_to_rgba(const gchar* path, guint8** out_pixels, gint* out_w, gint* out_h)
+/*
+ * Decodes the APNG and converts each composited frame to the output size and
+ * format as it comes, so playback is only a matter of switching refs. Touches
+ * no streaming state, for use from the watch thread too. NULL if the data
+ * holds no usable animation.
+ */
+static FrameRing* build_frame_ring(GstStaticPngSrc* self, GBytes* source, gint width, gint height,
+                                   const gchar* format)
 {
-    *out_pixels = NULL;
-    *out_w = 0;
-    *out_h = 0;
-
-    FILE* fp = fopen(path, "rb");
-    if (!fp)
-    {
-        return FALSE;
-    }
-
-    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    if (!png_ptr)
-    {
-        fclose(fp);
-        return FALSE;
-    }
-
-    png_infop info_ptr = png_create_info_struct(png_ptr);
-    if (!info_ptr)
+    StaticImageFrameLayout layout;
+    if (!output_layout(self, format, width, height, &layout))
     {
-        png_destroy_read_struct(&png_ptr, NULL, NULL);
-        fclose(fp);
-        return FALSE;
+        return NULL;
     }
 
-    if (setjmp(png_jmpbuf(png_ptr)))
+    RingBuild build;
+    build.self = self;
+    build.format = format;
+    build.layout = &layout;
+    build.frames = g_ptr_array_new_with_free_func((GDestroyNotify)gst_memory_unref);
+    build.ends = g_array_new(FALSE, FALSE, sizeof(GstClockTime));
+    build.end = 0;
+    build.spent = 0;
+
+    guint plays = 0;
+    const GstClockTime start = gst_util_get_timestamp();
+    if (!static_image_apng_decode(source, add_ring_frame, &build, &plays))
     {
-        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-        fclose(fp);
-        return FALSE;
+        g_ptr_array_unref(build.frames);
+        g_array_unref(build.ends);
+        return NULL;
     }
+    static_image_stats_add_stage(&self->stats, STATIC_IMAGE_STAGE_DECODE,
+                                 gst_util_get_timestamp() - start - build.spent);
 
-    png_init_io(png_ptr, fp);
-    png_read_info(png_ptr, info_ptr);
-
-    png_uint_32 width = png_get_image_width(png_ptr, info_ptr);
-    png_uint_32 height = png_get_image_height(png_ptr, info_ptr);
-    int bit_depth = png_get_bit_depth(png_ptr, info_ptr);
-    int color_type = png_get_color_type(png_ptr, info_ptr);
+    FrameRing* ring = g_new0(FrameRing, 1);
+    ring->n_frames = build.frames->len;
+    ring->frames = (GstMemory**)g_ptr_array_free(build.frames, FALSE);
+    ring->ends = (GstClockTime*)g_array_free(build.ends, FALSE);
+    ring->plays = plays;
 
-    if (bit_depth == 16)
+    /* Zero delays throughout: advance one frame per output frame */
+    if (build.end == 0)
     {
-        png_set_strip_16(png_ptr);
+        for (guint i = 0; i < ring->n_frames; ++i)
+        {
+            ring->ends[i] = (i + 1) * self->frame_duration;
+        }
     }
+    return ring;
+}
 
-    if (color_type == PNG_COLOR_TYPE_PALETTE)
+static void frame_ring_free(FrameRing* ring)
+{
+    if (ring == NULL)
     {
-        png_set_palette_to_rgb(png_ptr);
+        return;
     }
-
-    if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
+    for (guint i = 0; i < ring->n_frames; ++i)
     {
-        png_set_expand_gray_1_2_4_to_8(png_ptr);
+        gst_memory_unref(ring->frames[i]);
     }
+    g_free(ring->frames);
+    g_free(ring->ends);
+    g_free(ring);
+}
 
-    if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
+/* Frame on screen at stream time; the last frame stays up once all plays are done */
+static guint frame_ring_index_at(const FrameRing* ring, GstClockTime time)
+{
+    const GstClockTime loop = ring->ends[ring->n_frames - 1];
+    if (ring->plays > 0 && time / loop >= ring->plays)
     {
-        png_set_tRNS_to_alpha(png_ptr);
+        return ring->n_frames - 1;
     }
 
-    if (color_type == PNG_COLOR_TYPE_RGB || color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_PALETTE)
+    /* First frame ending after the position; zero-delay frames are never shown */
+    const GstClockTime position = time % loop;
+    guint low = 0;
+    guint high = ring->n_frames - 1;
+    while (low < high)
     {
-        png_set_filler(png_ptr, 0xFF, PNG_FILLER_AFTER);
+        const guint mid = low + (high - low) / 2;
+        if (ring->ends[mid] > position)
+        {
+            high = mid;
+        }
+        else
+        {
+            low = mid + 1;
+        }
     }
+    return low;
+}
 
-    if (color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+/* Streaming thread: points the pool at the animation frame for the next buffer's timestamp */
+static void advance_animation(GstStaticPngSrc* self)
+{
+    const guint index = frame_ring_index_at(self->animation, self->frame_index * self->frame_duration);
+    if (index == self->animation_index)
     {
-        png_set_gray_to_rgb(png_ptr);
+        return;
     }
 
-    png_read_update_info(png_ptr, info_ptr);
+    self->animation_index = index;
+    gst_memory_unref(self->shared_mem);
+    self->shared_mem = gst_memory_ref(self->animation->frames[index]);
+    show_shared_frame(self);
+}
 
-    png_size_t rowbytes = png_get_rowbytes(png_ptr, info_ptr);
+/* Hands out shared_mem from the pool; an active overlay is redrawn over the new frame by the next create() */
+static void show_shared_frame(GstStaticPngSrc* self)
+{
+    static_image_buffer_pool_set_frame(self->pool, self->shared_mem, output_video_format(self->selected_format),
+                                       &self->frame_layout);
+    self->overlay_shown = NULL;
+    self->overlay_generation++;
+}
 
-    guint8* pixels = (guint8*)g_malloc((gsize)rowbytes * height);
-    if (!pixels)
-    {
-        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-        fclose(fp);
-        return FALSE;
-    }
+static void overlay_frame_free(gpointer data)
+{
+    OverlayFrame* frame = (OverlayFrame*)data;
+    gst_buffer_pool_set_active(frame->pool, FALSE);
+    gst_object_unref(frame->pool);
+    g_free(frame->text);
+    g_free(frame);
+}
 
-    png_bytep* row_pointers = (png_bytep*)g_malloc(sizeof(png_bytep) * height);
-    if (!row_pointers)
+static void release_overlay_glyphs(GstStaticPngSrc* self)
+{
+    for (guint i = 0; i < N_OVERLAY_GLYPHS; ++i)
     {
-        g_free(pixels);
-        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-        fclose(fp);
-        return FALSE;
+        g_free(self->overlay_glyphs[i]);
+        self->overlay_glyphs[i] = NULL;
     }
+}
 
-    for (png_uint_32 y = 0; y < height; ++y)
+/* Frames still in flight keep their memory alive until downstream drops them */
+static void release_overlay(GstStaticPngSrc* self)
+{
+    if (self->overlay_frames != NULL)
     {
-        row_pointers[y] = pixels + y * rowbytes;
+        g_ptr_array_unref(self->overlay_frames);
+        self->overlay_frames = NULL;
     }
+    self->overlay_shown = NULL;
+    release_overlay_glyphs(self);
+    self->overlay_format[0] = '\0';
+}
 
-    png_read_image(png_ptr, row_pointers);
-    png_read_end(png_ptr, NULL);
-
-    g_free(row_pointers);
-    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-    fclose(fp);
+/* The string to show for the frame about to be pushed */
+static gchar* overlay_string(GstStaticPngSrc* self)
+{
+    GST_OBJECT_LOCK(self);
+    gchar* text = g_strdup(self->overlay_text);
+    GST_OBJECT_UNLOCK(self);
 
-    /* Re-pack to tightly-packed RGBA if libpng rowbytes differ from width*4 */
-    if (rowbytes != width * 4)
+    gchar* result = NULL;
+    switch (self->overlay)
     {
-        guint8* tight = (guint8*)g_malloc((gsize)width * height * 4);
-        if (!tight)
+        case STATIC_IMAGE_OVERLAY_TEXT:
         {
-            g_free(pixels);
-            return FALSE;
+            result = g_strdup(text);
+            break;
+        }
+        case STATIC_IMAGE_OVERLAY_CLOCK:
+        {
+            GDateTime* now = g_date_time_new_now_local();
+            result = g_date_time_format(now, text != NULL && text[0] != '\0' ? text : DEFAULT_OVERLAY_CLOCK_FORMAT);
+            g_date_time_unref(now);
+            break;
+        }
+        case STATIC_IMAGE_OVERLAY_FRAME_COUNT:
+        {
+            result = g_strdup_printf("%s%" G_GUINT64_FORMAT, text != NULL ? text : "", self->frame_count);
+            break;
         }
-        for (png_uint_32 y = 0; y < height; ++y)
+        default:
         {
-            memcpy(tight + (gsize)y * (gsize)width * 4, pixels + (gsize)y * (gsize)rowbytes, (gsize)width * 4);
+            break;
         }
-        g_free(pixels);
-        pixels = tight;
     }
-
-    *out_pixels = pixels;
-    *out_w = (gint)width;
-    *out_h = (gint)height;
-    return TRUE;
+    g_free(text);
+    return result != NULL ? result : g_strdup("");
 }
 
-static gboolean decode_jpeg_to_rgba(const gchar* path, guint8** out_pixels, gint* out_w, gint* out_h)
+/* Character c as one cell in the output format, converted the first time it is drawn */
+static const guint8* overlay_glyph(GstStaticPngSrc* self, const OverlayStyle* style, gchar c)
 {
-    *out_pixels = NULL;
-    *out_w = 0;
-    *out_h = 0;
+    const guint8 code = (guint8)c;
+    const guint index = (code >= 0x20 && code < 0x20 + N_OVERLAY_GLYPHS ? code : '?') - 0x20;
+    if (self->overlay_glyphs[index] == NULL)
+    {
+        const gint cell = style->cell;
+        guint8* rgba = (guint8*)g_malloc((gsize)cell * (gsize)cell * 4);
+        static_image_overlay_render_glyph((gchar)(index + 0x20), style->scale, style->color, style->background, rgba);
+        /* Glyphs are not frame builds: left out of the convert stage stats */
+        StaticImageFrameLayout layout;
+        static_image_frame_layout_init(&layout, self->selected_format, cell, cell);
+        self->overlay_glyphs[index] = (guint8*)g_malloc0(layout.size);
+        convert_rgba_into(self, rgba, self->selected_format, &layout, self->overlay_glyphs[index]);
+        g_free(rgba);
+    }
+    return self->overlay_glyphs[index];
+}
 
-    FILE* fp = fopen(path, "rb");
-    if (!fp)
+/* An overlay frame whose buffers are all back, other than the one on screen; a new one if all are in use */
+static OverlayFrame* acquire_overlay_frame(GstStaticPngSrc* self)
+{
+    if (self->overlay_frames == NULL)
     {
-        return FALSE;
+        self->overlay_frames = g_ptr_array_new_with_free_func(overlay_frame_free);
+    }
+    for (guint i = 0; i < self->overlay_frames->len; ++i)
+    {
+        OverlayFrame* frame = (OverlayFrame*)g_ptr_array_index(self->overlay_frames, i);
+        if (frame != self->overlay_shown && static_image_buffer_pool_reclaim_frame(frame->pool))
+        {
+            return frame;
+        }
     }
 
-    struct jpeg_decompress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-    cinfo.err = jpeg_std_error(&jerr);
-    jpeg_create_decompress(&cinfo);
-    jpeg_stdio_src(&cinfo, fp);
+    GstMemory* memory = gst_allocator_alloc(frame_allocator(self), self->frame_layout.size, NULL);
+    if (memory == NULL)
+    {
+        return NULL;
+    }
+    GstBufferPool* pool = static_image_buffer_pool_new();
+    if (pool == NULL)
+    {
+        gst_memory_unref(memory);
+        return NULL;
+    }
+    static_image_buffer_pool_set_frame(pool, memory, gst_video_format_from_string(self->selected_format),
+                                       &self->frame_layout);
+    gst_memory_unref(memory);
+
+    OverlayFrame* frame = g_new0(OverlayFrame, 1);
+    frame->pool = pool;
+    frame->memory = memory;
+    frame->generation = self->overlay_generation - 1; /* background not copied yet */
+    g_ptr_array_add(self->overlay_frames, frame);
+    GST_DEBUG_OBJECT(self, "%u overlay frames", self->overlay_frames->len);
+    return frame;
+}
 
-    if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK)
+/*
+ * Brings frame up to text: cells whose character is unchanged are left alone,
+ * changed ones get their glyph and cells past the end of text get the
+ * background back from shared_mem. A frame last drawn over another
+ * background or with other overlay settings is recopied whole first.
+ */
+static gboolean draw_overlay(GstStaticPngSrc* self, OverlayFrame* frame, const gchar* text, const OverlayStyle* style)
+{
+    const StaticImageFrameLayout* layout = &self->frame_layout;
+    const gint x = style->x;
+    const gint y = style->y;
+    const gint cell = style->cell;
+    const gchar* fmt = self->selected_format;
+
+    StaticImageFrameLayout glyph_layout;
+    GstMapInfo dst_map;
+    GstMapInfo src_map;
+    if (!static_image_frame_layout_init(&glyph_layout, fmt, cell, cell))
     {
-        jpeg_destroy_decompress(&cinfo);
-        fclose(fp);
         return FALSE;
     }
-
-    cinfo.out_color_space = JCS_RGB;
-    if (!jpeg_start_decompress(&cinfo))
+    if (!gst_memory_map(frame->memory, &dst_map, GST_MAP_WRITE))
     {
-        jpeg_destroy_decompress(&cinfo);
-        fclose(fp);
         return FALSE;
     }
-
-    const gint width = (gint)cinfo.output_width;
-    const gint height = (gint)cinfo.output_height;
-    const gint row_rgb_stride = (gint)cinfo.output_width * (gint)cinfo.output_components; /* expect 3 */
-
-    guint8* rgba = (guint8*)g_malloc((gsize)width * (gsize)height * 4);
-    if (rgba == NULL)
+    if (!gst_memory_map(self->shared_mem, &src_map, GST_MAP_READ))
     {
-        jpeg_finish_decompress(&cinfo);
-        jpeg_destroy_decompress(&cinfo);
-        fclose(fp);
+        gst_memory_unmap(frame->memory, &dst_map);
         return FALSE;
     }
 
-    JSAMPARRAY buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE, (JDIMENSION)row_rgb_stride, 1);
-    if (buffer == NULL)
+    if (frame->generation != self->overlay_generation)
     {
-        g_free(rgba);
-        jpeg_finish_decompress(&cinfo);
-        jpeg_destroy_decompress(&cinfo);
-        fclose(fp);
-        return FALSE;
+        memcpy(dst_map.data, src_map.data, MIN(layout->size, src_map.size));
+        g_free(frame->text);
+        frame->text = NULL;
+        frame->generation = self->overlay_generation;
     }
 
-    while (cinfo.output_scanline < cinfo.output_height)
+    const gchar* old = frame->text != NULL ? frame->text : "";
+    const gsize old_len = strlen(old);
+    const gsize new_len = strlen(text);
+    gboolean ok = TRUE;
+    for (gsize i = 0; i < MAX(old_len, new_len); ++i)
     {
-        if (jpeg_read_scanlines(&cinfo, buffer, 1) != 1)
+        const gint cx = x + (gint)i * cell;
+        if (i < new_len)
         {
-            g_free(rgba);
-            jpeg_finish_decompress(&cinfo);
-            jpeg_destroy_decompress(&cinfo);
-            fclose(fp);
-            return FALSE;
+            if (i < old_len && old[i] == text[i])
+            {
+                continue;
+            }
+            const guint8* glyph = overlay_glyph(self, style, text[i]);
+            if (glyph == NULL)
+            {
+                ok = FALSE;
+                break;
+            }
+            static_image_overlay_copy_rect(fmt, dst_map.data, layout, cx, y, glyph, &glyph_layout, 0, 0, cell, cell);
         }
-
-        guint8* dst = rgba + ((gsize)(cinfo.output_scanline - 1) * (gsize)width * 4);
-        guint8* src = buffer[0];
-        for (gint x = 0; x < width; ++x)
+        else
         {
-            dst[x * 4 + 0] = src[x * 3 + 0];
-            dst[x * 4 + 1] = src[x * 3 + 1];
-            dst[x * 4 + 2] = src[x * 3 + 2];
-            dst[x * 4 + 3] = 255;
+            static_image_overlay_copy_rect(fmt, dst_map.data, layout, cx, y, src_map.data, layout, cx, y, cell, cell);
         }
     }
 
-    jpeg_finish_decompress(&cinfo);
-    jpeg_destroy_decompress(&cinfo);
-    fclose(fp);
+    gst_memory_unmap(self->shared_mem, &src_map);
+    gst_memory_unmap(frame->memory, &dst_map);
 
-    *out_pixels = rgba;
-    *out_w = width;
-    *out_h = height;
-    return TRUE;
+    g_free(frame->text);
+    /* After a failure the drawn cells are unknown; a recopy on next use puts the frame right */
+    frame->text = ok ? g_strdup(text) : NULL;
+    if (!ok)
+    {
+        frame->generation = self->overlay_generation - 1;
+    }
+    return ok;
 }
 
-static guint8* scale_rgba_nearest(const guint8* src, gint src_w, gint src_h, gint dst_w, gint dst_h)
+/*
+ * Streaming thread: picks the overlay frame carrying the current overlay text
+ * for create() to hand out buffers of, each frame from its own pool so the
+ * buffers survive the switch. The frame on screen is kept while the text does
+ * not change, so a clock touches memory once a second and a counter only its
+ * changed digits.
+ */
+static void update_overlay(GstStaticPngSrc* self)
 {
-    if (src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0)
+    /*
+     * One snapshot per frame: the setters change these while playing, and
+     * glyph buffers are sized by the cell the glyphs are rendered at. A
+     * snapshot taken after a change always sees overlay_changed set with it.
+     */
+    OverlayStyle style;
+    GST_OBJECT_LOCK(self);
+    const gboolean changed = g_atomic_int_compare_and_exchange(&self->overlay_changed, TRUE, FALSE);
+    /* Whole cells only, at even positions so subsampled chroma is never split */
+    style.x = self->overlay_x & ~1;
+    style.y = self->overlay_y & ~1;
+    style.scale = self->overlay_scale;
+    style.color = self->overlay_color;
+    style.background = self->overlay_background;
+    GST_OBJECT_UNLOCK(self);
+    style.cell = STATIC_IMAGE_OVERLAY_GLYPH_SIZE * (gint)style.scale;
+
+    if (changed)
     {
-        return NULL;
+        release_overlay_glyphs(self);
+        self->overlay_generation++;
     }
-
-    guint8* dst = (guint8*)g_malloc((gsize)dst_w * (gsize)dst_h * 4);
-    if (!dst)
+    if (g_strcmp0(self->overlay_format, self->selected_format) != 0)
     {
-        return NULL;
+        release_overlay(self);
+        g_strlcpy(self->overlay_format, self->selected_format, sizeof(self->overlay_format));
     }
 
-    for (gint y = 0; y < dst_h; ++y)
+    const gint cell = style.cell;
+    const gint x = style.x;
+    const gint y = style.y;
+    gchar* text = overlay_string(self);
+    const gint fit = (x < self->actual_width && y + cell <= self->actual_height) ? (self->actual_width - x) / cell : 0;
+    if ((gint)strlen(text) > fit)
     {
-        gint sy = (gint)((gint64)y * src_h / dst_h);
-        const guint8* src_row = src + (gsize)sy * (gsize)src_w * 4;
-        guint8* dst_row = dst + (gsize)y * (gsize)dst_w * 4;
-
-        for (gint x = 0; x < dst_w; ++x)
-        {
-            gint sx = (gint)((gint64)x * src_w / dst_w);
-            const guint8* sp = src_row + (gsize)sx * 4;
-            guint8* dp = dst_row + (gsize)x * 4;
-
-            dp[0] = sp[0];
-            dp[1] = sp[1];
-            dp[2] = sp[2];
-            dp[3] = sp[3];
-        }
+        text[fit] = '\0';
     }
 
-    return dst;
-}
-
-static void swizzle_from_rgba_inplace(guint8* pixels, gint width, gint height, const gchar* fmt)
-{
-    if (pixels == NULL || fmt == NULL)
+    OverlayFrame* shown = self->overlay_shown;
+    if (shown != NULL && shown->generation == self->overlay_generation && g_strcmp0(shown->text, text) == 0)
     {
+        g_free(text);
         return;
     }
 
-    if (g_strcmp0(fmt, "RGBA") == 0)
+    OverlayFrame* frame = text[0] != '\0' ? acquire_overlay_frame(self) : NULL;
+    if (frame != NULL && draw_overlay(self, frame, text, &style))
     {
-        return;
+        self->overlay_shown = frame;
     }
-
-    const gsize num_pixels = (gsize)width * (gsize)height;
-    for (gsize i = 0; i < num_pixels; ++i)
+    else if (shown != NULL)
     {
-        guint8* p = pixels + i * 4;
-        guint8 r = p[0];
-        guint8 g = p[1];
-        guint8 b = p[2];
-        guint8 a = p[3];
-
-        if (g_strcmp0(fmt, "BGRA") == 0)
-        {
-            p[0] = b;
-            p[1] = g;
-            p[2] = r;
-            p[3] = a;
-        }
-        else if (g_strcmp0(fmt, "ARGB") == 0)
-        {
-            p[0] = a;
-            p[1] = r;
-            p[2] = g;
-            p[3] = b;
-        }
-        else if (g_strcmp0(fmt, "ABGR") == 0)
-        {
-            p[0] = a;
-            p[1] = b;
-            p[2] = g;
-            p[3] = r;
-        }
-        else
-        {
-            /* Unknown requested format, leave as-is */
-        }
+        /* Nothing to draw (or drawing failed): back to the plain frame */
+        self->overlay_shown = NULL;
     }
+    g_free(text);
 }
 
-/* Simple BT.601 conversion, full range, integer math */
-static inline void rgba_to_yuv_bt601(guint8 r, guint8 g, guint8 b, guint8* y, gint16* u_acc, gint16* v_acc)
+static void clear_reloaded_frame(GstStaticPngSrc* self)
 {
-    gint yv = (66 * r + 129 * g + 25 * b + 128) >> 8;  /* 0..255 approx */
-    gint uv = (-38 * r - 74 * g + 112 * b + 128) >> 8; /* -128..127 */
-    gint vv = (112 * r - 94 * g - 18 * b + 128) >> 8;  /* -128..127 */
-    *y = (guint8)CLAMP(yv + 16, 0, 255);
-    *u_acc += (gint16)uv;
-    *v_acc += (gint16)vv;
+    g_mutex_lock(&self->reload_lock);
+    if (self->reloaded.memory != NULL)
+    {
+        gst_memory_unref(self->reloaded.memory);
+    }
+    frame_ring_free(self->reloaded.animation);
+    memset(&self->reloaded, 0, sizeof(self->reloaded));
+    g_atomic_int_set(&self->reload_ready, FALSE);
+    g_mutex_unlock(&self->reload_lock);
 }
 
-static guint8* convert_rgba_to_nv12(const guint8* src, gint width, gint height)
+/* Scales with scale-method and n-threads into a new packed RGBA image */
+static guint8* scale_rgba(GstStaticPngSrc* self, const guint8* src, gint src_w, gint src_h, gint dst_w, gint dst_h)
 {
-    if (src == NULL || width <= 0 || height <= 0)
+    if (src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0)
     {
         return NULL;
     }
 
-    gsize y_size = (gsize)width * (gsize)height;
-    gsize uv_size = y_size / 2;
-    guint8* dst = (guint8*)g_malloc(y_size + uv_size);
-    if (dst == NULL)
+    guint8* dst = (guint8*)g_malloc((gsize)dst_w * (gsize)dst_h * 4);
+    if (!dst)
     {
         return NULL;
     }
 
-    guint8* y_plane = dst;
-    guint8* uv_plane = dst + y_size;
-
-    /* Luma */
-    for (gint y = 0; y < height; ++y)
-    {
-        const guint8* srow = src + (gsize)y * (gsize)width * 4;
-        guint8* drow = y_plane + (gsize)y * (gsize)width;
-        for (gint x = 0; x < width; ++x)
-        {
-            const guint8* sp = srow + (gsize)x * 4;
-            guint8 Y;
-            gint16 u_acc = 0;
-            gint16 v_acc = 0;
-            rgba_to_yuv_bt601(sp[0], sp[1], sp[2], &Y, &u_acc, &v_acc);
-            drow[x] = Y;
-        }
-    }
-
-    /* Chroma (2x2 blocks) */
-    for (gint y = 0; y < height; y += 2)
-    {
-        const guint8* srow0 = src + (gsize)y * (gsize)width * 4;
-        const guint8* srow1 = src + (gsize)(y + 1) * (gsize)width * 4;
-        guint8* uvrow = uv_plane + (gsize)(y / 2) * (gsize)width;
-        for (gint x = 0; x < width; x += 2)
-        {
-            const guint8* p0 = srow0 + (gsize)x * 4;
-            const guint8* p1 = srow0 + (gsize)(x + 1) * 4;
-            const guint8* p2 = srow1 + (gsize)x * 4;
-            const guint8* p3 = srow1 + (gsize)(x + 1) * 4;
-
-            gint u_sum = 0;
-            gint v_sum = 0;
-            guint8 Ytmp;
-            gint16 u_acc;
-            gint16 v_acc;
-
-            u_acc = v_acc = 0;
-            rgba_to_yuv_bt601(p0[0], p0[1], p0[2], &Ytmp, &u_acc, &v_acc);
-            u_sum += u_acc;
-            v_sum += v_acc;
-            u_acc = v_acc = 0;
-            rgba_to_yuv_bt601(p1[0], p1[1], p1[2], &Ytmp, &u_acc, &v_acc);
-            u_sum += u_acc;
-            v_sum += v_acc;
-            u_acc = v_acc = 0;
-            rgba_to_yuv_bt601(p2[0], p2[1], p2[2], &Ytmp, &u_acc, &v_acc);
-            u_sum += u_acc;
-            v_sum += v_acc;
-            u_acc = v_acc = 0;
-            rgba_to_yuv_bt601(p3[0], p3[1], p3[2], &Ytmp, &u_acc, &v_acc);
-            u_sum += u_acc;
-            v_sum += v_acc;
-
-            gint U = (u_sum / 4) + 128;
-            gint V = (v_sum / 4) + 128;
-            if (U < 0)
-                U = 0;
-            if (U > 255)
-                U = 255;
-            if (V < 0)
-                V = 0;
-            if (V > 255)
-                V = 255;
-
-            uvrow[x + 0] = (guint8)U;
-            uvrow[x + 1] = (guint8)V;
-        }
+    const GstClockTime start = gst_util_get_timestamp();
+    if (!static_image_scale_rgba(src, src_w * 4, src_w, src_h, dst, dst_w * 4, dst_w, dst_h, self->scale_method,
+                                 self->n_threads))
+    {
+        g_free(dst);
+        return NULL;
     }
+    static_image_stats_add_stage(&self->stats, STATIC_IMAGE_STAGE_SCALE, gst_util_get_timestamp() - start);
 
     return dst;
 }
 
-static guint8* convert_rgba_to_i420(const guint8* src, gint width, gint height)
+static void swizzle_from_rgba_inplace(guint8* pixels, gint stride, gint width, gint height, const gchar* fmt,
+                                      guint n_threads)
 {
-    if (src == NULL || width <= 0 || height <= 0)
+    if (pixels == NULL || fmt == NULL)
     {
-        return NULL;
+        return;
     }
 
-    gsize y_size = (gsize)width * (gsize)height;
-    gsize uv_plane = y_size / 4;
-    guint8* dst = (guint8*)g_malloc(y_size + uv_plane * 2);
-    if (dst == NULL)
+    /* Source byte (R=0, G=1, B=2, A=3) for each output byte */
+    static const guint8 bgra_order[4] = {2, 1, 0, 3};
+    static const guint8 argb_order[4] = {3, 0, 1, 2};
+    static const guint8 abgr_order[4] = {3, 2, 1, 0};
+
+    const guint8* order = NULL;
+    if (g_strcmp0(fmt, "BGRA") == 0)
     {
-        return NULL;
+        order = bgra_order;
     }
-
-    guint8* y_plane = dst;
-    guint8* u_plane = dst + y_size;
-    guint8* v_plane = u_plane + uv_plane;
-
-    for (gint y = 0; y < height; ++y)
-    {
-        const guint8* srow = src + (gsize)y * (gsize)width * 4;
-        guint8* drow = y_plane + (gsize)y * (gsize)width;
-        for (gint x = 0; x < width; ++x)
-        {
-            const guint8* sp = srow + (gsize)x * 4;
-            guint8 Y;
-            gint16 u_acc = 0;
-            gint16 v_acc = 0;
-            rgba_to_yuv_bt601(sp[0], sp[1], sp[2], &Y, &u_acc, &v_acc);
-            drow[x] = Y;
-        }
-    }
-
-    for (gint y = 0; y < height; y += 2)
-    {
-        const guint8* srow0 = src + (gsize)y * (gsize)width * 4;
-        const guint8* srow1 = src + (gsize)(y + 1) * (gsize)width * 4;
-        guint8* urow = u_plane + (gsize)(y / 2) * (gsize)(width / 2);
-        guint8* vrow = v_plane + (gsize)(y / 2) * (gsize)(width / 2);
-        for (gint x = 0; x < width; x += 2)
-        {
-            const guint8* p0 = srow0 + (gsize)x * 4;
-            const guint8* p1 = srow0 + (gsize)(x + 1) * 4;
-            const guint8* p2 = srow1 + (gsize)x * 4;
-            const guint8* p3 = srow1 + (gsize)(x + 1) * 4;
-
-            gint u_sum = 0;
-            gint v_sum = 0;
-            guint8 Ytmp;
-            gint16 u_acc;
-            gint16 v_acc;
-            u_acc = v_acc = 0;
-            rgba_to_yuv_bt601(p0[0], p0[1], p0[2], &Ytmp, &u_acc, &v_acc);
-            u_sum += u_acc;
-            v_sum += v_acc;
-            u_acc = v_acc = 0;
-            rgba_to_yuv_bt601(p1[0], p1[1], p1[2], &Ytmp, &u_acc, &v_acc);
-            u_sum += u_acc;
-            v_sum += v_acc;
-            u_acc = v_acc = 0;
-            rgba_to_yuv_bt601(p2[0], p2[1], p2[2], &Ytmp, &u_acc, &v_acc);
-            u_sum += u_acc;
-            v_sum += v_acc;
-            u_acc = v_acc = 0;
-            rgba_to_yuv_bt601(p3[0], p3[1], p3[2], &Ytmp, &u_acc, &v_acc);
-            u_sum += u_acc;
-            v_sum += v_acc;
-
-            gint U = (u_sum / 4) + 128;
-            gint V = (v_sum / 4) + 128;
-            if (U < 0)
-                U = 0;
-            if (U > 255)
-                U = 255;
-            if (V < 0)
-                V = 0;
-            if (V > 255)
-                V = 255;
-            urow[x / 2] = (guint8)U;
-            vrow[x / 2] = (guint8)V;
-        }
+    else if (g_strcmp0(fmt, "ARGB") == 0)
+    {
+        order = argb_order;
+    }
+    else if (g_strcmp0(fmt, "ABGR") == 0)
+    {
+        order = abgr_order;
+    }
+    else
+    {
+        /* RGBA or unknown requested format, leave as-is */
+        return;
     }
 
-    return dst;
+    static_image_convert_swizzle(pixels, stride, width, height, order, n_threads);
 }
@@ -0,0 +1,118 @@
+/*
+ * Static Image Source - stage timings and per-frame create() statistics
+ *
+ * Recording is a few additions under an uncontended mutex, so the counters
+ * stay on in production; the structure is only built when someone reads the
+ * stats property or a stats message is due.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimagestats.h"
+
+#include <cstring>
+
+static const gchar* const stage_names[STATIC_IMAGE_N_STAGES] = {"decode", "scale", "convert"};
+
+static void reset_locked(StaticImageStats* stats)
+{
+    memset(stats->stage_count, 0, sizeof(stats->stage_count));
+    memset(stats->stage_total, 0, sizeof(stats->stage_total));
+    memset(stats->stage_max, 0, sizeof(stats->stage_max));
+    stats->first_buffer = GST_CLOCK_TIME_NONE;
+    stats->frames = 0;
+    stats->bytes = 0;
+    stats->create_total = 0;
+    stats->create_max = 0;
+    memset(stats->create_histogram, 0, sizeof(stats->create_histogram));
+}
+
+void static_image_stats_init(StaticImageStats* stats)
+{
+    g_mutex_init(&stats->lock);
+    reset_locked(stats);
+}
+
+void static_image_stats_clear(StaticImageStats* stats)
+{
+    g_mutex_clear(&stats->lock);
+}
+
+void static_image_stats_reset(StaticImageStats* stats)
+{
+    g_mutex_lock(&stats->lock);
+    reset_locked(stats);
+    g_mutex_unlock(&stats->lock);
+}
+
+void static_image_stats_add_stage(StaticImageStats* stats, StaticImageStage stage, GstClockTime elapsed)
+{
+    g_return_if_fail(stage < STATIC_IMAGE_N_STAGES);
+
+    g_mutex_lock(&stats->lock);
+    stats->stage_count[stage]++;
+    stats->stage_total[stage] += elapsed;
+    stats->stage_max[stage] = MAX(stats->stage_max[stage], elapsed);
+    g_mutex_unlock(&stats->lock);
+}
+
+void static_image_stats_set_first_buffer(StaticImageStats* stats, GstClockTime elapsed)
+{
+    g_mutex_lock(&stats->lock);
+    stats->first_buffer = elapsed;
+    g_mutex_unlock(&stats->lock);
+}
+
+void static_image_stats_add_frame(StaticImageStats* stats, GstClockTime latency, gsize bytes)
+{
+    /* g_bit_storage(0) is 1, so sub-microsecond calls need their own case */
+    const gulong us = (gulong)MIN(latency / GST_USECOND, (GstClockTime)G_MAXULONG);
+    const guint bucket = us == 0 ? 0 : MIN(g_bit_storage(us), STATIC_IMAGE_STATS_N_BUCKETS - 1);
+
+    g_mutex_lock(&stats->lock);
+    stats->frames++;
+    stats->bytes += bytes;
+    stats->create_total += latency;
+    stats->create_max = MAX(stats->create_max, latency);
+    stats->create_histogram[bucket]++;
+    g_mutex_unlock(&stats->lock);
+}
+
+GstStructure* static_image_stats_to_structure(StaticImageStats* stats)
+{
+    GstStructure* s = gst_structure_new_empty("staticimagesrc-stats");
+
+    g_mutex_lock(&stats->lock);
+    for (guint i = 0; i < STATIC_IMAGE_N_STAGES; ++i)
+    {
+        gchar* count = g_strdup_printf("%s-count", stage_names[i]);
+        gchar* total = g_strdup_printf("%s-time", stage_names[i]);
+        gchar* max = g_strdup_printf("%s-max", stage_names[i]);
+        gst_structure_set(s, count, G_TYPE_UINT64, stats->stage_count[i], total, G_TYPE_UINT64, stats->stage_total[i],
+                          max, G_TYPE_UINT64, stats->stage_max[i], NULL);
+        g_free(count);
+        g_free(total);
+        g_free(max);
+    }
+
+    const GstClockTime mean = stats->frames > 0 ? stats->create_total / stats->frames : 0;
+    gst_structure_set(s, "first-buffer-latency", G_TYPE_UINT64, stats->first_buffer, "frames", G_TYPE_UINT64,
+                      stats->frames, "bytes", G_TYPE_UINT64, stats->bytes, "create-mean", G_TYPE_UINT64, mean,
+                      "create-max", G_TYPE_UINT64, stats->create_max, NULL);
+
+    GValue histogram = G_VALUE_INIT;
+    g_value_init(&histogram, GST_TYPE_ARRAY);
+    for (guint i = 0; i < STATIC_IMAGE_STATS_N_BUCKETS; ++i)
+    {
+        GValue count = G_VALUE_INIT;
+        g_value_init(&count, G_TYPE_UINT64);
+        g_value_set_uint64(&count, stats->create_histogram[i]);
+        gst_value_array_append_and_take_value(&histogram, &count);
+    }
+    g_mutex_unlock(&stats->lock);
+
+    gst_structure_take_value(s, "create-histogram", &histogram);
+    return s;
+}
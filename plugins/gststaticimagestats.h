@@ -0,0 +1,63 @@
+/*
+ * Static Image Source - stage timings and per-frame create() statistics
+ */
+
+#ifndef __GST_STATIC_IMAGE_STATS_H__
+#define __GST_STATIC_IMAGE_STATS_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* One-time work done to build a frame */
+typedef enum
+{
+    STATIC_IMAGE_STAGE_DECODE, /* includes direct JPEG decode into the output format and low-memory builds */
+    STATIC_IMAGE_STAGE_SCALE,
+    STATIC_IMAGE_STAGE_CONVERT,
+    STATIC_IMAGE_N_STAGES
+} StaticImageStage;
+
+/*
+ * create() latency histogram: bucket 0 counts calls under 1 us, bucket i
+ * those from 2^(i-1) up to 2^i us, and the last one everything slower.
+ */
+#define STATIC_IMAGE_STATS_N_BUCKETS 20
+
+typedef struct
+{
+    GMutex lock;
+    guint64 stage_count[STATIC_IMAGE_N_STAGES];
+    GstClockTime stage_total[STATIC_IMAGE_N_STAGES];
+    GstClockTime stage_max[STATIC_IMAGE_N_STAGES];
+    GstClockTime first_buffer; /* from start() to the first buffer, NONE until then */
+    guint64 frames;
+    guint64 bytes;
+    GstClockTime create_total;
+    GstClockTime create_max;
+    guint64 create_histogram[STATIC_IMAGE_STATS_N_BUCKETS];
+} StaticImageStats;
+
+void static_image_stats_init(StaticImageStats* stats);
+void static_image_stats_clear(StaticImageStats* stats);
+
+/* Zeroes every counter; called when the element starts */
+void static_image_stats_reset(StaticImageStats* stats);
+
+/* Safe from any thread: frames are built by the streaming, watch and prefetch threads */
+void static_image_stats_add_stage(StaticImageStats* stats, StaticImageStage stage, GstClockTime elapsed);
+void static_image_stats_set_first_buffer(StaticImageStats* stats, GstClockTime elapsed);
+void static_image_stats_add_frame(StaticImageStats* stats, GstClockTime latency, gsize bytes);
+
+/*
+ * Snapshot as a "staticimagesrc-stats" structure. Times are in nanoseconds:
+ * <stage>-count, <stage>-time (total) and <stage>-max for decode, scale and
+ * convert; first-buffer-latency; frames and bytes pushed; create-mean,
+ * create-max and create-histogram (an array of STATIC_IMAGE_STATS_N_BUCKETS
+ * counts).
+ */
+GstStructure* static_image_stats_to_structure(StaticImageStats* stats);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_STATS_H__ */
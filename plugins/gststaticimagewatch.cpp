@@ -0,0 +1,213 @@
+/*
+ * Static Image Source - inotify watch of the image file
+ *
+ * The parent directory is watched rather than the file, so replacing the
+ * image with a rename (what most tools and atomic deploys do) is seen as well
+ * as rewriting it in place. A pipe wakes the thread for triggers and shutdown.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gststaticimagewatch.h"
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cstring>
+
+/* A change counts as settled after this long without further events */
+#define WATCH_SETTLE_MS 150
+
+struct _StaticImageWatch
+{
+    gchar* dir;
+    gchar* name;
+    StaticImageWatchFunc func;
+    gpointer user_data;
+
+    gint inotify_fd;
+    gint wake_fds[2];
+    gint stopping;
+    gint triggered;
+    GThread* thread;
+};
+
+/* Drains queued events; returns TRUE if any of them concerns the watched file */
+static gboolean read_events(StaticImageWatch* watch)
+{
+    gboolean relevant = FALSE;
+    gchar buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;)
+    {
+        ssize_t len = read(watch->inotify_fd, buf, sizeof(buf));
+        if (len <= 0)
+        {
+            break;
+        }
+
+        for (gchar* p = buf; p < buf + len;)
+        {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            if ((event->mask & IN_Q_OVERFLOW) != 0 ||
+                (event->len > 0 && strcmp(event->name, watch->name) == 0))
+            {
+                relevant = TRUE;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return relevant;
+}
+
+static void drain_wake(StaticImageWatch* watch)
+{
+    gchar buf[64];
+    while (read(watch->wake_fds[0], buf, sizeof(buf)) > 0)
+    {
+    }
+}
+
+static gpointer watch_thread_func(gpointer data)
+{
+    StaticImageWatch* watch = (StaticImageWatch*)data;
+    gboolean pending = FALSE;
+
+    while (!g_atomic_int_get(&watch->stopping))
+    {
+        struct pollfd fds[2];
+        fds[0].fd = watch->inotify_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = watch->wake_fds[0];
+        fds[1].events = POLLIN;
+
+        /* While a change is pending, wait only for it to settle */
+        gint ret = poll(fds, 2, pending ? WATCH_SETTLE_MS : -1);
+        if (ret < 0)
+        {
+            continue;
+        }
+
+        if ((fds[1].revents & POLLIN) != 0)
+        {
+            drain_wake(watch);
+        }
+        if ((fds[0].revents & POLLIN) != 0 && read_events(watch))
+        {
+            pending = TRUE;
+            continue;
+        }
+
+        if (g_atomic_int_get(&watch->stopping))
+        {
+            break;
+        }
+        if (g_atomic_int_compare_and_exchange(&watch->triggered, TRUE, FALSE) || (pending && ret == 0))
+        {
+            pending = FALSE;
+            watch->func(watch->user_data);
+        }
+    }
+    return NULL;
+}
+
+static void wake(StaticImageWatch* watch)
+{
+    const gchar byte = 0;
+    ssize_t ret = write(watch->wake_fds[1], &byte, 1);
+    (void)ret;
+}
+
+StaticImageWatch* static_image_watch_new(const gchar* path, StaticImageWatchFunc func, gpointer user_data)
+{
+    g_return_val_if_fail(path != NULL && func != NULL, NULL);
+
+    StaticImageWatch* watch = g_new0(StaticImageWatch, 1);
+    watch->dir = g_path_get_dirname(path);
+    watch->name = g_path_get_basename(path);
+    watch->func = func;
+    watch->user_data = user_data;
+    watch->wake_fds[0] = -1;
+    watch->wake_fds[1] = -1;
+
+    watch->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch->inotify_fd < 0 ||
+        inotify_add_watch(watch->inotify_fd, watch->dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0 ||
+        pipe2(watch->wake_fds, O_NONBLOCK | O_CLOEXEC) != 0)
+    {
+        static_image_watch_free(watch);
+        return NULL;
+    }
+
+    watch->thread = g_thread_try_new("staticimagewatch", watch_thread_func, watch, NULL);
+    if (watch->thread == NULL)
+    {
+        static_image_watch_free(watch);
+        return NULL;
+    }
+    return watch;
+}
+
+void static_image_watch_trigger(StaticImageWatch* watch)
+{
+    g_return_if_fail(watch != NULL);
+
+    g_atomic_int_set(&watch->triggered, TRUE);
+    wake(watch);
+}
+
+void static_image_watch_free(StaticImageWatch* watch)
+{
+    if (watch == NULL)
+    {
+        return;
+    }
+
+    if (watch->thread != NULL)
+    {
+        g_atomic_int_set(&watch->stopping, TRUE);
+        wake(watch);
+        g_thread_join(watch->thread);
+    }
+    if (watch->inotify_fd >= 0)
+    {
+        close(watch->inotify_fd);
+    }
+    for (gint i = 0; i < 2; ++i)
+    {
+        if (watch->wake_fds[i] >= 0)
+        {
+            close(watch->wake_fds[i]);
+        }
+    }
+    g_free(watch->dir);
+    g_free(watch->name);
+    g_free(watch);
+}
+
+#else /* !HAVE_SYS_INOTIFY_H */
+
+StaticImageWatch* static_image_watch_new(const gchar* path, StaticImageWatchFunc func, gpointer user_data)
+{
+    (void)path;
+    (void)func;
+    (void)user_data;
+    return NULL;
+}
+
+void static_image_watch_trigger(StaticImageWatch* watch)
+{
+    (void)watch;
+}
+
+void static_image_watch_free(StaticImageWatch* watch)
+{
+    (void)watch;
+}
+
+#endif
@@ -0,0 +1,34 @@
+/*
+ * Static Image Source - inotify watch of the image file
+ */
+
+#ifndef __GST_STATIC_IMAGE_WATCH_H__
+#define __GST_STATIC_IMAGE_WATCH_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _StaticImageWatch StaticImageWatch;
+
+/* Called on the watch thread once a change has settled */
+typedef void (*StaticImageWatchFunc)(gpointer user_data);
+
+/*
+ * Starts a thread that calls func whenever path is rewritten in place or
+ * replaced by a rename into its directory. Bursts of events are coalesced
+ * until the file has been quiet for a short while, and func never runs
+ * concurrently with itself. Returns NULL if inotify is unavailable or the
+ * directory cannot be watched.
+ */
+StaticImageWatch* static_image_watch_new(const gchar* path, StaticImageWatchFunc func, gpointer user_data);
+
+/* Makes the watch thread call func again, as if the file had changed */
+void static_image_watch_trigger(StaticImageWatch* watch);
+
+/* Stops the thread, waiting for a running func to return */
+void static_image_watch_free(StaticImageWatch* watch);
+
+G_END_DECLS
+
+#endif /* __GST_STATIC_IMAGE_WATCH_H__ */